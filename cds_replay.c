@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_filter.h"
+
+// 조도 변화 기록(cds_trace.txt)을 여러 샘플링 설정으로 재생하여
+// 버스 사용량(샘플 수)과 반응 지연을 비교하는 도구
+// 기준은 기록 주기 그대로 같은 필터를 돌린 결과의 상태 변화 시점
+
+#define MAX_TRACE_SAMPLES 2000000
+#define MAX_EVENTS 4096
+#define I2C_TX_PER_SAMPLE 3          // 단일 채널 읽기 = 쓰기 1 + 읽기 2
+
+typedef struct {
+    double t_ms;
+    int state;
+} event_t;
+
+typedef struct {
+    const char* name;
+    int fixed_hz;                    // 고정 주기 (0 이면 적응형)
+    int min_hz;
+    int max_hz;
+} replay_cfg_t;
+
+static long long* trace_t;
+static int* trace_v;
+static int trace_n = 0;
+static int trace_hz = 100, threshold = 180, band = 8;
+
+static int load_trace(const char* path) {
+    FILE* fp = fopen(path, "r");
+    char line[128];
+    if (!fp) {
+        fprintf(stderr, "[REPLAY] 기록 파일 열기 실패: %s\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp) && trace_n < MAX_TRACE_SAMPLES) {
+        if (line[0] == '#') {
+            char* p;
+            if ((p = strstr(line, "hz="))) trace_hz = atoi(p + 3);
+            if ((p = strstr(line, "threshold="))) threshold = atoi(p + 10);
+            if ((p = strstr(line, "band="))) band = atoi(p + 5);
+            continue;
+        }
+        if (sscanf(line, "%lld %d", &trace_t[trace_n], &trace_v[trace_n]) == 2) {
+            trace_n++;
+        }
+    }
+    fclose(fp);
+    return trace_n > 0 ? 0 : -1;
+}
+
+// 합성 파형 (실측 아님): 100Hz 10분, 잡음 ±2
+static void make_synthetic(void) {
+    unsigned int seed = 12345;
+    trace_hz = 100;
+    for (int i = 0; i < 600 * trace_hz; i++) {
+        double t = (double)i / trace_hz;
+        int v = 120;
+        if (t >= 60 && t < 150) v = 220;                                 // 스위치 off
+        else if (t >= 200 && t < 320) v = 120 + (int)((t - 200) * 110 / 120);  // 해질녘
+        else if (t >= 320 && t < 400) v = 230;
+        else if (t >= 470 && t < 472) v = 205;                           // 2초 그림자
+        else if (t >= 500) v = (i / 250) % 2 ? 184 : 176;                // 임계값 근처 흔들림
+        if (i % (37 * trace_hz) == 0 && i > 0) v = 255;                  // 한 샘플 튐
+
+        seed = seed * 1103515245u + 12345u;
+        v += (int)((seed >> 16) % 5) - 2;
+        if (v < 0) v = 0;
+        if (v > 255) v = 255;
+
+        trace_t[trace_n] = (long long)i * 1000 / trace_hz;
+        trace_v[trace_n] = v;
+        trace_n++;
+    }
+}
+
+// 설정 하나로 기록을 재생: 샘플링 시점의 값(직전 기록값 유지)을 필터에 넣고 상태 변화를 모음
+static int replay(const replay_cfg_t* cfg, event_t* events, long* samples) {
+    sensor_filter_cfg_t fcfg = {threshold, band, cfg->fixed_hz ? 0 : cfg->min_hz, cfg->max_hz};
+    sensor_filter_t filter;
+    int count = 0, idx = 0;
+    double t = 0, end = trace_t[trace_n - 1];
+
+    sensor_filter_init(&filter, -1, cfg->fixed_hz ? cfg->fixed_hz : cfg->max_hz);
+    *samples = 0;
+    while (t <= end) {
+        while (idx + 1 < trace_n && trace_t[idx + 1] <= t) idx++;
+
+        int previous = filter.bright;
+        sensor_filter_step(&filter, trace_v[idx], &fcfg);
+        (*samples)++;
+        if (previous >= 0 && filter.bright != previous && count < MAX_EVENTS) {
+            events[count].t_ms = t;
+            events[count].state = filter.bright;
+            count++;
+        }
+        t += 1000.0 / (cfg->fixed_hz ? cfg->fixed_hz : filter.hz);
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    static event_t reference[MAX_EVENTS], detected[MAX_EVENTS];
+    const char* path = argc > 1 ? argv[1] : "cds_trace.txt";
+
+    trace_t = malloc(sizeof(*trace_t) * MAX_TRACE_SAMPLES);
+    trace_v = malloc(sizeof(*trace_v) * MAX_TRACE_SAMPLES);
+    if (!trace_t || !trace_v) return 1;
+
+    if (strcmp(path, "--synthetic") == 0) {
+        make_synthetic();
+        printf("입력: 합성 파형 (실측 아님)\n");
+    } else if (load_trace(path) < 0) {
+        printf("사용법: %s [cds_trace.txt | --synthetic]\n", argv[0]);
+        printf("  기록: 서버에서 CDS_TRACE_RECORD <초> [hz]\n");
+        return 1;
+    } else {
+        printf("입력: %s\n", path);
+    }
+
+    double seconds = trace_t[trace_n - 1] / 1000.0;
+    printf("샘플 %d개, %.1f초, 기록 %dHz, 히스테리시스 %d±%d\n\n", trace_n, seconds, trace_hz, threshold, band);
+
+    replay_cfg_t ref_cfg = {"기준", trace_hz, 0, trace_hz};
+    long ref_samples;
+    int ref_count = replay(&ref_cfg, reference, &ref_samples);
+    printf("기준 (기록 주기 %dHz) 상태 변화 %d회\n\n", trace_hz, ref_count);
+
+    const replay_cfg_t configs[] = {
+        {"고정 1Hz", 1, 0, 1},
+        {"고정 2Hz", 2, 0, 2},
+        {"고정 5Hz", 5, 0, 5},
+        {"고정 10Hz", 10, 0, 10},
+        {"고정 20Hz", 20, 0, 20},
+        {"고정 50Hz", 50, 0, 50},
+        {"적응형 1-50Hz", 0, 1, 50},
+        {"적응형 2-50Hz", 0, 2, 50},
+        {"적응형 5-50Hz", 0, 5, 50},
+        {"적응형 2-20Hz", 0, 2, 20},
+    };
+
+    printf("%-16s %9s %9s %10s %10s %10s %6s %6s\n",
+           "설정", "샘플", "샘플/s", "I2C tx/s", "평균지연ms", "최대지연ms", "놓침", "오탐");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        long samples;
+        int count = replay(&configs[c], detected, &samples);
+        int matched = 0, missed = 0, next = 0;
+        double total_latency = 0, max_latency = 0;
+
+        // 기준 변화마다 다음 기준 변화 전까지 같은 상태로 바뀐 첫 감지를 찾음
+        for (int r = 0; r < ref_count; r++) {
+            double limit = r + 1 < ref_count ? reference[r + 1].t_ms : seconds * 1000.0 + 1;
+            while (next < count && detected[next].t_ms < reference[r].t_ms - 1000.0 / trace_hz) next++;
+            if (next < count && detected[next].t_ms < limit && detected[next].state == reference[r].state) {
+                double latency = detected[next].t_ms - reference[r].t_ms;
+                if (latency < 0) latency = 0;
+                total_latency += latency;
+                if (latency > max_latency) max_latency = latency;
+                matched++;
+                next++;
+            } else {
+                missed++;
+            }
+        }
+
+        printf("%-16s %9ld %9.2f %10.2f %10.0f %10.0f %6d %6d\n", configs[c].name, samples, samples / seconds,
+               samples * I2C_TX_PER_SAMPLE / seconds, matched ? total_latency / matched : 0.0, max_latency,
+               missed, count - matched);
+    }
+
+    free(trace_t);
+    free(trace_v);
+    return 0;
+}
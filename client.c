@@ -1,17 +1,33 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <errno.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 
 #define BUFFER_SIZE 1024
+#define RESPONSE_SIZE 4096
+#define READ_BUFFER_SIZE 8192
 #define DEFAULT_PORT 8080
+#define DEFAULT_WINDOW 32    // 응답을 기다리지 않고 보내 둘 명령 수
+#define MAX_WINDOW 256
 
 static volatile int running = 1;
 
+// 서버 연결: 한 번 연결해 계속 사용, 수신은 줄 단위
+typedef struct {
+    int fd;
+    int greeted;                 // "연결완료" 인사를 읽었는지 (서버는 첫 명령을 받은 뒤 보냄)
+    char buf[READ_BUFFER_SIZE];
+    int start, end;
+} server_conn_t;
+
 // 시그널 핸들러 (SIGINT만 처리)
 void signal_handler(int sig) {
     if (sig == SIGINT) {
@@ -32,98 +48,282 @@ void setup_signals(void) {
 
 // 사용법 출력
 void print_usage(char* program_name) {
-    printf("사용법: %s <서버IP> [포트]\n", program_name);
+    printf("사용법: %s <서버IP> [포트] [-f <파일|->] [-w <개수>] [-q]\n", program_name);
+    printf("  -f: 파일(- 는 표준 입력)의 명령을 응답을 기다리지 않고 이어 보냄 (한 줄에 명령 하나, # 주석)\n");
+    printf("  -w: 응답을 기다리지 않고 보내 둘 최대 명령 수 (기본 %d)\n", DEFAULT_WINDOW);
+    printf("  -q: 오류 응답과 요약만 출력\n");
     printf("예시: %s 192.168.0.84\n", program_name);
     printf("     %s 192.168.0.84 8080\n", program_name);
+    printf("     %s 192.168.0.84 -f commands.txt\n", program_name);
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
 }
 
-// 대화형 모드
+static int connect_server(server_conn_t* conn, const char* server_ip, int port) {
+    struct sockaddr_in server_addr;
+    int opt = 1;
+
+    conn->fd = -1;
+    conn->greeted = 0;
+    conn->start = conn->end = 0;
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, server_ip, &server_addr.sin_addr) <= 0) {
+        printf("잘못된 IP\n");
+        return -1;
+    }
+
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        printf("소켓 생성 실패\n");
+        return -1;
+    }
+    if (connect(sockfd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        printf("연결 실패: %s\n", strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    conn->fd = sockfd;
+    return 0;
+}
+
+static void close_server(server_conn_t* conn) {
+    if (conn->fd >= 0) close(conn->fd);
+    conn->fd = -1;
+}
+
+static int send_all(int fd, const char* buf, int len) {
+    while (len > 0) {
+        int sent = send(fd, buf, len, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return -1;
+        buf += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+// 한 줄 읽기 (줄바꿈 제외), 연결이 끊기면 -1
+static int read_line(server_conn_t* conn, char* line, int size) {
+    for (;;) {
+        char* newline = memchr(conn->buf + conn->start, '\n', conn->end - conn->start);
+        if (newline) {
+            int len = newline - (conn->buf + conn->start);
+            int copy = len < size - 1 ? len : size - 1;
+            memcpy(line, conn->buf + conn->start, copy);
+            line[copy] = '\0';
+            conn->start += len + 1;
+            return copy;
+        }
+        if (conn->start > 0) {
+            memmove(conn->buf, conn->buf + conn->start, conn->end - conn->start);
+            conn->end -= conn->start;
+            conn->start = 0;
+        }
+        if (conn->end == READ_BUFFER_SIZE) {
+            conn->end = 0;   // 줄이 버퍼보다 길면 앞부분은 버림
+        }
+        int bytes_received = recv(conn->fd, conn->buf + conn->end, READ_BUFFER_SIZE - conn->end, 0);
+        if (bytes_received < 0 && errno == EINTR) continue;
+        if (bytes_received <= 0) return -1;
+        conn->end += bytes_received;
+    }
+}
+
+// 응답 하나 읽기 (빈 줄까지, 여러 줄이면 줄바꿈으로 이어 붙임), 연결이 끊기면 -1
+static int read_response(server_conn_t* conn, char* resp, int size) {
+    char line[RESPONSE_SIZE];
+    int len = 0;
+
+    if (!conn->greeted) {
+        if (read_line(conn, line, sizeof(line)) < 0) return -1;
+        conn->greeted = 1;
+    }
+    resp[0] = '\0';
+    for (;;) {
+        if (read_line(conn, line, sizeof(line)) < 0) return -1;
+        if (line[0] == '\0') return len;
+        if (len < size - 1) {
+            len += snprintf(resp + len, size - len, "%s%s", len > 0 ? "\n" : "", line);
+            if (len >= size) len = size - 1;
+        }
+    }
+}
+
+// 대화형 모드: 연결 하나를 유지하며 명령마다 응답을 기다림 (끊기면 다음 명령 때 다시 연결)
 void interactive_mode(char* server_ip, int port) {
-    printf("명령어 입력 (HELP: 도움말, Ctrl+C: 종료)\n");
-    
+    server_conn_t conn = {.fd = -1};
     char command[BUFFER_SIZE];
-    
+    char response[RESPONSE_SIZE];
+
+    printf("명령어 입력 (HELP: 도움말, Ctrl+C: 종료)\n");
+
     while (running) {
         printf("> ");
         fflush(stdout);
-        
-        if (fgets(command, sizeof(command), stdin) == NULL) break;
-        
-        command[strcspn(command, "\n")] = 0;
+
+        if (fgets(command, sizeof(command) - 1, stdin) == NULL) break;
+
+        command[strcspn(command, "\r\n")] = 0;
         if (strlen(command) == 0) continue;
-        
+
         if (strcmp(command, "quit") == 0 || strcmp(command, "q") == 0) {
             printf("종료\n");
             break;
         }
-        
-        // 서버에 명령 전송
-        int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (sockfd < 0) {
-            printf("소켓 생성 실패\n");
-            continue;
+
+        // 끊긴 연결은 한 번만 다시 시도
+        strcat(command, "\n");
+        int sent = -1;
+        for (int attempt = 0; attempt < 2 && sent < 0; attempt++) {
+            if (conn.fd < 0 && connect_server(&conn, server_ip, port) < 0) break;
+            sent = send_all(conn.fd, command, strlen(command));
+            if (sent < 0) close_server(&conn);
         }
-        
-        struct sockaddr_in server_addr;
-        memset(&server_addr, 0, sizeof(server_addr));
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(port);
-        
-        if (inet_pton(AF_INET, server_ip, &server_addr.sin_addr) <= 0) {
-            printf("잘못된 IP\n");
-            close(sockfd);
+        if (sent < 0) {
+            printf("전송 실패\n");
             continue;
         }
-        
-        if (connect(sockfd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-            printf("연결 실패\n");
-            close(sockfd);
+
+        if (read_response(&conn, response, sizeof(response)) < 0) {
+            printf(strncmp(command, "QUIT", 4) == 0 ? "서버 종료됨\n" : "연결 끊김\n");
+            close_server(&conn);
             continue;
         }
-        
-        if (send(sockfd, command, strlen(command), 0) < 0) {
-            printf("전송 실패\n");
-            close(sockfd);
-            continue;
+        printf("%s\n", response);
+    }
+    close_server(&conn);
+}
+
+// 일괄 모드: 명령을 최대 window 개까지 응답을 기다리지 않고 보내고, 응답은 보낸 순서대로 짝지음
+int batch_mode(char* server_ip, int port, FILE* input, int window, int quiet) {
+    static char pending[MAX_WINDOW][BUFFER_SIZE];   // 응답을 기다리는 명령 (원형)
+    server_conn_t conn;
+    char line[BUFFER_SIZE];
+    static char out[MAX_WINDOW * BUFFER_SIZE];
+    char response[RESPONSE_SIZE];
+    int head = 0, inflight = 0, eof = 0, quit_sent = 0;
+    long total = 0, errors = 0;
+
+    if (connect_server(&conn, server_ip, port) < 0) return 1;
+    long long start = now_ms();
+
+    while (running && (inflight > 0 || (!eof && !quit_sent))) {
+        // 창이 찰 때까지 명령을 모아 한 번에 전송
+        int out_len = 0;
+        while (!eof && !quit_sent && inflight < window) {
+            if (fgets(line, sizeof(line) - 1, input) == NULL) {
+                eof = 1;
+                break;
+            }
+            line[strcspn(line, "\r\n")] = 0;
+            char* cmd = line;
+            while (*cmd == ' ' || *cmd == '\t') cmd++;
+            if (*cmd == '\0' || *cmd == '#') continue;
+
+            strcpy(pending[(head + inflight) % MAX_WINDOW], cmd);
+            inflight++;
+            out_len += sprintf(out + out_len, "%s\n", cmd);
+            if (strcmp(cmd, "QUIT") == 0) quit_sent = 1;   // 서버는 응답 없이 연결을 닫음
         }
-        
-        char buffer[BUFFER_SIZE] = {0};
-        int bytes_received = read(sockfd, buffer, BUFFER_SIZE - 1);
-        if (bytes_received > 0) {
-            printf("%s", buffer);
+        if (out_len > 0 && send_all(conn.fd, out, out_len) < 0) {
+            fprintf(stderr, "전송 실패: %s\n", strerror(errno));
+            break;
         }
-        
-        close(sockfd);
+        if (inflight == 0) continue;
+
+        // 가장 오래된 명령의 응답 하나를 받고 다시 채움
+        const char* cmd = pending[head];
+        if (read_response(&conn, response, sizeof(response)) < 0) {
+            if (strcmp(cmd, "QUIT") == 0) {
+                inflight = 0;
+                break;
+            }
+            fprintf(stderr, "연결 끊김 (응답 대기 %d개)\n", inflight);
+            errors += inflight;
+            total += inflight;
+            inflight = 0;
+            break;
+        }
+        int failed = strncmp(response, "ERROR", 5) == 0;
+        if (!quiet || failed) printf("%s -> %s\n", cmd, response);
+        errors += failed;
+        total++;
+        head = (head + 1) % MAX_WINDOW;
+        inflight--;
     }
+
+    long long elapsed = now_ms() - start;
+    close_server(&conn);
+    fflush(stdout);
+    fprintf(stderr, "명령 %ld개, 오류 %ld개, %lldms (%.0f 명령/s, 동시 %d개)\n", total, errors, elapsed,
+            elapsed > 0 ? total * 1000.0 / elapsed : 0.0, window);
+    return errors > 0 ? 1 : 0;
 }
 
 int main(int argc, char *argv[]) {
-    char* server_ip;
+    char* server_ip = NULL;
+    char* input_path = NULL;
     int port = DEFAULT_PORT;
-    
+    int window = DEFAULT_WINDOW;
+    int quiet = 0;
+
     // 시그널 설정
     setup_signals();
-    
+
     if (argc < 2) {
         print_usage(argv[0]);
         return 1;
     }
-    
+
     if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
         print_usage(argv[0]);
         return 0;
     }
-    
+
     server_ip = argv[1];
-    
-    if (argc >= 3) {
-        port = atoi(argv[2]);
-        if (port <= 0 || port > 65535) {
-            printf("잘못된 포트 번호\n");
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            window = atoi(argv[++i]);
+            if (window < 1 || window > MAX_WINDOW) {
+                printf("잘못된 창 크기 (1-%d)\n", MAX_WINDOW);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (argv[i][0] != '-') {
+            port = atoi(argv[i]);
+            if (port <= 0 || port > 65535) {
+                printf("잘못된 포트 번호\n");
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (input_path) {
+        FILE* input = strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "r");
+        if (!input) {
+            printf("파일 열기 실패: %s\n", input_path);
             return 1;
         }
+        int ret = batch_mode(server_ip, port, input, window, quiet);
+        if (input != stdin) fclose(input);
+        return ret;
     }
-    
+
     interactive_mode(server_ip, port);
     return 0;
 }
@@ -5,20 +5,92 @@
 
 // 공통 정의
 #define BUFFER_SIZE 1024
-#define MAX_RESPONSE_SIZE 512
+#define MAX_RESPONSE_SIZE 2048
+
+// 신호 통지 콜백 (규칙 엔진으로 상태 값 전달, 값이 바뀔 때 호출)
+typedef void (*signal_hook_fn)(const char* name, int value);
+
+// 장치 이벤트 (이벤트 버스로 발행, 구독자는 종류별 비트마스크로 선택)
+enum {
+    EVENT_COUNTDOWN_TICK = 0,   // value = 남은 카운트
+    EVENT_COUNTDOWN_FINISHED,   // 카운트다운이 0 에 도달
+    EVENT_CDS_DARK,             // 어둠으로 바뀜, value = 필터값
+    EVENT_CDS_BRIGHT,           // 밝음으로 바뀜, value = 필터값
+    EVENT_USER,                 // EVENT_PUBLISH 명령 등 외부 발행
+    EVENT_TYPE_COUNT
+};
+#define EVENT_MASK(type) (1u << (type))
+#define EVENT_MASK_ALL ((1u << EVENT_TYPE_COUNT) - 1)
+
+typedef struct {
+    int type;
+    int value;
+    long long ts_ns;            // 발행 시각 (CLOCK_MONOTONIC)
+    unsigned long seq;          // 버스 전체 발행 순번
+} device_event_t;
+
+// 이벤트 발행 함수 (main 이 라이브러리에 전달), 전달한 구독자 수 반환
+typedef int (*event_publish_fn)(int type, int value);
+
+#ifdef LOCK_STATS
+#include "lock_stats.h"
+#endif
+
+// 장치 소유: 서버에서 장치를 쓰는 명령(TCP/웹/규칙/예약/이벤트 구독자)은 장치마다 하나인 장치 스레드에서만
+// 라이브러리 함수를 부름 (device_actor.h, 값/상태 조회는 호출자 스레드), 아래 라이브러리 내부 스레드만 예외로 장치를 직접 다룸
+//   - LED 타이머 (페이드, 패턴 단계)         libled.c
+//   - 부저 재생 워커 (대기열 재생, 톤 출력)   libbuzzer.c
+//   - 조도 샘플러 (주기 읽기), 자동 LED 스레드 libcds.c
+//   - 카운트다운 스레드 (표시 갱신, 이벤트 발행) libsegment.c
+// 예외 스레드와 장치 스레드가 같은 상태를 만지므로 라이브러리 상태는 device_state_t 잠금으로 보호
 
 // 디바이스 상태 구조체
 typedef struct {
     int is_initialized;
     pthread_mutex_t mutex;
+#ifdef LOCK_STATS
+    lock_stats_t lock_stats;
+#endif
 } device_state_t;
 
+// 장치 잠금: 기본 빌드는 pthread 그대로, make LOCK_STATS=1 이면 획득/경합 횟수와 대기/보유 시간 분포,
+// 가장 오래 잡은 위치를 기록 (LOCKSTATS 명령으로 조회)
+// 잠금을 잡은 채 조건 변수를 기다릴 때는 device_cond_wait/device_cond_timedwait 를 써야 보유 시간이 맞음
+#ifdef LOCK_STATS
+#define DEVICE_STATE_INITIALIZER(name) {0, PTHREAD_MUTEX_INITIALIZER, {name}}
+#define device_lock_at(state, site, line) lock_stats_lock(&(state)->mutex, &(state)->lock_stats, site, line)
+#define device_lock(state) device_lock_at(state, __func__, __LINE__)
+#define device_unlock(state) lock_stats_unlock(&(state)->mutex, &(state)->lock_stats)
+#define device_cond_wait(cond, state) \
+    (lock_stats_release(&(state)->lock_stats), \
+     lock_stats_rewait(&(state)->lock_stats, __func__, __LINE__, pthread_cond_wait(cond, &(state)->mutex)))
+#define device_cond_timedwait(cond, state, deadline) \
+    (lock_stats_release(&(state)->lock_stats), \
+     lock_stats_rewait(&(state)->lock_stats, __func__, __LINE__, dev_cond_timedwait(cond, &(state)->mutex, deadline)))
+#define device_lock_report(state, reset, buf, size) \
+    lock_stats_format(&(state)->mutex, &(state)->lock_stats, reset, buf, size)
+#else
+#define DEVICE_STATE_INITIALIZER(name) {0, PTHREAD_MUTEX_INITIALIZER}
+#define device_lock_at(state, site, line) pthread_mutex_lock(&(state)->mutex)
+#define device_lock(state) pthread_mutex_lock(&(state)->mutex)
+#define device_unlock(state) pthread_mutex_unlock(&(state)->mutex)
+#define device_cond_wait(cond, state) pthread_cond_wait(cond, &(state)->mutex)
+#define device_cond_timedwait(cond, state, deadline) dev_cond_timedwait(cond, &(state)->mutex, deadline)
+#define device_lock_report(state, reset, buf, size) (-1)
+#endif
+
 // LED 함수 포인터 구조체
 typedef struct {
     int (*init)(void);
     int (*on)(void);
     int (*off)(void);
     int (*brightness)(int level);
+    int (*set_percent)(int percent);
+    int (*fade)(int target_percent, int duration_ms);
+    int (*pattern_start)(int pin, const char* desc);
+    int (*pattern_stop)(int pin);
+    int (*pattern_stats)(char* status_buf, int buf_size);
+    int (*lock_stats)(char* buf, int size, int reset);
     void (*cleanup)(void);
     int (*get_status)(char* status_buf, int buf_size);
 } led_functions_t;
@@ -30,19 +102,66 @@ typedef struct {
     int (*countdown)(int start_num);
     int (*stop)(void);
     void (*off)(void);
+    void (*set_signal_hook)(signal_hook_fn hook);
+    void (*set_event_publisher)(event_publish_fn publish);
+    int (*lock_stats)(char* buf, int size, int reset);
     void (*cleanup)(void);
     int (*get_status)(char* status_buf, int buf_size);
 } segment_functions_t;
 
+// 부저 재생 우선순위 (높을수록 먼저, 높은 우선순위가 낮은 것을 선점)
+enum {
+    BUZZER_PRIO_CLICK = 0,      // UI 클릭음
+    BUZZER_PRIO_NOTIFY = 1,     // 알림 (BUZZER_PLAY 기본값)
+    BUZZER_PRIO_ALARM = 2       // 알람 (카운트다운 종료 등)
+};
+
 // 부저 함수 포인터 구조체
 typedef struct {
     int (*init)(void);
     int (*play)(void);
+    int (*submit)(const char* spec, int priority);
+    int (*play_melody)(const char* spec);
+    int (*list_melodies)(char* buf, int buf_size);
+    int (*set_backend)(const char* name);
+    int (*backend_stats)(char* buf, int buf_size);
     int (*stop)(void);
+    int (*lock_stats)(char* buf, int size, int reset);
     void (*cleanup)(void);
     int (*get_status)(char* status_buf, int buf_size);
 } buzzer_functions_t;
 
+// 조도센서 샘플 (샘플러 링 버퍼 항목)
+typedef struct {
+    unsigned long seq;          // 기록 순번 + 1 (0 = 기록 중)
+    long long ts_ms;            // CLOCK_MONOTONIC 기준 ms
+    int raw;                    // ADC 원시값
+    int filtered;               // 중앙값 + EMA 필터 결과
+} cds_sample_t;
+
+// 조도 이력 레코드 (mmap 저장소의 고정 크기 16바이트 항목, 집계 단계에서는 구간의 최소/최대/평균)
+typedef struct {
+    unsigned int seq;           // 단계별 기록 순번 하위 32비트 (덮어쓰기 감지용)
+    unsigned int ts_s;          // 구간 시작 시각 (epoch 초)
+    unsigned short ts_ms;       // 구간 시작 시각의 ms 부분
+    short min;
+    short max;
+    short avg;
+} sensor_record_t;
+
+// 이력 단계 (raw = 샘플마다, 나머지는 구간 집계)
+enum {
+    CDS_TIER_AUTO = -1,
+    CDS_TIER_RAW = 0,
+    CDS_TIER_1S,
+    CDS_TIER_1M,
+    CDS_TIER_1H,
+    CDS_TIER_COUNT
+};
+
+// 이력 조회 콜백: 매핑된 레코드를 복사 없이 전달, 0 이 아니면 조회 중단
+typedef int (*sensor_visit_fn)(const sensor_record_t* rec, void* ctx);
+
 // 조도센서 함수 포인터 구조체
 typedef struct {
     int (*init)(void);
@@ -53,6 +172,24 @@ typedef struct {
     int (*auto_led_stop)(void);
     int (*manual_on)(void);
     int (*manual_off)(void);
+    int (*sampler_start)(int hz);
+    int (*sampler_stop)(void);
+    int (*set_hysteresis)(int threshold, int band);
+    int (*ring_read)(cds_sample_t* out, int max);
+    int (*read_cached)(int maxage_ms, int* value, int* bright);
+    int (*cache_stats)(char* buf, int size);
+    int (*set_scan_mode)(int enable);
+    int (*sensor_name)(int channel, const char* name);
+    int (*sensor_read)(const char* name, int maxage_ms, int* value);
+    int (*sensor_list)(int maxage_ms, char* buf, int size);
+    int (*history_query)(long long from_ms, long long to_ms, int* tier, sensor_visit_fn visit, void* ctx);
+    int (*history_stats)(char* buf, int size);
+    int (*stats)(const char* window, char* buf, int size);
+    int (*set_adaptive)(int min_hz, int max_hz);
+    int (*trace_record)(int seconds, int hz);
+    void (*set_signal_hook)(signal_hook_fn hook);
+    void (*set_event_publisher)(event_publish_fn publish);
+    int (*lock_stats)(char* buf, int size, int reset);
     void (*cleanup)(void);
     int (*get_status)(char* status_buf, int buf_size);
 } cds_functions_t;
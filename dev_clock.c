@@ -0,0 +1,28 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include "dev_clock.h"
+
+// 서버 쪽 시계 (DEV_CLOCK_BOUND): 기본은 libc, make SIM=1 이면 장치 라이브러리와 같은 모의 시계
+
+static int libc_sleep_until(clockid_t clock, const struct timespec* deadline) {
+    int ret;
+    while ((ret = clock_nanosleep(clock, TIMER_ABSTIME, deadline, NULL)) == EINTR) {
+    }
+    return ret;
+}
+
+dev_clock_t dev_clock = {clock_gettime, libc_sleep_until, pthread_cond_timedwait};
+
+int dev_clock_bind(void* handle) {
+    if (!handle) return 0;
+
+    dev_clock_t sim = {
+        (int (*)(clockid_t, struct timespec*))dlsym(handle, "sim_clock_gettime"),
+        (int (*)(clockid_t, const struct timespec*))dlsym(handle, "sim_clock_sleep_until"),
+        (int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*))dlsym(handle, "sim_cond_timedwait"),
+    };
+
+    if (!sim.gettime || !sim.sleep_until || !sim.cond_timedwait) return 0;
+    dev_clock = sim;
+    return 1;
+}
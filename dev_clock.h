@@ -0,0 +1,92 @@
+#ifndef DEV_CLOCK_H
+#define DEV_CLOCK_H
+
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+// 시계 추상화: 장치 라이브러리와 스케줄러/규칙 엔진의 시각 읽기와 대기는 모두 여기를 거침
+// 기본 빌드는 libc 를 그대로 호출 (추가 비용 없음)
+// make SIM=1 빌드는 모의 wiringPi 의 시계를 쓰며, SIM_VIRTUAL_TIME=1 이면 모든 대기가
+// 다음 데드라인으로 바로 건너뜀 (몇 시간 분량의 동작을 같은 순서로 몇 초 만에 재현)
+// - 장치 라이브러리: 빌드 시 DEV_CLOCK_SIM 으로 sim_* 를 직접 호출
+// - 서버: DEV_CLOCK_BOUND 로 빌드, 장치 라이브러리를 불러온 뒤 dev_clock_bind() 로 같은 시계에 연결
+// 조건 변수는 CLOCK_MONOTONIC 으로 초기화되어 있어야 함 (데드라인은 단조 시계 기준)
+// 실행 비용 측정(구간 소요 시간, CPU 시간)은 실제 시간이어야 하므로 clock_gettime 을 그대로 사용
+
+typedef struct {
+    int (*gettime)(clockid_t clock, struct timespec* ts);
+    int (*sleep_until)(clockid_t clock, const struct timespec* deadline);
+    int (*cond_timedwait)(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline);
+} dev_clock_t;
+
+#if defined(DEV_CLOCK_SIM)
+
+int sim_clock_gettime(clockid_t clock, struct timespec* ts);
+int sim_clock_sleep_until(clockid_t clock, const struct timespec* deadline);
+int sim_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline);
+
+static inline int dev_clock_gettime(clockid_t clock, struct timespec* ts) {
+    return sim_clock_gettime(clock, ts);
+}
+
+static inline int dev_sleep_until(clockid_t clock, const struct timespec* deadline) {
+    return sim_clock_sleep_until(clock, deadline);
+}
+
+static inline int dev_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline) {
+    return sim_cond_timedwait(cond, mutex, deadline);
+}
+
+#elif defined(DEV_CLOCK_BOUND)
+
+extern dev_clock_t dev_clock;
+
+// handle 의 의존성에서 모의 시계를 찾아 연결, 없으면(실제 wiringPi) libc 유지, 연결되면 1
+int dev_clock_bind(void* handle);
+
+static inline int dev_clock_gettime(clockid_t clock, struct timespec* ts) {
+    return dev_clock.gettime(clock, ts);
+}
+
+static inline int dev_sleep_until(clockid_t clock, const struct timespec* deadline) {
+    return dev_clock.sleep_until(clock, deadline);
+}
+
+static inline int dev_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline) {
+    return dev_clock.cond_timedwait(cond, mutex, deadline);
+}
+
+#else
+
+static inline int dev_clock_gettime(clockid_t clock, struct timespec* ts) {
+    return clock_gettime(clock, ts);
+}
+
+static inline int dev_sleep_until(clockid_t clock, const struct timespec* deadline) {
+    int ret;
+    while ((ret = clock_nanosleep(clock, TIMER_ABSTIME, deadline, NULL)) == EINTR) {
+    }
+    return ret;
+}
+
+static inline int dev_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline) {
+    return pthread_cond_timedwait(cond, mutex, deadline);
+}
+
+#endif
+
+// 상대 대기 (sleep/usleep 대신)
+static inline void dev_sleep_ms(unsigned int ms) {
+    struct timespec deadline;
+    dev_clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    dev_sleep_until(CLOCK_MONOTONIC, &deadline);
+}
+
+#endif // DEV_CLOCK_H
@@ -0,0 +1,471 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include "device_actor.h"
+
+#define MAX_ACTORS 8
+#define ACTOR_MAILBOX_SIZE 64        // 장치별 우편함 칸 수 (2의 거듭제곱)
+#define ACTOR_LAT_BUCKETS 32         // 우편함 대기 지연 히스토그램 (2^n ns 단위)
+#define ACTOR_LANE_NORMAL 0
+#define ACTOR_LANE_URGENT 1          // 비상 명령 통로 (일반 통로보다 먼저 꺼냄)
+#define ACTOR_LANES 2
+
+typedef struct {
+    actor_fn fn;                 // NULL = 종료 요청
+    void* arg;
+    actor_future_t* future;      // NULL 이면 완료 알림 없음
+    long long posted_ns;
+    unsigned int key;            // 합침 키 (0 = 합치지 않음)
+} actor_msg_t;
+
+// 우편함 칸: 이벤트 버스 큐와 같은 방식 (seq == pos 면 비어 있음, pos + 1 이면 채워짐)
+typedef struct {
+    unsigned long seq;
+    actor_msg_t msg;
+} actor_cell_t;
+
+typedef struct {
+    sem_t space;                 // 빈 칸 수 (넣는 쪽이 먼저 차지)
+    actor_cell_t cells[ACTOR_MAILBOX_SIZE];
+    unsigned long enqueue_pos;   // 생산자들이 CAS 로 차지
+    unsigned long dequeue_pos;   // 장치 스레드만 씀
+} actor_lane_t;
+
+typedef struct {
+    char name[16];
+    pthread_t tid;
+    sem_t ready;                 // 두 통로의 채워진 칸 수 합
+    sem_t wake;                  // 멈춰 선 동안 깨움 (비상 요청 도착, 호출자가 풀어 줌)
+    int running;
+
+    actor_lane_t lanes[ACTOR_LANES];
+    unsigned long cancel_pos;    // 일반 통로에서 이 위치 앞의 요청은 비상 명령으로 취소
+    unsigned long urgent_epoch;  // 비상 명령을 넣을 때마다 증가 (진행 중인 장면 중단용)
+
+    unsigned long executed;
+    unsigned long coalesced;     // 뒤 요청으로 대체되어 건너뛴 요청
+    unsigned long urgent;        // 비상 통로로 실행한 요청
+    unsigned long cancelled;     // 비상 명령으로 취소한 일반 요청
+    unsigned long stalled;       // 우편함이 가득 차서 기다린 넣기
+    unsigned long gathered;      // 여러 장치 명령으로 멈춰 선 횟수
+    unsigned long latency[ACTOR_LAT_BUCKETS];
+    long long latency_max_ns;
+} actor_t;
+
+// 여러 장치 명령: 관련 장치 스레드가 모두 도착해 멈추면 호출자가 실행하고 풀어 줌
+typedef struct {
+    sem_t arrived;
+    sem_t release;
+    int parked;                  // 아직 release 를 기다리는 스레드 수 (0 이 되어야 정리 가능)
+    int started;                 // 호출자가 fn 실행을 시작함 (이후 멈춘 장치 스레드는 비상 요청도 처리하지 않음)
+    int cancelled;               // 멈춤 요청이 비상 명령으로 취소됨 (호출자는 fn 을 실행하지 않음)
+} actor_gather_t;
+
+// 비상 명령 한 장치분 (호출자 스택)
+typedef struct {
+    int (*fn)(int device);
+    int device;
+} actor_urgent_t;
+
+static actor_t actors[MAX_ACTORS];
+static int actor_count = 0;
+static pthread_mutex_t gather_mutex = PTHREAD_MUTEX_INITIALIZER;   // 여러 장치 요청을 같은 순서로 넣음
+static __thread unsigned int held_devices;   // 이 스레드가 여러 장치 명령으로 멈춰 세운 장치 (DEV_* 비트)
+
+static long long actor_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sem_wait_retry(sem_t* sem) {
+    while (sem_wait(sem) < 0 && errno == EINTR) {
+    }
+}
+
+// 다중 생산자 넣기: space 로 칸을 먼저 차지하므로 실패하지 않음 (가득 차면 기다림)
+static void mailbox_push(actor_t* actor, int lane_no, const actor_msg_t* msg) {
+    actor_lane_t* lane = &actor->lanes[lane_no];
+    if (sem_trywait(&lane->space) < 0) {
+        __atomic_fetch_add(&actor->stalled, 1, __ATOMIC_RELAXED);
+        sem_wait_retry(&lane->space);
+    }
+
+    unsigned long pos = __atomic_load_n(&lane->enqueue_pos, __ATOMIC_RELAXED);
+    actor_cell_t* cell;
+    for (;;) {
+        cell = &lane->cells[pos & (ACTOR_MAILBOX_SIZE - 1)];
+        long diff = (long)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&lane->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 차지한 칸을 장치 스레드가 아직 비우는 중
+            sched_yield();
+            pos = __atomic_load_n(&lane->enqueue_pos, __ATOMIC_RELAXED);
+        } else {
+            pos = __atomic_load_n(&lane->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->msg = *msg;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    sem_post(&actor->ready);
+    if (lane_no == ACTOR_LANE_URGENT) sem_post(&actor->wake);
+}
+
+// 단일 소비자 꺼내기 (꺼낸 위치를 pos_out 에), 비었으면 -1
+static int mailbox_pop(actor_lane_t* lane, actor_msg_t* msg, unsigned long* pos_out) {
+    unsigned long pos = lane->dequeue_pos;
+    actor_cell_t* cell = &lane->cells[pos & (ACTOR_MAILBOX_SIZE - 1)];
+
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1) return -1;
+    *msg = cell->msg;
+    __atomic_store_n(&cell->seq, pos + ACTOR_MAILBOX_SIZE, __ATOMIC_RELEASE);
+    __atomic_store_n(&lane->dequeue_pos, pos + 1, __ATOMIC_RELAXED);
+    sem_post(&lane->space);
+    *pos_out = pos;
+    return 0;
+}
+
+// 다음 칸이 채워져 있으면 그 요청의 합침 키, 아니면 0 (단일 소비자라 칸이 바뀌지 않음)
+static unsigned int mailbox_peek_key(actor_lane_t* lane) {
+    unsigned long pos = lane->dequeue_pos;
+    actor_cell_t* cell = &lane->cells[pos & (ACTOR_MAILBOX_SIZE - 1)];
+
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1) return 0;
+    return cell->msg.key;
+}
+
+// 여러 장치 명령 대기 칸 표시 (실행하지 않음, 장치 스레드가 보고 actor_park 로 멈춤)
+static int actor_gather_park(void* arg) {
+    (void)arg;
+    return 0;
+}
+
+static void actor_run(actor_t* actor, actor_msg_t* msg, int lane_no, unsigned long pos);
+
+// 도착을 알리고 호출자가 풀어 줄 때까지 멈춤
+// 호출자가 fn 을 시작하기 전까지는 비상 통로를 계속 비움: 다른 장치 스레드가 이 장치에 비상 명령을 넣고 기다리는데
+// 그 장치 스레드가 이 여러 장치 명령에 아직 도착하지 못했으면 서로 기다리며 멈추기 때문
+static void actor_park(actor_t* actor, actor_gather_t* gather) {
+    actor_lane_t* urgent = &actor->lanes[ACTOR_LANE_URGENT];
+    actor_msg_t msg;
+    unsigned long pos;
+
+    sem_post(&gather->arrived);
+    while (sem_trywait(&gather->release) < 0) {
+        while (!__atomic_load_n(&gather->started, __ATOMIC_ACQUIRE) && mailbox_pop(urgent, &msg, &pos) == 0) {
+            sem_wait_retry(&actor->ready);   // 꺼낸 칸 몫의 깨움 (넣는 쪽이 곧 올림)
+            actor_run(actor, &msg, ACTOR_LANE_URGENT, pos);
+        }
+        sem_wait_retry(&actor->wake);
+    }
+    __atomic_sub_fetch(&gather->parked, 1, __ATOMIC_RELEASE);
+}
+
+static void actor_run(actor_t* actor, actor_msg_t* msg, int lane_no, unsigned long pos) {
+    long long latency = actor_now_ns() - msg->posted_ns;
+    int bucket = 0;
+    while (bucket < ACTOR_LAT_BUCKETS - 1 && (1LL << bucket) < latency) bucket++;
+    __atomic_fetch_add(&actor->latency[bucket], 1, __ATOMIC_RELAXED);
+    if (latency > __atomic_load_n(&actor->latency_max_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&actor->latency_max_ns, latency, __ATOMIC_RELAXED);
+    }
+
+    int result;
+    int cancel = lane_no == ACTOR_LANE_NORMAL && (long)(pos - __atomic_load_n(&actor->cancel_pos, __ATOMIC_ACQUIRE)) < 0;
+    if (msg->fn == actor_gather_park) {
+        // 여러 장치 명령은 모든 장치가 도착해야 호출자가 끝나므로 취소되어도 멈추기는 하되 실행은 취소
+        if (cancel) {
+            __atomic_store_n(&((actor_gather_t*)msg->arg)->cancelled, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&actor->cancelled, 1, __ATOMIC_RELAXED);
+        }
+        actor_park(actor, msg->arg);
+        result = 0;
+    } else if (cancel) {
+        result = ACTOR_CANCELLED;
+        __atomic_fetch_add(&actor->cancelled, 1, __ATOMIC_RELAXED);
+    } else if (lane_no == ACTOR_LANE_URGENT) {
+        result = msg->fn(msg->arg);
+        __atomic_fetch_add(&actor->urgent, 1, __ATOMIC_RELAXED);
+    } else if (msg->key && mailbox_peek_key(&actor->lanes[ACTOR_LANE_NORMAL]) == msg->key) {
+        // 바로 뒤 요청이 같은 대상을 덮어쓰므로 장치에는 마지막 값만 적용
+        result = ACTOR_COALESCED;
+        __atomic_fetch_add(&actor->coalesced, 1, __ATOMIC_RELAXED);
+    } else {
+        result = msg->fn(msg->arg);
+        __atomic_fetch_add(&actor->executed, 1, __ATOMIC_RELAXED);
+    }
+    if (msg->future) {
+        msg->future->result = result;
+        sem_post(&msg->future->done);
+    }
+}
+
+static void* actor_thread(void* arg) {
+    actor_t* actor = arg;
+    actor_lane_t* normal = &actor->lanes[ACTOR_LANE_NORMAL];
+    actor_lane_t* urgent = &actor->lanes[ACTOR_LANE_URGENT];
+    actor_msg_t msg;
+    unsigned long pos;
+    int lane_no;
+
+    for (;;) {
+        sem_wait_retry(&actor->ready);
+        // 비상 통로 먼저, 깨움은 뒤 칸의 것일 수 있으므로 앞 칸을 차지한 생산자가 쓰기를 마칠 때까지 양보
+        for (;;) {
+            if (mailbox_pop(urgent, &msg, &pos) == 0) { lane_no = ACTOR_LANE_URGENT; break; }
+            if (mailbox_pop(normal, &msg, &pos) == 0) { lane_no = ACTOR_LANE_NORMAL; break; }
+            sched_yield();
+        }
+        if (!msg.fn) break;
+        actor_run(actor, &msg, lane_no, pos);
+    }
+    return NULL;
+}
+
+int device_actor_start(const char* const* names, int count) {
+    if (count > MAX_ACTORS) return -1;
+
+    for (int i = 0; i < count; i++) {
+        actor_t* actor = &actors[i];
+        memset(actor, 0, sizeof(*actor));
+        snprintf(actor->name, sizeof(actor->name), "%s", names[i]);
+        for (int l = 0; l < ACTOR_LANES; l++) {
+            for (int c = 0; c < ACTOR_MAILBOX_SIZE; c++) {
+                actor->lanes[l].cells[c].seq = c;
+            }
+            sem_init(&actor->lanes[l].space, 0, ACTOR_MAILBOX_SIZE);
+        }
+        sem_init(&actor->ready, 0, 0);
+        sem_init(&actor->wake, 0, 0);
+
+        if (pthread_create(&actor->tid, NULL, actor_thread, actor) != 0) {
+            printf("[ACTOR] %s 장치 스레드 생성 실패\n", actor->name);
+            sem_destroy(&actor->ready);
+            sem_destroy(&actor->wake);
+            for (int l = 0; l < ACTOR_LANES; l++) sem_destroy(&actor->lanes[l].space);
+            device_actor_stop();
+            return -1;
+        }
+        __atomic_store_n(&actor->running, 1, __ATOMIC_RELEASE);
+        actor_count = i + 1;
+    }
+    printf("[ACTOR] 장치 스레드 %d개 시작 (우편함 일반/비상 각 %d칸)\n", count, ACTOR_MAILBOX_SIZE);
+    return 0;
+}
+
+// 호출자가 더 없을 때 부름 (클라이언트, 규칙, 예약 스레드를 먼저 정리)
+void device_actor_stop(void) {
+    actor_msg_t stop = {NULL, NULL, NULL, 0, 0};
+
+    for (int i = 0; i < actor_count; i++) {
+        if (!__atomic_load_n(&actors[i].running, __ATOMIC_ACQUIRE)) continue;
+        mailbox_push(&actors[i], ACTOR_LANE_NORMAL, &stop);
+        pthread_join(actors[i].tid, NULL);
+        __atomic_store_n(&actors[i].running, 0, __ATOMIC_RELEASE);
+    }
+}
+
+// 호출한 스레드가 장치 스레드면 그 번호, 아니면 -1
+static int actor_self(void) {
+    pthread_t self = pthread_self();
+    for (int i = 0; i < actor_count; i++) {
+        if (__atomic_load_n(&actors[i].running, __ATOMIC_ACQUIRE) && pthread_equal(actors[i].tid, self)) return i;
+    }
+    return -1;
+}
+
+static int actor_post_key(int device, unsigned int key, actor_fn fn, void* arg, actor_future_t* future) {
+    if (!fn) return -1;
+    if (future) sem_init(&future->done, 0, 0);
+
+    if (device < 0 || device >= actor_count || !__atomic_load_n(&actors[device].running, __ATOMIC_ACQUIRE)) {
+        int result = fn(arg);
+        if (future) {
+            future->result = result;
+            sem_post(&future->done);
+        }
+        return 0;
+    }
+
+    actor_msg_t msg = {fn, arg, future, actor_now_ns(), key};
+    mailbox_push(&actors[device], ACTOR_LANE_NORMAL, &msg);
+    return 0;
+}
+
+int device_actor_post(int device, actor_fn fn, void* arg, actor_future_t* future) {
+    return actor_post_key(device, 0, fn, arg, future);
+}
+
+int actor_future_wait(actor_future_t* future) {
+    sem_wait_retry(&future->done);
+    sem_destroy(&future->done);
+    return future->result;
+}
+
+int device_actor_call_coalesce(unsigned int devices, unsigned int key, actor_fn fn, void* arg) {
+    actor_future_t future;
+    actor_gather_t gather;
+    int targets[MAX_ACTORS], count = 0;
+
+    if (actor_self() >= 0) return fn(arg);
+    for (int i = 0; i < actor_count; i++) {
+        if ((devices & (1u << i)) && __atomic_load_n(&actors[i].running, __ATOMIC_ACQUIRE)) targets[count++] = i;
+    }
+    if (count == 0) return fn(arg);
+
+    if (count == 1) {
+        actor_post_key(targets[0], key, fn, arg, &future);
+        return actor_future_wait(&future);
+    }
+
+    sem_init(&gather.arrived, 0, 0);
+    sem_init(&gather.release, 0, 0);
+    gather.parked = count;
+    gather.cancelled = 0;
+    gather.started = 0;
+
+    pthread_mutex_lock(&gather_mutex);
+    for (int i = 0; i < count; i++) {
+        actor_msg_t msg = {actor_gather_park, &gather, NULL, actor_now_ns(), 0};
+        mailbox_push(&actors[targets[i]], ACTOR_LANE_NORMAL, &msg);
+        __atomic_fetch_add(&actors[targets[i]].gathered, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&gather_mutex);
+
+    for (int i = 0; i < count; i++) sem_wait_retry(&gather.arrived);
+    __atomic_store_n(&gather.started, 1, __ATOMIC_RELEASE);
+    int result = ACTOR_CANCELLED;
+    if (!__atomic_load_n(&gather.cancelled, __ATOMIC_RELAXED)) {
+        unsigned int held = held_devices;
+        for (int i = 0; i < count; i++) held_devices |= 1u << targets[i];
+        result = fn(arg);
+        held_devices = held;
+    }
+    for (int i = 0; i < count; i++) {
+        sem_post(&gather.release);
+        sem_post(&actors[targets[i]].wake);
+    }
+
+    // 장치 스레드가 release 대기에서 모두 빠져나온 뒤에 정리 (스택의 세마포어)
+    while (__atomic_load_n(&gather.parked, __ATOMIC_ACQUIRE) > 0) sched_yield();
+    sem_destroy(&gather.arrived);
+    sem_destroy(&gather.release);
+    return result;
+}
+
+int device_actor_call(unsigned int devices, actor_fn fn, void* arg) {
+    return device_actor_call_coalesce(devices, 0, fn, arg);
+}
+
+// 일반 통로에서 지금까지 들어온 요청을 모두 취소 대상으로 표시
+static void actor_cancel_pending(actor_t* actor) {
+    unsigned long pos = __atomic_load_n(&actor->lanes[ACTOR_LANE_NORMAL].enqueue_pos, __ATOMIC_ACQUIRE);
+    unsigned long old = __atomic_load_n(&actor->cancel_pos, __ATOMIC_RELAXED);
+    while ((long)(pos - old) > 0 &&
+           !__atomic_compare_exchange_n(&actor->cancel_pos, &old, pos, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+
+static int actor_urgent_run(void* arg) {
+    actor_urgent_t* step = arg;
+    return step->fn(step->device);
+}
+
+unsigned int device_actor_urgent(unsigned int devices, int (*fn)(int device)) {
+    actor_urgent_t steps[MAX_ACTORS];
+    actor_future_t futures[MAX_ACTORS];
+    int targets[MAX_ACTORS], count = 0;
+    unsigned int failed = 0;
+
+    // 호출자가 소유한 장치(자기 장치 스레드, 장면처럼 멈춰 세운 장치)만 바로 실행 (넣고 기다리면 자기를 기다리며 멈춤)
+    // 뒤에 쌓인 일반 요청은 취소하되 중단 표시는 남기지 않음 (이 단계를 실행 중인 장면 자신이 멈추지 않게)
+    // 나머지는 그 장치 스레드의 비상 통로로 보냄 (멈춰 선 장치 스레드도 호출자가 실행을 시작하기 전까지는 비상 통로를 비움)
+    int self = actor_self();
+    for (int i = 0; i < MAX_ACTORS; i++) {
+        if (!(devices & (1u << i))) continue;
+        if (i >= actor_count || !__atomic_load_n(&actors[i].running, __ATOMIC_ACQUIRE)) {
+            if (fn(i) < 0) failed |= 1u << i;
+        } else if (i == self || (held_devices & (1u << i))) {
+            actor_cancel_pending(&actors[i]);
+            if (fn(i) < 0) failed |= 1u << i;
+        } else {
+            targets[count++] = i;
+        }
+    }
+
+    // 넣기 전에 모든 장치에 취소 위치와 중단 표시를 남김 (앞서 넣은 일반 요청과 진행 중인 장면이 더 나아가지 않게)
+    for (int i = 0; i < count; i++) {
+        actor_cancel_pending(&actors[targets[i]]);
+        __atomic_fetch_add(&actors[targets[i]].urgent_epoch, 1, __ATOMIC_RELEASE);
+    }
+    for (int i = 0; i < count; i++) {
+        steps[i].fn = fn;
+        steps[i].device = targets[i];
+        sem_init(&futures[i].done, 0, 0);
+        actor_msg_t msg = {actor_urgent_run, &steps[i], &futures[i], actor_now_ns(), 0};
+        mailbox_push(&actors[targets[i]], ACTOR_LANE_URGENT, &msg);
+    }
+    for (int i = 0; i < count; i++) {
+        if (actor_future_wait(&futures[i]) < 0) failed |= 1u << targets[i];
+    }
+    return failed;
+}
+
+unsigned long device_actor_urgent_epoch(unsigned int devices) {
+    unsigned long epoch = 0;
+    for (int i = 0; i < actor_count; i++) {
+        if (devices & (1u << i)) epoch += __atomic_load_n(&actors[i].urgent_epoch, __ATOMIC_ACQUIRE);
+    }
+    return epoch;
+}
+
+// 히스토그램 백분위 (구간 상한 ns, 최대값을 넘지 않게)
+static long long actor_percentile(const unsigned long* hist, unsigned long total, int percent, long long max_ns) {
+    unsigned long need = (total * percent + 99) / 100, seen = 0;
+    for (int i = 0; i < ACTOR_LAT_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= need) return (1LL << i) < max_ns ? (1LL << i) : max_ns;
+    }
+    return max_ns;
+}
+
+int device_actor_stats(char* buf, int size) {
+    int len = snprintf(buf, size, "장치 스레드 %d개, 우편함 일반/비상 각 %d칸", actor_count, ACTOR_MAILBOX_SIZE);
+
+    for (int i = 0; i < actor_count && len < size; i++) {
+        actor_t* actor = &actors[i];
+        unsigned long hist[ACTOR_LAT_BUCKETS], total = 0;
+        for (int b = 0; b < ACTOR_LAT_BUCKETS; b++) {
+            hist[b] = __atomic_exchange_n(&actor->latency[b], 0, __ATOMIC_RELAXED);
+            total += hist[b];
+        }
+        long long max_ns = __atomic_exchange_n(&actor->latency_max_ns, 0, __ATOMIC_RELAXED);
+        unsigned long depth = 0;
+        for (int l = 0; l < ACTOR_LANES; l++) {
+            depth += __atomic_load_n(&actor->lanes[l].enqueue_pos, __ATOMIC_RELAXED) -
+                     __atomic_load_n(&actor->lanes[l].dequeue_pos, __ATOMIC_RELAXED);
+        }
+
+        len += snprintf(buf + len, size - len, "\n%s: 처리 %lu, 합침 %lu, 비상 %lu, 취소 %lu, 대기 %lu, 가득 참 %lu, 여러 장치 %lu",
+                        actor->name, __atomic_load_n(&actor->executed, __ATOMIC_RELAXED),
+                        __atomic_load_n(&actor->coalesced, __ATOMIC_RELAXED),
+                        __atomic_load_n(&actor->urgent, __ATOMIC_RELAXED),
+                        __atomic_load_n(&actor->cancelled, __ATOMIC_RELAXED), depth,
+                        __atomic_load_n(&actor->stalled, __ATOMIC_RELAXED),
+                        __atomic_load_n(&actor->gathered, __ATOMIC_RELAXED));
+        if (total > 0 && len < size) {
+            len += snprintf(buf + len, size - len, ", 우편함 지연 p50<=%.1fus p99<=%.1fus 최대 %.1fus",
+                            actor_percentile(hist, total, 50, max_ns) / 1000.0,
+                            actor_percentile(hist, total, 99, max_ns) / 1000.0, max_ns / 1000.0);
+        }
+    }
+    return len < size ? len : size - 1;
+}
@@ -0,0 +1,61 @@
+#ifndef DEVICE_ACTOR_H
+#define DEVICE_ACTOR_H
+
+#include <limits.h>
+#include <semaphore.h>
+
+// 장치별 실행 스레드 (서버 본체)
+// 장치마다 소유 스레드 하나가 그 장치를 쓰는 명령을 우편함 순서대로 실행하므로
+// 명령 처리 경로에는 장치 잠금이 없음 (호출자는 넣고 완료를 기다림)
+// 우편함은 크기가 정해진 다중 생산자 원형 큐, 가득 차면 넣는 쪽이 빈 칸이 날 때까지 기다림
+// 여러 장치를 쓰는 명령(ALL_OFF, 장면)은 관련 장치 스레드를 모두 멈춰 세운 뒤 호출자 스레드에서 실행
+// (여러 장치 요청은 모든 우편함에 같은 순서로 들어가므로 서로 기다리며 멈추지 않음,
+//  멈춰 선 장치 스레드도 호출자가 실행을 시작하기 전까지는 비상 통로를 비움)
+// 같은 대상을 덮어쓰는 설정 명령은 합침 키를 붙여 넣음: 우편함 바로 다음 요청이 같은 키면 앞 요청은 실행하지 않고
+// ACTOR_COALESCED 로 완료 (마지막 값만 장치에 적용, 다른 요청이 사이에 있으면 합치지 않음)
+// 비상 명령(ALL_OFF, BUZZER_STOP)은 장치마다 따로 있는 비상 통로로 넣음: 장치 스레드는 비상 통로를 먼저 비우고
+// 그보다 앞서 일반 통로에 들어온 요청은 실행하지 않고 ACTOR_CANCELLED 로 완료
+
+typedef int (*actor_fn)(void* arg);
+
+#define ACTOR_COALESCED INT_MIN      // 뒤 요청으로 대체되어 실행하지 않음
+#define ACTOR_CANCELLED (INT_MIN + 1)  // 뒤에 들어온 비상 명령으로 취소되어 실행하지 않음
+
+// 완료 대기 (호출자 스택에 두고 device_actor_post 에 전달)
+typedef struct {
+    sem_t done;
+    int result;
+} actor_future_t;
+
+// 장치 스레드 count 개 시작 (번호 = DEV_* 비트 위치)
+int device_actor_start(const char* const* names, int count);
+
+// 모든 장치 스레드 종료 (남은 요청은 실행 후 종료, 이후 호출은 호출자 스레드에서 바로 실행)
+void device_actor_stop(void);
+
+// device 우편함에 fn(arg) 를 넣음, future 가 있으면 완료 시 결과와 함께 알림
+int device_actor_post(int device, actor_fn fn, void* arg, actor_future_t* future);
+
+// 완료를 기다려 fn 의 반환값 반환
+int actor_future_wait(actor_future_t* future);
+
+// devices(DEV_* 비트마스크)를 소유한 스레드에서 fn(arg) 실행 후 결과 반환
+// 장치가 없거나 장치 스레드 안에서 부르면 호출자 스레드에서 바로 실행
+int device_actor_call(unsigned int devices, actor_fn fn, void* arg);
+
+// device_actor_call 과 같고 key(0 이 아니면)가 같은 뒤 요청이 우편함에 있으면 ACTOR_COALESCED 반환
+// 한 장치 요청만 합침 (여러 장치 요청이나 호출자 스레드에서 바로 실행하면 key 무시)
+int device_actor_call_coalesce(unsigned int devices, unsigned int key, actor_fn fn, void* arg);
+
+// devices 의 장치 스레드마다 비상 통로로 fn(장치 번호) 실행, 모두 끝날 때까지 기다리고 실패(음수 반환)한 장치의 DEV_* 비트 반환
+// 앞서 넣은 일반 요청은 취소, 진행 중인 여러 장치 명령은 device_actor_urgent_epoch 로 알아차려 멈춤
+// 호출한 장치 스레드 자신의 장치와 호출자가 멈춰 세운 장치(장면 실행 중)만 바로 실행하고 나머지는 비상 통로로 보냄
+unsigned int device_actor_urgent(unsigned int devices, int (*fn)(int device));
+
+// devices 에 들어온 비상 명령 수 (장면처럼 오래 걸리는 여러 장치 명령이 단계마다 비교)
+unsigned long device_actor_urgent_epoch(unsigned int devices);
+
+// 장치별 처리 수, 합친 수, 비상/취소 수, 대기 중인 요청, 우편함 대기 지연, 조회 시 지연 통계 초기화
+int device_actor_stats(char* buf, int size);
+
+#endif // DEVICE_ACTOR_H
@@ -0,0 +1,160 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "event_bus.h"
+
+// 이벤트 버스 전달 지연/처리량 측정 (장치 불필요)
+// 구독자는 등록만 가능하므로 시나리오마다 자식 프로세스에서 실행
+
+#define LAT_BUCKETS 32
+#define MAX_BENCH_SUBS 8
+
+typedef struct {
+    unsigned long count;
+    unsigned long hist[LAT_BUCKETS];
+    long long max_ns;
+} bench_sub_t;
+
+typedef struct {
+    int events;
+    long delivered;
+} producer_arg_t;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void on_event(const device_event_t* ev, void* ctx) {
+    bench_sub_t* sub = ctx;
+    long long latency = now_ns() - ev->ts_ns;
+    int bucket = 0;
+    while (bucket < LAT_BUCKETS - 1 && (1LL << bucket) < latency) bucket++;
+    sub->hist[bucket]++;
+    if (latency > sub->max_ns) sub->max_ns = latency;
+    __atomic_store_n(&sub->count, sub->count + 1, __ATOMIC_RELEASE);
+}
+
+// 백분위 (천분율), 히스토그램 구간 상한 ns
+static long long percentile(const unsigned long* hist, unsigned long total, int permille) {
+    unsigned long need = (total * permille + 999) / 1000, seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= need) return 1LL << i;
+    }
+    return 1LL << (LAT_BUCKETS - 1);
+}
+
+static double clamp_us(long long bound_ns, long long max_ns) {
+    return (bound_ns < max_ns ? bound_ns : max_ns) / 1000.0;
+}
+
+static void report_latency(bench_sub_t* subs, int nsubs) {
+    unsigned long hist[LAT_BUCKETS] = {0}, total = 0;
+    long long max_ns = 0;
+    for (int s = 0; s < nsubs; s++) {
+        for (int b = 0; b < LAT_BUCKETS; b++) {
+            hist[b] += subs[s].hist[b];
+            total += subs[s].hist[b];
+        }
+        if (subs[s].max_ns > max_ns) max_ns = subs[s].max_ns;
+    }
+    printf("  지연 p50<=%.1fus p99<=%.1fus p99.9<=%.1fus 최대 %.1fus\n", clamp_us(percentile(hist, total, 500), max_ns),
+           clamp_us(percentile(hist, total, 990), max_ns), clamp_us(percentile(hist, total, 999), max_ns), max_ns / 1000.0);
+}
+
+static void wait_delivered(bench_sub_t* subs, int nsubs, unsigned long expected) {
+    for (;;) {
+        unsigned long total = 0;
+        for (int s = 0; s < nsubs; s++) total += __atomic_load_n(&subs[s].count, __ATOMIC_ACQUIRE);
+        if (total >= expected) return;
+        usleep(1000);
+    }
+}
+
+// 시나리오 1: 한가한 버스에서 한 건씩 발행 (구독자가 잠든 상태에서 깨어나는 지연 포함)
+static void bench_idle_latency(int nsubs, int events, int interval_us) {
+    static bench_sub_t subs[MAX_BENCH_SUBS];
+    unsigned long expected = 0;
+
+    for (int s = 0; s < nsubs; s++) event_bus_subscribe("bench", EVENT_MASK(EVENT_USER), on_event, &subs[s]);
+    for (int i = 0; i < events; i++) {
+        expected += event_publish(EVENT_USER, i);
+        usleep(interval_us);
+    }
+    wait_delivered(subs, nsubs, expected);
+    printf("[한가한 발행] 구독자 %d, %d건, %dus 간격\n", nsubs, events, interval_us);
+    report_latency(subs, nsubs);
+    event_bus_stop();
+}
+
+static void* producer_thread(void* arg) {
+    producer_arg_t* producer = arg;
+    for (int i = 0; i < producer->events; i++) {
+        producer->delivered += event_publish(EVENT_USER, i);
+    }
+    return NULL;
+}
+
+// 시나리오 2: 여러 생산자가 최대 속도로 발행 (큐가 차면 그 구독자 몫은 버려짐)
+static void bench_throughput(int nproducers, int nsubs, int events) {
+    static bench_sub_t subs[MAX_BENCH_SUBS];
+    pthread_t tids[16];
+    producer_arg_t producers[16];
+    unsigned long expected = 0;
+
+    for (int s = 0; s < nsubs; s++) event_bus_subscribe("bench", EVENT_MASK(EVENT_USER), on_event, &subs[s]);
+
+    long long start = now_ns();
+    for (int p = 0; p < nproducers; p++) {
+        producers[p].events = events;
+        producers[p].delivered = 0;
+        pthread_create(&tids[p], NULL, producer_thread, &producers[p]);
+    }
+    for (int p = 0; p < nproducers; p++) {
+        pthread_join(tids[p], NULL);
+        expected += producers[p].delivered;
+    }
+    long long published = now_ns();
+    wait_delivered(subs, nsubs, expected);
+    long long drained = now_ns();
+
+    unsigned long attempted = (unsigned long)nproducers * events * nsubs;
+    printf("[최대 속도] 생산자 %d, 구독자 %d, 생산자당 %d건\n", nproducers, nsubs, events);
+    printf("  발행 %.2f M건/s, 전달 %.2f M건/s (구독자 합계), 버림 %lu/%lu (%.1f%%)\n",
+           (double)nproducers * events / ((published - start) / 1e3), expected / ((drained - start) / 1e3),
+           attempted - expected, attempted, 100.0 * (attempted - expected) / attempted);
+    report_latency(subs, nsubs);
+    event_bus_stop();
+}
+
+int main(int argc, char* argv[]) {
+    int events = argc > 1 ? atoi(argv[1]) : 200000;
+    int scenarios[][2] = {{1, 1}, {1, 4}, {2, 1}, {4, 1}, {4, 4}};   // {생산자, 구독자}
+
+    printf("이벤트 버스 벤치마크 (CPU %ld개)\n\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (int n = 1; n <= 4; n *= 4) {
+        fflush(stdout);
+        if (fork() == 0) {
+            bench_idle_latency(n, 2000, 500);
+            exit(0);
+        }
+        wait(NULL);
+    }
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        fflush(stdout);
+        if (fork() == 0) {
+            bench_throughput(scenarios[i][0], scenarios[i][1], events);
+            exit(0);
+        }
+        wait(NULL);
+    }
+    return 0;
+}
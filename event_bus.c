@@ -0,0 +1,229 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include "control_device.h"
+#include "event_bus.h"
+
+#define MAX_SUBSCRIBERS 16
+#define EVENT_QUEUE_SIZE 1024    // 구독자별 큐 크기 (2의 거듭제곱)
+#define EVENT_LAT_BUCKETS 32     // 전달 지연 히스토그램 (2^n ns 단위)
+
+static const char* event_names[EVENT_TYPE_COUNT] = {
+    "countdown.tick", "countdown.finished", "cds.dark", "cds.bright", "user"
+};
+
+// 큐 칸: seq 로 칸의 상태를 표시 (seq == pos 면 비어 있음, pos + 1 이면 채워짐)
+typedef struct {
+    unsigned long seq;
+    device_event_t ev;
+} event_cell_t;
+
+typedef struct {
+    char name[16];
+    unsigned int mask;
+    event_handler_fn handler;
+    void* ctx;
+    pthread_t tid;
+    sem_t ready;                 // 채워진 칸 수
+    int stopping;
+
+    event_cell_t cells[EVENT_QUEUE_SIZE];
+    unsigned long enqueue_pos;   // 생산자들이 CAS 로 차지
+    unsigned long dequeue_pos;   // 구독자 스레드만 사용
+
+    unsigned long delivered;
+    unsigned long dropped;
+    unsigned long latency[EVENT_LAT_BUCKETS];
+    long long latency_max_ns;
+} subscriber_t;
+
+static subscriber_t subscribers[MAX_SUBSCRIBERS];
+static int subscriber_count = 0;         // 발행 쪽은 잠금 없이 읽음 (등록은 추가만)
+static pthread_mutex_t subscribe_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long publish_seq = 0;
+
+static long long bus_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+const char* event_type_name(int type) {
+    return type >= 0 && type < EVENT_TYPE_COUNT ? event_names[type] : "unknown";
+}
+
+int event_type_from_name(const char* name) {
+    for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+        if (strcmp(name, event_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// 다중 생산자 넣기, 큐가 가득 차면 -1
+static int queue_push(subscriber_t* sub, const device_event_t* ev) {
+    unsigned long pos = __atomic_load_n(&sub->enqueue_pos, __ATOMIC_RELAXED);
+    event_cell_t* cell;
+
+    for (;;) {
+        cell = &sub->cells[pos & (EVENT_QUEUE_SIZE - 1)];
+        long diff = (long)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&sub->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1;
+        } else {
+            pos = __atomic_load_n(&sub->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->ev = *ev;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// 단일 소비자 꺼내기, 비었으면 -1
+static int queue_pop(subscriber_t* sub, device_event_t* ev) {
+    unsigned long pos = sub->dequeue_pos;
+    event_cell_t* cell = &sub->cells[pos & (EVENT_QUEUE_SIZE - 1)];
+
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1) return -1;
+    *ev = cell->ev;
+    __atomic_store_n(&cell->seq, pos + EVENT_QUEUE_SIZE, __ATOMIC_RELEASE);
+    sub->dequeue_pos = pos + 1;
+    return 0;
+}
+
+static void* subscriber_thread(void* arg) {
+    subscriber_t* sub = arg;
+    device_event_t ev;
+
+    for (;;) {
+        if (sem_wait(&sub->ready) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (__atomic_load_n(&sub->stopping, __ATOMIC_ACQUIRE)) break;
+        // 깨움은 뒤 칸의 것일 수 있음: 앞 칸을 차지한 생산자가 쓰기를 마칠 때까지 양보
+        while (queue_pop(sub, &ev) < 0) sched_yield();
+
+        long long latency = bus_now_ns() - ev.ts_ns;
+        int bucket = 0;
+        while (bucket < EVENT_LAT_BUCKETS - 1 && (1LL << bucket) < latency) bucket++;
+        __atomic_fetch_add(&sub->latency[bucket], 1, __ATOMIC_RELAXED);
+        if (latency > __atomic_load_n(&sub->latency_max_ns, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&sub->latency_max_ns, latency, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_add(&sub->delivered, 1, __ATOMIC_RELAXED);
+
+        sub->handler(&ev, sub->ctx);
+    }
+    return NULL;
+}
+
+int event_bus_subscribe(const char* name, unsigned int type_mask, event_handler_fn handler, void* ctx) {
+    pthread_mutex_lock(&subscribe_mutex);
+    if (subscriber_count >= MAX_SUBSCRIBERS || !handler) {
+        pthread_mutex_unlock(&subscribe_mutex);
+        return -1;
+    }
+
+    subscriber_t* sub = &subscribers[subscriber_count];
+    memset(sub, 0, sizeof(*sub));
+    snprintf(sub->name, sizeof(sub->name), "%s", name);
+    sub->mask = type_mask;
+    sub->handler = handler;
+    sub->ctx = ctx;
+    for (int i = 0; i < EVENT_QUEUE_SIZE; i++) {
+        sub->cells[i].seq = i;
+    }
+    sem_init(&sub->ready, 0, 0);
+
+    if (pthread_create(&sub->tid, NULL, subscriber_thread, sub) != 0) {
+        sem_destroy(&sub->ready);
+        pthread_mutex_unlock(&subscribe_mutex);
+        printf("[EVENT] %s 구독자 스레드 생성 실패\n", name);
+        return -1;
+    }
+
+    int id = subscriber_count;
+    __atomic_store_n(&subscriber_count, subscriber_count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&subscribe_mutex);
+    printf("[EVENT] 구독 등록: %s (mask 0x%x)\n", sub->name, type_mask);
+    return id;
+}
+
+int event_publish(int type, int value) {
+    if (type < 0 || type >= EVENT_TYPE_COUNT) return -1;
+
+    device_event_t ev = {type, value, bus_now_ns(), __atomic_fetch_add(&publish_seq, 1, __ATOMIC_RELAXED)};
+    int count = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+    int delivered = 0;
+
+    for (int i = 0; i < count; i++) {
+        subscriber_t* sub = &subscribers[i];
+        if (!(sub->mask & EVENT_MASK(type)) || __atomic_load_n(&sub->stopping, __ATOMIC_ACQUIRE)) continue;
+        if (queue_push(sub, &ev) < 0) {
+            __atomic_fetch_add(&sub->dropped, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        sem_post(&sub->ready);
+        delivered++;
+    }
+    return delivered;
+}
+
+void event_bus_stop(void) {
+    pthread_mutex_lock(&subscribe_mutex);
+    int count = subscriber_count;
+    for (int i = 0; i < count; i++) {
+        __atomic_store_n(&subscribers[i].stopping, 1, __ATOMIC_RELEASE);
+        sem_post(&subscribers[i].ready);
+    }
+    // 다른 스레드가 아직 발행할 수 있으므로 칸과 세마포어는 그대로 둠 (stopping 이면 건너뜀)
+    for (int i = 0; i < count; i++) {
+        pthread_join(subscribers[i].tid, NULL);
+    }
+    pthread_mutex_unlock(&subscribe_mutex);
+}
+
+// 히스토그램 백분위 (구간 상한 ns, 최대값을 넘지 않게)
+static long long latency_percentile(const unsigned long* hist, unsigned long total, int percent, long long max_ns) {
+    unsigned long need = (total * percent + 99) / 100, seen = 0;
+    for (int i = 0; i < EVENT_LAT_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= need) return (1LL << i) < max_ns ? (1LL << i) : max_ns;
+    }
+    return max_ns;
+}
+
+int event_bus_stats(char* buf, int size) {
+    int count = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+    int len = snprintf(buf, size, "발행 %lu, 구독자 %d", __atomic_load_n(&publish_seq, __ATOMIC_RELAXED), count);
+
+    for (int i = 0; i < count && len < size; i++) {
+        subscriber_t* sub = &subscribers[i];
+        unsigned long hist[EVENT_LAT_BUCKETS], total = 0;
+        for (int b = 0; b < EVENT_LAT_BUCKETS; b++) {
+            hist[b] = __atomic_exchange_n(&sub->latency[b], 0, __ATOMIC_RELAXED);
+            total += hist[b];
+        }
+        long long max_ns = __atomic_exchange_n(&sub->latency_max_ns, 0, __ATOMIC_RELAXED);
+        unsigned long depth = __atomic_load_n(&sub->enqueue_pos, __ATOMIC_RELAXED) - sub->dequeue_pos;
+
+        len += snprintf(buf + len, size - len, "\n%s: 전달 %lu, 버림 %lu, 대기 %lu", sub->name,
+                        __atomic_load_n(&sub->delivered, __ATOMIC_RELAXED),
+                        __atomic_load_n(&sub->dropped, __ATOMIC_RELAXED), depth);
+        if (total > 0 && len < size) {
+            len += snprintf(buf + len, size - len, ", 지연 p50<=%.1fus p99<=%.1fus 최대 %.1fus",
+                            latency_percentile(hist, total, 50, max_ns) / 1000.0, latency_percentile(hist, total, 99, max_ns) / 1000.0,
+                            max_ns / 1000.0);
+        }
+    }
+    return len < size ? len : size - 1;
+}
@@ -0,0 +1,28 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "control_device.h"
+
+// 프로세스 내 이벤트 버스 (서버 본체)
+// 구독자마다 잠금 없는 다중 생산자 원형 큐와 전달 스레드를 두어,
+// 발행은 큐에 넣고 깨우기만 하며 (막히지 않음, 큐가 차면 그 구독자 몫만 버림)
+// 처리기는 구독자 스레드에서 순서대로 실행
+
+typedef void (*event_handler_fn)(const device_event_t* ev, void* ctx);
+
+// 구독 등록 (type_mask = EVENT_MASK(...) 조합), 성공 시 구독자 번호
+int event_bus_subscribe(const char* name, unsigned int type_mask, event_handler_fn handler, void* ctx);
+
+// 발행 (event_publish_fn), 넣은 구독자 수 반환
+int event_publish(int type, int value);
+
+// 모든 구독자 스레드 종료 (남은 이벤트는 버림)
+void event_bus_stop(void);
+
+// 구독자별 전달/버림 수와 전달 지연, 조회 시 지연 통계 초기화
+int event_bus_stats(char* buf, int size);
+
+const char* event_type_name(int type);
+int event_type_from_name(const char* name);
+
+#endif // EVENT_BUS_H
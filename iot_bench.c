@@ -0,0 +1,444 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// IoT 서버 부하 생성 / 지연 측정 도구 (장치 불필요, 서버는 실제 또는 모의 GPIO 빌드)
+// 연결(작업 스레드) N개가 명령 구성표에서 가중치대로 골라 보내고, 응답까지 걸린 시간을 히스토그램에 기록
+//   닫힌 루프: 연결마다 응답을 받으면 바로 다음 요청 (최대 처리량)
+//   열린 루프 (-r): 정해진 속도로 보낼 예정 시각을 기준으로 지연 측정 (밀린 대기 시간 포함)
+
+#define MAX_MIX 16
+#define MAX_CONNS 256
+#define MAX_BENCH_CMD 256
+#define IO_BUFFER_SIZE 8192
+#define RECV_TIMEOUT_SEC 5
+
+// 로그-선형 히스토그램: 2의 거듭제곱 구간마다 64칸 (상대 오차 1.6% 이내, HdrHistogram 유효숫자 2자리 수준)
+#define HIST_SUB_BITS 6
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (2 * HIST_SUB + 40 * HIST_SUB)
+
+enum { EP_TCP, EP_HTTP, EP_HISTORY };
+static const char* endpoint_names[] = {"tcp", "http", "history"};
+
+typedef struct {
+    unsigned long counts[HIST_BUCKETS];
+    unsigned long total;
+    long long max_ns;
+} histogram_t;
+
+typedef struct {
+    int endpoint;
+    int weight;
+    char command[MAX_BENCH_CMD];     // tcp/http: 명령, history: 조회 문자열 (from=-10m&res=1s)
+    unsigned long requests;
+    unsigned long errors;
+    histogram_t hist;
+} mix_entry_t;
+
+typedef struct {
+    int id;
+    int fd;                           // 유지하는 TCP 연결 (-1 이면 다음 요청 때 연결)
+    char buf[IO_BUFFER_SIZE];
+    int start, end;
+    unsigned int seed;
+} worker_t;
+
+static mix_entry_t mix[MAX_MIX];
+static int mix_count = 0, weight_total = 0;
+static histogram_t total_hist;
+static unsigned long total_requests = 0, total_errors = 0, connect_errors = 0;
+
+static struct sockaddr_in server_addr;
+static int conns = 4;
+static double duration_sec = 10, warmup_sec = 2, rate = 0;
+static long long bench_start_ns, record_start_ns, bench_end_ns;
+static int stopping = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int hist_index(long long value) {
+    if (value < 2 * HIST_SUB) return value < 0 ? 0 : (int)value;
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HIST_SUB_BITS;
+    int index = shift * HIST_SUB + (int)(value >> shift);
+    return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
+}
+
+// 구간의 가장 큰 값 (HdrHistogram 의 highest equivalent value 와 같은 의미)
+static long long hist_value(int index) {
+    if (index < 2 * HIST_SUB) return index;
+    int shift = index / HIST_SUB - 1;
+    long long sub = index - shift * HIST_SUB;
+    return ((sub + 1) << shift) - 1;
+}
+
+static void hist_record(histogram_t* hist, long long value) {
+    __atomic_fetch_add(&hist->counts[hist_index(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->total, 1, __ATOMIC_RELAXED);
+    long long max = __atomic_load_n(&hist->max_ns, __ATOMIC_RELAXED);
+    while (value > max && !__atomic_compare_exchange_n(&hist->max_ns, &max, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// 백분위 (구간 상한, 최대값을 넘지 않게)
+static long long hist_percentile(const histogram_t* hist, double percent) {
+    unsigned long need = (unsigned long)(hist->total * percent / 100.0 + 0.5), seen = 0;
+    if (need == 0) need = 1;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= need) return hist_value(i) < hist->max_ns ? hist_value(i) : hist->max_ns;
+    }
+    return hist->max_ns;
+}
+
+// 구성표 한 줄: "<가중치> <tcp|http|history> <명령 또는 조회 문자열>"
+static int mix_add(const char* spec) {
+    char endpoint[16];
+    int weight, consumed = 0;
+
+    while (*spec == ' ') spec++;
+    if (*spec == '\0' || *spec == '#') return 0;
+    if (mix_count >= MAX_MIX) {
+        fprintf(stderr, "구성은 %d개까지\n", MAX_MIX);
+        return -1;
+    }
+    if (sscanf(spec, "%d %15s %n", &weight, endpoint, &consumed) != 2 || consumed == 0 || weight <= 0) {
+        fprintf(stderr, "잘못된 구성 '%s' (<가중치> <tcp|http|history> <명령>)\n", spec);
+        return -1;
+    }
+
+    mix_entry_t* entry = &mix[mix_count];
+    entry->endpoint = -1;
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(endpoint, endpoint_names[i]) == 0) entry->endpoint = i;
+    }
+    snprintf(entry->command, sizeof(entry->command), "%s", spec + consumed);
+    entry->command[strcspn(entry->command, "\r\n")] = '\0';
+    int len = strlen(entry->command);
+    while (len > 0 && entry->command[len - 1] == ' ') entry->command[--len] = '\0';
+    if (entry->endpoint < 0 || (entry->endpoint != EP_HISTORY && len == 0)) {
+        fprintf(stderr, "잘못된 구성 '%s'\n", spec);
+        return -1;
+    }
+    entry->weight = weight;
+    weight_total += weight;
+    mix_count++;
+    return 0;
+}
+
+// "a; b; c" 형식의 구성 문자열
+static int mix_parse(const char* text) {
+    char copy[4096];
+    snprintf(copy, sizeof(copy), "%s", text);
+    for (char* save = NULL, *item = strtok_r(copy, ";", &save); item; item = strtok_r(NULL, ";", &save)) {
+        if (mix_add(item) < 0) return -1;
+    }
+    return 0;
+}
+
+static int mix_load(const char* path) {
+    char line[512];
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "구성 파일 열기 실패: %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        if (mix_add(line) < 0) {
+            fclose(fp);
+            return -1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int open_connection(void) {
+    struct timeval timeout = {RECV_TIMEOUT_SEC, 0};
+    int opt = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static int send_all(int fd, const char* buf, int len) {
+    while (len > 0) {
+        int sent = send(fd, buf, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return -1;
+        buf += sent;
+        len -= sent;
+    }
+    return 0;
+}
+
+// TCP 응답 한 줄 (worker 버퍼 사용), 끊기거나 시간 초과면 -1
+static int read_line(worker_t* w, char* line, int size) {
+    for (;;) {
+        char* newline = memchr(w->buf + w->start, '\n', w->end - w->start);
+        if (newline) {
+            int len = newline - (w->buf + w->start);
+            int copy = len < size - 1 ? len : size - 1;
+            memcpy(line, w->buf + w->start, copy);
+            line[copy] = '\0';
+            w->start += len + 1;
+            return copy;
+        }
+        memmove(w->buf, w->buf + w->start, w->end - w->start);
+        w->end -= w->start;
+        w->start = 0;
+        if (w->end == IO_BUFFER_SIZE) w->end = 0;
+        int received = recv(w->fd, w->buf + w->end, IO_BUFFER_SIZE - w->end, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return -1;
+        w->end += received;
+    }
+}
+
+// TCP 명령: 연결을 유지하며 "명령\n" 전송, 빈 줄까지 응답 (첫 응답 앞에는 연결완료 인사)
+static int request_tcp(worker_t* w, const char* command) {
+    char line[IO_BUFFER_SIZE], out[MAX_BENCH_CMD + 2];
+    int greet = 0, failed = 0, first = 1;
+
+    if (w->fd < 0) {
+        w->fd = open_connection();
+        if (w->fd < 0) {
+            __atomic_fetch_add(&connect_errors, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        w->start = w->end = 0;
+        greet = 1;
+    }
+    int len = snprintf(out, sizeof(out), "%s\n", command);
+    if (send_all(w->fd, out, len) < 0 || (greet && read_line(w, line, sizeof(line)) < 0)) goto broken;
+    for (;;) {
+        if (read_line(w, line, sizeof(line)) < 0) goto broken;
+        if (line[0] == '\0') break;
+        if (first && strncmp(line, "ERROR", 5) == 0) failed = 1;
+        first = 0;
+    }
+    return failed ? -1 : 0;
+
+broken:
+    close(w->fd);
+    w->fd = -1;
+    return -1;
+}
+
+// HTTP 요청: 서버가 요청마다 연결을 닫으므로 새로 연결, 연결 종료까지 응답을 읽음
+static int request_http(worker_t* w, const char* request, const char* expect) {
+    int fd = open_connection();
+    if (fd < 0) {
+        __atomic_fetch_add(&connect_errors, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    int ok = send_all(fd, request, strlen(request)) == 0;
+    int len = 0;
+    while (ok) {
+        int received = recv(fd, w->buf + len, IO_BUFFER_SIZE - 1 - len, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0) ok = 0;
+        if (received <= 0) break;
+        len += received;
+        if (len >= IO_BUFFER_SIZE - 1024) len = 1024;   // 긴 응답은 앞부분만 남김 (상태 줄 확인용)
+    }
+    close(fd);
+    w->buf[len] = '\0';
+    return ok && strncmp(w->buf, "HTTP/1.1 200", 12) == 0 && (!expect || !strstr(w->buf, expect)) ? 0 : -1;
+}
+
+static int run_request(worker_t* w, const mix_entry_t* entry) {
+    char request[MAX_BENCH_CMD * 2 + 256];
+
+    if (entry->endpoint == EP_TCP) return request_tcp(w, entry->command);
+    if (entry->endpoint == EP_HTTP) {
+        char body[MAX_BENCH_CMD + 32];
+        int body_len = snprintf(body, sizeof(body), "{\"command\":\"%s\"}", entry->command);
+        snprintf(request, sizeof(request),
+                 "POST /api/command HTTP/1.1\r\nHost: bench\r\nContent-Type: application/json\r\n"
+                 "Content-Length: %d\r\n\r\n%s", body_len, body);
+        return request_http(w, request, "\"response\": \"ERROR");
+    }
+    snprintf(request, sizeof(request), "GET /api/history%s%s HTTP/1.1\r\nHost: bench\r\n\r\n",
+             entry->command[0] ? "?" : "", entry->command);
+    return request_http(w, request, NULL);
+}
+
+static void* worker_thread(void* arg) {
+    worker_t* w = arg;
+    long long interval_ns = rate > 0 ? (long long)(conns * 1e9 / rate) : 0;
+    // 열린 루프: 연결마다 예정 시각을 엇갈리게 두어 요청이 한꺼번에 몰리지 않게
+    long long intended = bench_start_ns + (interval_ns * w->id) / conns;
+
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        long long start;
+        if (interval_ns > 0) {
+            if (intended >= bench_end_ns) break;
+            struct timespec ts = {intended / 1000000000LL, intended % 1000000000LL};
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+            }
+            start = intended;   // 밀려서 늦게 보내도 원래 예정 시각부터 측정
+            intended += interval_ns;
+        } else {
+            start = now_ns();
+        }
+
+        int pick = rand_r(&w->seed) % weight_total, i = 0;
+        while (pick >= mix[i].weight) pick -= mix[i++].weight;
+        mix_entry_t* entry = &mix[i];
+
+        int result = run_request(w, entry);
+        long long done = now_ns();
+        if (start < record_start_ns || done > bench_end_ns) continue;   // 예열 구간과 끝난 뒤 응답은 제외
+
+        __atomic_fetch_add(&entry->requests, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&total_requests, 1, __ATOMIC_RELAXED);
+        if (result < 0) {
+            __atomic_fetch_add(&entry->errors, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&total_errors, 1, __ATOMIC_RELAXED);
+        }
+        hist_record(&entry->hist, done - start);
+        hist_record(&total_hist, done - start);
+    }
+    if (w->fd >= 0) close(w->fd);
+    return NULL;
+}
+
+static void print_table_row(const char* endpoint, const char* command, unsigned long requests, unsigned long errors,
+                            const histogram_t* hist) {
+    printf("%-8s %-24.24s %9lu %7lu %10.1f %9.3f %9.3f %9.3f %9.3f\n", endpoint, command, requests, errors,
+           requests / duration_sec, hist_percentile(hist, 50) / 1e6, hist_percentile(hist, 99) / 1e6,
+           hist_percentile(hist, 99.9) / 1e6, hist->max_ns / 1e6);
+}
+
+static void print_json_string(const char* text) {
+    putchar('"');
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') putchar('\\');
+        putchar(*text);
+    }
+    putchar('"');
+}
+
+static void print_json_result(unsigned long requests, unsigned long errors, const histogram_t* hist) {
+    printf("\"requests\": %lu, \"errors\": %lu, \"rps\": %.1f, \"p50_us\": %.1f, \"p99_us\": %.1f, "
+           "\"p999_us\": %.1f, \"max_us\": %.1f", requests, errors, requests / duration_sec,
+           hist_percentile(hist, 50) / 1e3, hist_percentile(hist, 99) / 1e3, hist_percentile(hist, 99.9) / 1e3,
+           hist->max_ns / 1e3);
+}
+
+static void print_usage(const char* program) {
+    printf("사용법: %s [-H 주소] [-p 포트] [-c 연결] [-d 초] [-w 예열초] [-r 요청/s] [-m 구성] [-f 구성파일] [-j]\n", program);
+    printf("  -c: 동시 연결(작업 스레드) 수 (기본 4, 서버 동시 접속 한도 64)\n");
+    printf("  -r: 전체 요청 속도, 지정하면 열린 루프 (기본 0 = 닫힌 루프)\n");
+    printf("  -m: \"<가중치> <tcp|http|history> <명령>; ...\" (예: \"8 tcp CDS_READ; 1 http LED_ON; 1 history from=-10m&res=1s\")\n");
+    printf("  -f: 구성 파일 (한 줄에 하나, # 주석)\n");
+    printf("  -j: 결과를 JSON 으로 출력\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* host = "127.0.0.1";
+    int port = 8080, json = 0, opt;
+
+    while ((opt = getopt(argc, argv, "H:p:c:d:w:r:m:f:jh")) != -1) {
+        switch (opt) {
+        case 'H': host = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 'c': conns = atoi(optarg); break;
+        case 'd': duration_sec = atof(optarg); break;
+        case 'w': warmup_sec = atof(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 'm': if (mix_parse(optarg) < 0) return 1; break;
+        case 'f': if (mix_load(optarg) < 0) return 1; break;
+        case 'j': json = 1; break;
+        default: print_usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (conns < 1 || conns > MAX_CONNS || duration_sec <= 0 || warmup_sec < 0 || rate < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    // 기본 구성: 조회 위주에 설정 명령과 HTTP 를 섞음 (장치 상태를 크게 바꾸지 않는 명령만)
+    if (mix_count == 0) {
+        mix_parse("6 tcp CDS_READ; 2 tcp LED_BRIGHTNESS 1; 1 tcp SEGMENT_DISPLAY 5; 1 tcp CDS_GET_STATUS; "
+                  "1 http CDS_READ; 1 http LED_PERCENT 40");
+    }
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &server_addr.sin_addr) <= 0) {
+        fprintf(stderr, "잘못된 주소: %s\n", host);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    static worker_t workers[MAX_CONNS];
+    pthread_t tids[MAX_CONNS];
+    bench_start_ns = now_ns();
+    record_start_ns = bench_start_ns + (long long)(warmup_sec * 1e9);
+    bench_end_ns = record_start_ns + (long long)(duration_sec * 1e9);
+
+    for (int i = 0; i < conns; i++) {
+        workers[i].id = i;
+        workers[i].fd = -1;
+        workers[i].seed = 12345u + i * 7919u;
+        pthread_create(&tids[i], NULL, worker_thread, &workers[i]);
+    }
+    long long remaining = bench_end_ns - now_ns();
+    struct timespec ts = {remaining / 1000000000LL, remaining % 1000000000LL};
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+    }
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < conns; i++) pthread_join(tids[i], NULL);
+
+    if (json) {
+        printf("{\n  \"host\": \"%s\", \"port\": %d, \"connections\": %d, \"mode\": \"%s\", \"rate\": %.1f,\n"
+               "  \"duration_s\": %.1f, \"warmup_s\": %.1f, \"connect_errors\": %lu,\n  \"results\": [\n",
+               host, port, conns, rate > 0 ? "open" : "closed", rate, duration_sec, warmup_sec, connect_errors);
+        for (int i = 0; i < mix_count; i++) {
+            printf("    {\"endpoint\": \"%s\", \"command\": ", endpoint_names[mix[i].endpoint]);
+            print_json_string(mix[i].command);
+            printf(", ");
+            print_json_result(mix[i].requests, mix[i].errors, &mix[i].hist);
+            printf("}%s\n", i + 1 < mix_count ? "," : "");
+        }
+        printf("  ],\n  \"total\": {");
+        print_json_result(total_requests, total_errors, &total_hist);
+        printf("}\n}\n");
+        return 0;
+    }
+
+    printf("iot_bench %s:%d, 연결 %d, %s, 측정 %.0fs (예열 %.0fs), 연결 실패 %lu\n\n", host, port, conns,
+           rate > 0 ? "열린 루프" : "닫힌 루프", duration_sec, warmup_sec, connect_errors);
+    if (rate > 0) printf("목표 속도 %.0f 요청/s (지연은 예정 시각부터)\n\n", rate);
+    printf("%-8s %-24s %9s %7s %10s %9s %9s %9s %9s\n", "endpoint", "command", "requests", "errors", "req/s",
+           "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    for (int i = 0; i < mix_count; i++) {
+        print_table_row(endpoint_names[mix[i].endpoint], mix[i].command, mix[i].requests, mix[i].errors, &mix[i].hist);
+    }
+    print_table_row("total", "", total_requests, total_errors, &total_hist);
+    return 0;
+}
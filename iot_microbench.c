@@ -0,0 +1,777 @@
+// 요청 처리 경로 단계별 마이크로벤치마크 (make bench)
+// main.c 의 내부 함수/표를 그대로 쓰기 위해 소스를 포함 (IOT_BENCH 로 main 제외)
+// 각 항목은 20ms 이상 걸리도록 반복 횟수를 맞춘 뒤 5번 재어 중앙값 ns/op 를 보고
+// -b 기준 JSON 과 회차 최솟값을 비교해 허용치(-t %)보다 느려진 항목이 있으면 종료 코드 1
+// 포화 상태의 비상 ALL_OFF p99 가 한도(-e us)를 넘어도 종료 코드 1
+#define _GNU_SOURCE
+#define IOT_BENCH
+#include "main.c"
+
+#define BENCH_MIN_NS 20000000LL      // 한 번 잴 때의 최소 길이
+#define BENCH_ROUNDS 5
+#define MAX_BENCH_RESULTS 128
+#define DEFAULT_TOLERANCE 25         // 기준 대비 허용 증가율 (%)
+#define CONTEND_MAX_THREADS 8
+#define DEFAULT_EMERGENCY_BOUND_US 20000   // 포화 상태 비상 ALL_OFF p99 한도
+
+typedef struct {
+    char name[64];
+    double ns_per_op;                // 중앙값
+    double min_ns;
+    long iterations;                 // 한 번 잴 때의 반복 횟수 (참고 항목은 표본 수)
+    int info;                        // 참고 항목 (꼬리 지연 등, 기준 비교 제외)
+} bench_result_t;
+
+typedef void (*bench_fn)(void* ctx, long iterations);
+
+static bench_result_t results[MAX_BENCH_RESULTS];
+static int result_count;
+static const char* bench_filter;
+static int saved_stdout = -1;
+
+static long long bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 측정 중에는 표준 출력을 /dev/null 로 돌림 (라이브러리 printf, 터미널일 때의 write_log 출력 제외)
+static void stdout_quiet(int quiet) {
+    fflush(stdout);
+    if (quiet && saved_stdout < 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        saved_stdout = dup(STDOUT_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    } else if (!quiet && saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+static void bench_run(const char* name, bench_fn fn, void* ctx) {
+    double rounds[BENCH_ROUNDS];
+    long n = 1;
+
+    if (bench_filter && !strstr(name, bench_filter)) return;
+    if (result_count == MAX_BENCH_RESULTS) return;
+
+    // 예열 후 한 번에 BENCH_MIN_NS 이상 걸리도록 반복 횟수 조정
+    fn(ctx, 1);
+    for (;;) {
+        long long start = bench_now_ns();
+        fn(ctx, n);
+        long long elapsed = bench_now_ns() - start;
+        if (elapsed >= BENCH_MIN_NS || n >= (1L << 30)) break;
+        long grow = elapsed > 0 ? (long)(BENCH_MIN_NS * 1.2 / elapsed * n) : n * 10;
+        n = grow > n * 10 ? n * 10 : grow > n ? grow : n + 1;
+    }
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        long long start = bench_now_ns();
+        fn(ctx, n);
+        rounds[r] = (double)(bench_now_ns() - start) / n;
+    }
+    qsort(rounds, BENCH_ROUNDS, sizeof(double), compare_double);
+
+    bench_result_t* res = &results[result_count++];
+    snprintf(res->name, sizeof(res->name), "%s", name);
+    res->ns_per_op = rounds[BENCH_ROUNDS / 2];
+    res->min_ns = rounds[0];
+    res->iterations = n;
+}
+
+// 표본 지연에서 <name>_p99, <name>_max 참고 항목 추가 (samples 를 정렬함)
+static void add_tail_results(const char* name, double* samples, int count) {
+    char tail_name[64];
+
+    qsort(samples, count, sizeof(double), compare_double);
+    const double values[2] = {samples[count * 99 / 100], samples[count - 1]};
+    const char* suffixes[2] = {"p99", "max"};
+    for (int k = 0; k < 2 && result_count < MAX_BENCH_RESULTS; k++) {
+        bench_result_t* res = &results[result_count++];
+        snprintf(tail_name, sizeof(tail_name), "%s_%s", name, suffixes[k]);
+        snprintf(res->name, sizeof(res->name), "%s", tail_name);
+        res->ns_per_op = res->min_ns = values[k];
+        res->iterations = count;
+        res->info = 1;
+    }
+}
+
+// ===== process_command: cmd_handlers[] 항목마다 =====
+
+// 처리기별 측정 명령, 없으면 이름 그대로 (sample 이 NULL 이면 지속되는 부작용이 있어 건너뜀)
+// 백그라운드 스레드를 남기는 명령은 측정 뒤 undo 로 되돌려 이후 항목의 잡음을 줄임
+static const struct {
+    const char* cmd;
+    const char* sample;
+    const char* skip_reason;
+    const char* undo;
+} dispatch_samples[] = {
+    {"LED_BRIGHTNESS", "LED_BRIGHTNESS 1", NULL, NULL},
+    {"LED_PERCENT", "LED_PERCENT 40", NULL, NULL},
+    {"LED_FADE", "LED_FADE 50 100", NULL, NULL},
+    {"LED_PATTERN", "LED_PATTERN blink", NULL, "LED_PATTERN_STOP"},
+    {"SEGMENT_DISPLAY", "SEGMENT_DISPLAY 7", NULL, NULL},
+    {"SEGMENT_COUNTDOWN", "SEGMENT_COUNTDOWN 9", NULL, "SEGMENT_STOP"},
+    {"BUZZER_PLAY", NULL, "멜로디 재생", NULL},
+    {"BUZZER_QUEUE", NULL, "멜로디 재생", NULL},
+    {"CDS_AUTO_START", "CDS_AUTO_START", NULL, "CDS_AUTO_STOP"},
+    {"CDS_SCAN_MODE", "CDS_SCAN_MODE off", NULL, NULL},
+    {"CDS_SENSOR_NAME", "CDS_SENSOR_NAME 0 light", NULL, NULL},
+    {"CDS_SENSOR", "CDS_SENSOR light", NULL, NULL},
+    {"CDS_SAMPLER_START", "CDS_SAMPLER_START 10", NULL, "CDS_SAMPLER_STOP"},
+    {"CDS_HYSTERESIS", "CDS_HYSTERESIS 128 10", NULL, NULL},
+    {"CDS_ADAPTIVE", "CDS_ADAPTIVE off", NULL, NULL},
+    {"CDS_TRACE_RECORD", NULL, "기록 파일 생성", NULL},
+    {"CDS_SAMPLES", "CDS_SAMPLES 10", NULL, NULL},
+    {"CDS_HISTORY", "CDS_HISTORY 0 1 1h", NULL, NULL},  // 빈 구간: 쌓인 이력 양과 무관한 조회 비용
+    {"CDS_STATS", "CDS_STATS 1m", NULL, NULL},
+    {"RULE_ADD", NULL, "규칙이 쌓임", NULL},
+    {"RULE_DEL", "RULE_DEL 9999", NULL, NULL},
+    {"EVENT_PUBLISH", "EVENT_PUBLISH user 1", NULL, NULL},
+    {"AT ", NULL, "예약 기록 파일에 남음", NULL},
+    {"EVERY", NULL, "예약 기록 파일에 남음", NULL},
+    {"SCHED_CANCEL", "SCHED_CANCEL 999999", NULL, NULL},
+    {"SCENE_DEFINE", "SCENE_DEFINE bench {LED_ON; LED_OFF}", NULL, NULL},
+    {"SCENE_RUN", "SCENE_RUN bench", NULL, NULL},
+    {"SCENE_DELETE", "SCENE_DELETE nonexistent", NULL, NULL},
+    {NULL, NULL, NULL, NULL}
+};
+
+static void bench_dispatch(void* ctx, long iterations) {
+    char response[MAX_RESPONSE_SIZE];
+    for (long i = 0; i < iterations; i++) process_command(ctx, response, sizeof(response));
+}
+
+static void bench_all_dispatch(void) {
+    char name[64], response[MAX_RESPONSE_SIZE];
+
+    for (int i = 0; cmd_handlers[i].cmd; i++) {
+        const char* sample = cmd_handlers[i].cmd;
+        const char* skip = NULL;
+        const char* undo = NULL;
+        for (int j = 0; dispatch_samples[j].cmd; j++) {
+            if (strcmp(dispatch_samples[j].cmd, cmd_handlers[i].cmd) == 0) {
+                sample = dispatch_samples[j].sample;
+                skip = dispatch_samples[j].skip_reason;
+                undo = dispatch_samples[j].undo;
+            }
+        }
+        snprintf(name, sizeof(name), "dispatch/%s", cmd_handlers[i].cmd);
+        name[strcspn(name, " ")] = '\0';
+        if (!sample) {
+            if (!bench_filter || strstr(name, bench_filter)) fprintf(stderr, "  %-32s 건너뜀 (%s)\n", name, skip);
+            continue;
+        }
+        bench_run(name, bench_dispatch, (void*)sample);
+        if (undo) process_command(undo, response, sizeof(response));
+    }
+    bench_run("dispatch/unknown", bench_dispatch, "NO_SUCH_COMMAND");
+}
+
+// ===== HTTP =====
+
+static void bench_is_http(void* ctx, long iterations) {
+    volatile int sink = 0;
+    for (long i = 0; i < iterations; i++) sink += is_http_request(ctx);
+    (void)sink;
+}
+
+// 전송은 잘못된 fd 로 곧바로 실패시켜 파싱/포맷 비용만 남김
+static void bench_http_request(void* ctx, long iterations) {
+    char request[BUFFER_SIZE];
+    for (long i = 0; i < iterations; i++) {
+        strcpy(request, ctx);
+        handle_http_request(-1, request);
+    }
+}
+
+static void bench_json_response(void* ctx, long iterations) {
+    for (long i = 0; i < iterations; i++) send_json_response(-1, "BENCH", ctx);
+}
+
+// ===== write_log =====
+
+static void bench_write_log(void* ctx, long iterations) {
+    (void)ctx;
+    for (long i = 0; i < iterations; i++) write_log("명령 응답: [%s] %d", "OK: LED 켜짐", (int)i);
+}
+
+// 포그라운드 + 터미널: 표준 출력을 의사 터미널로 돌리고 반대편은 스레드가 비움
+static void* pty_drain_thread(void* arg) {
+    char buf[4096];
+    int fd = (int)(long)arg;
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+    return NULL;
+}
+
+static void bench_write_log_tty(void) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    pthread_t tid;
+
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        fprintf(stderr, "  %-32s 건너뜀 (의사 터미널 없음)\n", "write_log/foreground_tty");
+        if (master >= 0) close(master);
+        return;
+    }
+    int slave = open(ptsname(master), O_WRONLY | O_NOCTTY);
+    if (slave < 0) {
+        close(master);
+        return;
+    }
+    pthread_create(&tid, NULL, pty_drain_thread, (void*)(long)master);
+    fflush(stdout);
+    int quiet_fd = dup(STDOUT_FILENO);
+    dup2(slave, STDOUT_FILENO);
+    bench_run("write_log/foreground_tty", bench_write_log, NULL);
+    fflush(stdout);
+    dup2(quiet_fd, STDOUT_FILENO);
+    close(quiet_fd);
+    close(slave);
+    close(master);
+    pthread_join(tid, NULL);
+}
+
+// ===== 장치 상태 뮤텍스 (make LOCK_STATS=1 로 빌드하면 계측 비용 포함) =====
+
+typedef struct {
+    device_state_t* state;
+    long iterations;
+    pthread_barrier_t* start;
+} contend_arg_t;
+
+static device_state_t bench_state = DEVICE_STATE_INITIALIZER("bench");
+static int contend_threads;
+
+static void bench_mutex(void* ctx, long iterations) {
+    device_state_t* state = ctx;
+    for (long i = 0; i < iterations; i++) {
+        device_lock(state);
+        state->is_initialized++;
+        device_unlock(state);
+    }
+}
+
+static void* contend_thread(void* arg) {
+    contend_arg_t* c = arg;
+    pthread_barrier_wait(c->start);
+    bench_mutex(c->state, c->iterations);
+    return NULL;
+}
+
+// 스레드 contend_threads 개가 같은 잠금을 각각 iterations 번 (ns/op 는 한 스레드가 본 한 번의 획득+해제)
+static void bench_mutex_contended(void* ctx, long iterations) {
+    pthread_t tids[CONTEND_MAX_THREADS];
+    contend_arg_t args[CONTEND_MAX_THREADS];
+    pthread_barrier_t start;
+
+    pthread_barrier_init(&start, NULL, contend_threads);
+    for (int t = 0; t < contend_threads; t++) {
+        args[t] = (contend_arg_t){ctx, iterations, &start};
+        pthread_create(&tids[t], NULL, contend_thread, &args[t]);
+    }
+    for (int t = 0; t < contend_threads; t++) pthread_join(tids[t], NULL);
+    pthread_barrier_destroy(&start);
+}
+
+// ===== 장치 스레드 대 이전 방식 (명령 처리기가 장치 잠금을 잡고 호출자 스레드에서 실행) =====
+
+#define MIX_MAX_CLIENTS 8
+#define MIX_TAIL_SAMPLES 8000
+
+static device_state_t locked_devices[DEVICE_COUNT] = {
+    DEVICE_STATE_INITIALIZER("locked/LED"), DEVICE_STATE_INITIALIZER("locked/SEGMENT"),
+    DEVICE_STATE_INITIALIZER("locked/BUZZER"), DEVICE_STATE_INITIALIZER("locked/CDS")
+};
+
+// 이전 lock_devices/unlock_devices: 낮은 비트부터 잡고 반대로 풀기
+static void locked_lock(unsigned int devices) {
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        if (devices & (1u << i)) device_lock(&locked_devices[i]);
+    }
+}
+
+static void locked_unlock(unsigned int devices) {
+    for (int i = DEVICE_COUNT - 1; i >= 0; i--) {
+        if (devices & (1u << i)) device_unlock(&locked_devices[i]);
+    }
+}
+
+// 이전 process_command
+static int locked_process_command(const char* command, char* response, int response_size) {
+    const cmd_handler_t* entry = find_handler(command);
+    if (!entry) {
+        snprintf(response, response_size, "ERROR: 알 수 없는 명령어 '%s'", command);
+        return 0;
+    }
+    locked_lock(entry->devices);
+    entry->handler(command, response, response_size);
+    locked_unlock(entry->devices);
+    return 0;
+}
+
+static void bench_lock_devices(void* ctx, long iterations) {
+    unsigned int devices = (unsigned int)(long)ctx;
+    for (long i = 0; i < iterations; i++) {
+        locked_lock(devices);
+        locked_unlock(devices);
+    }
+}
+
+static int actor_noop(void* arg) {
+    (void)arg;
+    return 0;
+}
+
+// 빈 요청을 장치 스레드로 보내고 완료를 기다림 (우편함 넣기 + 스레드 전환 비용)
+static void bench_actor_call(void* ctx, long iterations) {
+    unsigned int devices = (unsigned int)(long)ctx;
+    for (long i = 0; i < iterations; i++) device_actor_call(devices, actor_noop, NULL);
+}
+
+// 네 장치에 고르게 가는 가벼운 명령 (장치 상태를 바꾸지만 스레드를 남기지 않음)
+static const char* const mix_commands[] = {
+    "LED_BRIGHTNESS 1", "SEGMENT_DISPLAY 7", "BUZZER_STATUS", "CDS_HYSTERESIS 180 8"
+};
+#define MIX_COUNT (int)(sizeof(mix_commands) / sizeof(mix_commands[0]))
+
+typedef int (*command_fn)(const char* command, char* response, int response_size);
+
+typedef struct {
+    command_fn process;
+    int clients;
+} mix_config_t;
+
+typedef struct {
+    command_fn process;
+    long count;
+    int offset;
+    double* latencies;           // NULL 이면 지연을 재지 않음
+    pthread_barrier_t* start;
+} mix_arg_t;
+
+static void* mix_client_thread(void* arg) {
+    mix_arg_t* m = arg;
+    char response[MAX_RESPONSE_SIZE];
+
+    pthread_barrier_wait(m->start);
+    for (long i = 0; i < m->count; i++) {
+        const char* command = mix_commands[(m->offset + i) % MIX_COUNT];
+        if (m->latencies) {
+            long long start = bench_now_ns();
+            m->process(command, response, sizeof(response));
+            m->latencies[i] = (double)(bench_now_ns() - start);
+        } else {
+            m->process(command, response, sizeof(response));
+        }
+    }
+    return NULL;
+}
+
+// 클라이언트 스레드 clients 개가 명령 iterations 개를 나눠 보냄 (latencies 가 있으면 명령마다 지연 기록)
+static void mix_run(const mix_config_t* config, long iterations, double* latencies) {
+    pthread_t tids[MIX_MAX_CLIENTS];
+    mix_arg_t args[MIX_MAX_CLIENTS];
+    pthread_barrier_t start;
+    long per_client = iterations / config->clients, done = 0;
+
+    pthread_barrier_init(&start, NULL, config->clients);
+    for (int t = 0; t < config->clients; t++) {
+        long count = t == config->clients - 1 ? iterations - done : per_client;
+        args[t] = (mix_arg_t){config->process, count, t, latencies ? latencies + done : NULL, &start};
+        done += count;
+        pthread_create(&tids[t], NULL, mix_client_thread, &args[t]);
+    }
+    for (int t = 0; t < config->clients; t++) pthread_join(tids[t], NULL);
+    pthread_barrier_destroy(&start);
+}
+
+// ns/op 는 전체 명령 하나당 경과 시간 (처리량의 역수)
+static void bench_mix(void* ctx, long iterations) {
+    mix_run(ctx, iterations < MIX_MAX_CLIENTS ? MIX_MAX_CLIENTS : iterations, NULL);
+}
+
+static void bench_mix_tail(const char* name, const mix_config_t* config) {
+    static double samples[MIX_TAIL_SAMPLES];
+
+    if (bench_filter && !strstr(name, bench_filter)) return;
+    mix_run(config, MIX_TAIL_SAMPLES, samples);
+    add_tail_results(name, samples, MIX_TAIL_SAMPLES);
+}
+
+static void bench_all_actor(void) {
+    static const struct {
+        const char* prefix;
+        command_fn process;
+    } designs[] = {
+        {"locked", locked_process_command},
+        {"actor", process_command},
+    };
+    static const int client_counts[] = {1, MIX_MAX_CLIENTS};
+    char name[64];
+
+    bench_run("actor/call_one", bench_actor_call, (void*)(long)DEV_LED);
+    bench_run("actor/call_all", bench_actor_call, (void*)(long)DEV_ALL);
+    for (size_t d = 0; d < sizeof(designs) / sizeof(designs[0]); d++) {
+        for (size_t c = 0; c < sizeof(client_counts) / sizeof(client_counts[0]); c++) {
+            mix_config_t config = {designs[d].process, client_counts[c]};
+            snprintf(name, sizeof(name), "%s/mix_clients_%d", designs[d].prefix, client_counts[c]);
+            bench_run(name, bench_mix, &config);
+            bench_mix_tail(name, &config);
+        }
+    }
+}
+
+// ===== 비상 명령: 장치 우편함이 가득 찬 상태에서 ALL_OFF 지연 =====
+
+#define FLOOD_WORK_NS 50000          // 밀어 넣는 요청 하나의 길이 (느린 장치 쓰기 + 로그 흉내)
+#define ALL_OFF_SAMPLES 200
+
+static volatile int flood_running;
+static double emergency_saturated_p99 = -1;
+
+// 바쁜 대기로 FLOOD_WORK_NS 동안 장치 스레드를 붙잡음
+static int flood_work(void* arg) {
+    (void)arg;
+    long long end = bench_now_ns() + FLOOD_WORK_NS;
+    while (bench_now_ns() < end) {
+    }
+    return 0;
+}
+
+// 장치 하나의 일반 통로를 계속 채움 (완료를 기다리지 않으므로 우편함이 가득 차면 빈 칸을 기다림)
+static void* flood_thread(void* arg) {
+    int device = (int)(long)arg;
+    while (flood_running) device_actor_post(device, flood_work, NULL, NULL);
+    return NULL;
+}
+
+// 비상 통로 이전 방식: 일반 통로로 모든 장치를 멈춰 세운 뒤 정지 (대기 중인 요청을 모두 기다림)
+static int fifo_all_off(void* arg) {
+    (void)arg;
+    for (int d = 0; d < DEVICE_COUNT; d++) device_stop(d);
+    return 0;
+}
+
+static void all_off_once(int fifo) {
+    char response[MAX_RESPONSE_SIZE];
+    if (fifo) {
+        device_actor_call(DEV_ALL, fifo_all_off, NULL);
+    } else {
+        process_command("ALL_OFF", response, sizeof(response));
+    }
+}
+
+// saturated 면 장치마다 밀어 넣는 스레드를 두고 ALL_OFF 를 ALL_OFF_SAMPLES 번 재어 p50/p99/최대를 참고 항목으로 추가
+static void bench_all_off(const char* name, int fifo, int saturated) {
+    static double samples[ALL_OFF_SAMPLES];
+    pthread_t flooders[DEVICE_COUNT];
+    char p50_name[64];
+
+    if (bench_filter && !strstr(name, bench_filter)) return;
+    if (saturated) {
+        flood_running = 1;
+        for (int d = 0; d < DEVICE_COUNT; d++) pthread_create(&flooders[d], NULL, flood_thread, (void*)(long)d);
+    }
+    for (int i = 0; i < ALL_OFF_SAMPLES; i++) {
+        usleep(2000);                // 우편함이 다시 찰 시간
+        long long start = bench_now_ns();
+        all_off_once(fifo);
+        samples[i] = (double)(bench_now_ns() - start);
+    }
+    if (saturated) {
+        flood_running = 0;
+        for (int d = 0; d < DEVICE_COUNT; d++) pthread_join(flooders[d], NULL);
+        device_actor_call(DEV_ALL, actor_noop, NULL);   // 남은 요청 비우기
+    }
+
+    qsort(samples, ALL_OFF_SAMPLES, sizeof(double), compare_double);
+    if (result_count < MAX_BENCH_RESULTS) {
+        bench_result_t* res = &results[result_count++];
+        snprintf(p50_name, sizeof(p50_name), "%s_p50", name);
+        snprintf(res->name, sizeof(res->name), "%s", p50_name);
+        res->ns_per_op = res->min_ns = samples[ALL_OFF_SAMPLES / 2];
+        res->iterations = ALL_OFF_SAMPLES;
+        res->info = 1;
+    }
+    if (!fifo && saturated) emergency_saturated_p99 = samples[ALL_OFF_SAMPLES * 99 / 100];
+    add_tail_results(name, samples, ALL_OFF_SAMPLES);
+}
+
+static void bench_all_emergency(void) {
+    bench_all_off("emergency/all_off_idle", 0, 0);
+    bench_all_off("emergency/all_off_saturated", 0, 1);
+    bench_all_off("fifo/all_off_saturated", 1, 1);
+}
+
+// ===== 상태 조회 함수: 유휴 / 샘플러와 버스 읽기, LED 쓰기가 몰릴 때 =====
+
+#define GETTER_SAMPLES 20000
+#define GETTER_SAMPLER_HZ 500
+
+static volatile int getter_load_running;
+
+static void bench_getter_int(void* ctx, long iterations) {
+    int (*getter)(void) = *(int (**)(void))ctx;
+    volatile int sink = 0;
+    for (long i = 0; i < iterations; i++) sink += getter();
+    (void)sink;
+}
+
+static void bench_getter_status(void* ctx, long iterations) {
+    int (*getter)(char*, int) = *(int (**)(char*, int))ctx;
+    char buf[256];
+    for (long i = 0; i < iterations; i++) getter(buf, sizeof(buf));
+}
+
+// 호출마다 시간을 재어 p99/최대를 참고 항목으로 추가 (시각 읽기 비용 포함)
+static void bench_tail(const char* name, bench_fn fn, void* ctx) {
+    static double samples[GETTER_SAMPLES];
+
+    if (bench_filter && !strstr(name, bench_filter)) return;
+    for (int i = 0; i < GETTER_SAMPLES; i++) {
+        long long start = bench_now_ns();
+        fn(ctx, 1);
+        samples[i] = (double)(bench_now_ns() - start);
+    }
+    add_tail_results(name, samples, GETTER_SAMPLES);
+}
+
+// 버스 부하: 매번 새로 측정하는 조도 읽기 (캐시 없이 I2C 트랜잭션)
+static void* getter_bus_load_thread(void* arg) {
+    (void)arg;
+    while (getter_load_running) device_funcs.cds.read();
+    return NULL;
+}
+
+// 쓰기 부하: LED 밝기를 계속 바꿈 (PWM 쓰기 + 상태 갱신)
+static void* getter_led_load_thread(void* arg) {
+    (void)arg;
+    for (int i = 0; getter_load_running; i++) device_funcs.led.set_percent(i % 101);
+    return NULL;
+}
+
+static void bench_getters(const char* phase) {
+    static const struct {
+        const char* name;
+        bench_fn fn;
+        void* getter;
+    } getters[] = {
+        {"cds_get_value", bench_getter_int, &device_funcs.cds.get_value},
+        {"cds_is_bright", bench_getter_int, &device_funcs.cds.is_bright},
+        {"cds_get_status", bench_getter_status, &device_funcs.cds.get_status},
+        {"led_get_status", bench_getter_status, &device_funcs.led.get_status},
+        {"segment_get_status", bench_getter_status, &device_funcs.segment.get_status},
+        {"buzzer_get_status", bench_getter_status, &device_funcs.buzzer.get_status},
+    };
+    char name[64];
+
+    for (size_t i = 0; i < sizeof(getters) / sizeof(getters[0]); i++) {
+        if (!*(void**)getters[i].getter) continue;
+        snprintf(name, sizeof(name), "getter/%s/%s", phase, getters[i].name);
+        bench_run(name, getters[i].fn, getters[i].getter);
+        bench_tail(name, getters[i].fn, getters[i].getter);
+    }
+}
+
+static void bench_all_getters(void) {
+    pthread_t bus_tid, led_tid;
+
+    bench_getters("idle");
+
+    // 샘플러 최대 주기 + 버스 읽기 스레드 + LED 쓰기 스레드
+    if (!device_funcs.cds.sampler_start || !device_funcs.cds.read || !device_funcs.led.set_percent) return;
+    device_funcs.cds.sampler_start(GETTER_SAMPLER_HZ);
+    getter_load_running = 1;
+    pthread_create(&bus_tid, NULL, getter_bus_load_thread, NULL);
+    pthread_create(&led_tid, NULL, getter_led_load_thread, NULL);
+    bench_getters("busy");
+    getter_load_running = 0;
+    pthread_join(bus_tid, NULL);
+    pthread_join(led_tid, NULL);
+    device_funcs.cds.sampler_stop();
+    device_funcs.led.off();
+}
+
+// ===== 기준 비교 =====
+
+static void write_results_json(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "결과 파일 쓰기 실패: %s\n", path);
+        return;
+    }
+    fprintf(fp, "{\"results\": [\n");
+    for (int i = 0; i < result_count; i++) {
+        fprintf(fp, "  {\"name\": \"%s\", \"ns_per_op\": %.1f, \"min_ns\": %.1f, \"iterations\": %ld}%s\n",
+                results[i].name, results[i].ns_per_op, results[i].min_ns, results[i].iterations,
+                i + 1 < result_count ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+    fclose(fp);
+}
+
+// write_results_json 형식에서 name 의 min_ns, 없으면 -1
+// 비교는 회차 최솟값으로 함 (공유 장비에서 다른 프로세스에 밀린 회차가 중앙값까지 끌어올리는 경우가 잦음)
+static double baseline_lookup(const char* json, const char* name) {
+    char key[96];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char* pos = strstr(json, key);
+    if (!pos) return -1;
+    pos = strstr(pos, "\"min_ns\":");
+    return pos ? atof(pos + strlen("\"min_ns\":")) : -1;
+}
+
+static char* read_text_file(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* text = malloc(length + 1);
+    if (text) text[fread(text, 1, length, fp)] = '\0';
+    fclose(fp);
+    return text;
+}
+
+// 결과 표 출력, 기준이 있으면 변화율과 회귀 표시, 회귀 항목 수 반환
+static int print_results(const char* baseline_path, int tolerance) {
+    char* baseline = baseline_path ? read_text_file(baseline_path) : NULL;
+    int regressions = 0;
+
+    if (baseline_path && !baseline) fprintf(stderr, "기준 파일 읽기 실패: %s\n", baseline_path);
+    printf("%-34s %12s %12s %10s%s\n", "benchmark", "ns/op", "min", "iters", baseline ? "   base min   change" : "");
+    for (int i = 0; i < result_count; i++) {
+        const bench_result_t* r = &results[i];
+        printf("%-34s %12.1f %12.1f %10ld", r->name, r->ns_per_op, r->min_ns, r->iterations);
+        double base = baseline && !r->info ? baseline_lookup(baseline, r->name) : -1;
+        if (r->info) {
+            if (baseline) printf(" %10s", "(참고)");
+        } else if (base > 0) {
+            double change = (r->min_ns - base) * 100.0 / base;
+            int regressed = change > tolerance;
+            regressions += regressed;
+            printf(" %10.1f %+7.1f%%%s", base, change, regressed ? "  REGRESSION" : "");
+        } else if (baseline) {
+            printf(" %10s", "-");
+        }
+        printf("\n");
+    }
+    if (baseline) {
+        printf("\n기준 %s 대비 %d%% 넘게 느려진 항목 %d개\n", baseline_path, tolerance, regressions);
+    }
+    free(baseline);
+    return regressions;
+}
+
+static void print_usage(const char* program) {
+    printf("사용법: %s [-f <이름 일부>] [-j <결과.json>] [-b <기준.json>] [-t <허용 %%>] [-e <한도 us>]\n", program);
+    printf("  -f: 이름에 문자열이 들어간 항목만 (예: dispatch/, getter/, actor/, locked/, emergency/, fifo/, http, write_log, mutex)\n");
+    printf("  -j: 결과를 JSON 으로 저장 (기준 파일로 그대로 사용 가능)\n");
+    printf("  -b: 기준 JSON 과 최솟값 비교, 허용치(-t, 기본 %d%%)보다 느려진 항목이 있으면 종료 코드 1\n", DEFAULT_TOLERANCE);
+    printf("  -e: 우편함이 가득 찬 상태의 비상 ALL_OFF p99 한도 (기본 %dus), 넘으면 종료 코드 1\n", DEFAULT_EMERGENCY_BOUND_US);
+    printf("장치 라이브러리(./lib*.so)가 있는 디렉토리에서 실행\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    int tolerance = DEFAULT_TOLERANCE;
+    int emergency_bound_us = DEFAULT_EMERGENCY_BOUND_US;
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            bench_filter = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            tolerance = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            emergency_bound_us = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 ? 0 : 1;
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "요청 경로 마이크로벤치마크 (CPU %d개, 항목당 %dms 이상 x %d회 중앙값)\n", ncpu,
+            (int)(BENCH_MIN_NS / 1000000), BENCH_ROUNDS);
+
+    stdout_quiet(1);
+    if (load_device_libraries() < 0) {
+        stdout_quiet(0);
+        fprintf(stderr, "동적 라이브러리 로딩 실패 (장치 라이브러리가 있는 디렉토리에서 실행)\n");
+        return 1;
+    }
+    dev_clock_bind(led_lib);
+    if (device_funcs.led.init) device_funcs.led.init();
+    if (device_funcs.segment.init) device_funcs.segment.init();
+    if (device_funcs.buzzer.init) device_funcs.buzzer.init();
+    if (device_funcs.cds.init) device_funcs.cds.init();
+    device_actor_start(device_names, DEVICE_COUNT);
+
+    bench_all_dispatch();
+    bench_all_getters();
+
+    bench_run("http/is_http_request_cmd", bench_is_http, "CDS_READ");
+    bench_run("http/is_http_request_post", bench_is_http, "POST /api/command HTTP/1.1");
+    bench_run("http/handle_options", bench_http_request, "OPTIONS /api/command HTTP/1.1\r\nHost: pi\r\n\r\n");
+    bench_run("http/handle_post_command", bench_http_request,
+              "POST /api/command HTTP/1.1\r\nHost: pi\r\nContent-Type: application/json\r\n\r\n"
+              "{\"command\": \"EVENT_STATS\"}");
+    bench_run("http/handle_not_found", bench_http_request, "GET /nothing HTTP/1.1\r\nHost: pi\r\n\r\n");
+
+    char help[MAX_RESPONSE_SIZE];
+    handle_help("HELP", help, sizeof(help));
+    bench_run("json/escape_short", bench_json_response, "OK: LED 켜짐");
+    bench_run("json/escape_help", bench_json_response, help);
+
+    daemon_mode = 0;
+    bench_run("write_log/foreground", bench_write_log, NULL);
+    if (!bench_filter || strstr("write_log/foreground_tty", bench_filter)) bench_write_log_tty();
+    openlog("iot_microbench", LOG_CONS, LOG_DAEMON);
+    daemon_mode = 1;
+    bench_run("write_log/daemon_syslog", bench_write_log, NULL);
+    daemon_mode = 0;
+    closelog();
+
+    bench_run("mutex/device_state_uncontended", bench_mutex, &bench_state);
+    for (contend_threads = 2; contend_threads <= CONTEND_MAX_THREADS && contend_threads <= ncpu * 2; contend_threads *= 2) {
+        char name[64];
+        snprintf(name, sizeof(name), "mutex/device_state_contended_%d", contend_threads);
+        bench_run(name, bench_mutex_contended, &bench_state);
+    }
+    bench_run("mutex/lock_devices_one", bench_lock_devices, (void*)(long)DEV_LED);
+    bench_run("mutex/lock_devices_all", bench_lock_devices, (void*)(long)DEV_ALL);
+    bench_all_actor();
+    bench_all_emergency();
+
+    // 정리 (main 의 종료 순서와 같음)
+    device_actor_stop();
+    if (device_funcs.led.cleanup) device_funcs.led.cleanup();
+    if (device_funcs.segment.cleanup) device_funcs.segment.cleanup();
+    if (device_funcs.buzzer.cleanup) device_funcs.buzzer.cleanup();
+    if (device_funcs.cds.cleanup) device_funcs.cds.cleanup();
+    unload_device_libraries();
+    stdout_quiet(0);
+
+    int regressions = print_results(baseline_path, tolerance);
+    if (json_path) write_results_json(json_path);
+    int over_bound = emergency_saturated_p99 > emergency_bound_us * 1000.0;
+    if (emergency_saturated_p99 >= 0) {
+        printf("포화 상태 비상 ALL_OFF p99 %.1fus (한도 %dus)%s\n", emergency_saturated_p99 / 1000.0, emergency_bound_us,
+               over_bound ? "  한도 초과" : "");
+    }
+    return regressions > 0 || over_bound ? 1 : 0;
+}
@@ -1,168 +1,807 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/resource.h>
 #include <wiringPi.h>
 #include <softTone.h>
 #include "control_device.h"
+#include "dev_clock.h"
+#include "seqlock.h"
 
 #define BUZZER_PIN 19
-#define TOTAL_NOTES 32
-
-// 학교종 멜로디 (기존 코드와 동일)
-static int school_bell_notes[] = {
-    391, 391, 440, 440, 391, 391, 329.63, 329.63,
-    391, 391, 329.63, 329.63, 293.66, 293.66, 293.66, 0,
-    391, 391, 440, 440, 391, 391, 329.63, 329.63,
-    391, 329.63, 293.66, 329.63, 261.63, 261.63, 261.63, 0
+#define MELODY_NAME_SIZE 32
+#define MELODY_MAX_NOTES 128
+#define MELODY_CACHE_SIZE 16
+#define DEFAULT_MELODY "school_bell"
+#define BUZZER_QUEUE_SIZE 16
+
+// 학교종 멜로디 (기존 280ms 음 길이 = 4분음표 @ 214bpm)
+static const char* builtin_melodies[] = {
+    "school_bell:d=4,o=4,b=214:g,g,a,a,g,g,e,e,g,g,e,e,d,d,d,p,g,g,a,a,g,g,e,e,g,e,d,e,c,c,c,p",
+    "click:d=32,o=6,b=120:c",
+    "notify:d=16,o=6,b=140:e,g,8c7",
+    "alarm:d=8,o=6,b=200:a,p,a,p,a,p,a,p,a,p,a,p",
+    NULL
 };
 
+// 4옥타브 음계 주파수 (Hz x 100, 평균율 A4 = 440Hz)
+static const unsigned int octave4_centihz[12] = {
+    26163, 27718, 29366, 31113, 32963, 34923, 36999, 39200, 41530, 44000, 46616, 49388
+};
+
+// 미리 컴파일된 음표 (주파수 0 = 쉼표)
+typedef struct {
+    unsigned int freq_centihz;
+    unsigned int duration_ms;
+} melody_note_t;
+
+typedef struct {
+    char name[MELODY_NAME_SIZE];
+    int note_count;
+    unsigned int hash;               // 음표 배열 해시 (같은 이름의 다른 멜로디를 합치지 않게)
+    melody_note_t notes[MELODY_MAX_NOTES];
+} melody_t;
+
+// 이름별 멜로디 캐시: 내장 멜로디는 고정, 사용자 멜로디는 가득 차면 가장 오래 쓰지 않은 것부터 버림
+typedef struct {
+    melody_t melody;
+    int builtin;
+    unsigned long last_used;         // melody_clock 값 (클수록 최근)
+} melody_entry_t;
+
+static melody_entry_t melody_cache[MELODY_CACHE_SIZE];
+static int melody_count = 0;
+static unsigned long melody_clock = 0;
+
+// 재생 요청 (멜로디 사본을 가지므로 대기 중에 캐시가 바뀌어도 안전)
+typedef struct {
+    melody_t melody;
+    int priority;                    // BUZZER_PRIO_*
+    int next_note;                   // 선점되었을 때 재개할 음표 위치
+    unsigned int remaining_ms;       // 선점된 음표의 남은 길이 (0 이면 처음부터)
+    unsigned long seq;               // 같은 우선순위 안에서의 도착 순서
+} sound_request_t;
+
+// 우선순위 대기열과 현재 재생 중인 요청
+static sound_request_t sound_queue[BUZZER_QUEUE_SIZE];
+static int queue_len = 0;
+static sound_request_t current;
+static int has_current = 0;
+static int stop_requested = 0;
+static unsigned long next_seq = 0;
+static unsigned long merged_count = 0;
+static unsigned long preempted_count = 0;
+static unsigned long dropped_count = 0;    // 대기열이 가득 차 더 높은 우선순위 요청에 밀려난 요청
+
 // 부저 상태 관리
-static device_state_t buzzer_state = {0, PTHREAD_MUTEX_INITIALIZER};
-static pthread_t music_thread_id = 0;
-static int is_playing = 0;
+static device_state_t buzzer_state = DEVICE_STATE_INITIALIZER("buzzer");
+static pthread_cond_t play_cond;
+static pthread_t worker_tid;
 static int running = 1;
 
-// 학교종 멜로디 재생 스레드
-void* melody_thread(void *arg) {
-    (void)arg;
+static const char* priority_names[] = {"click", "notify", "alarm"};
+
+// 상태 조회용 공개 사본: buzzer_state 를 잡고 상태를 바꾼 쪽이 buzzer_publish, 조회는 잠금 없이 복사
+typedef struct {
+    int initialized;
+    int playing;
+    char melody[MELODY_NAME_SIZE];
+    int priority;
+    const char* backend;             // 백엔드 표의 이름 (바뀌지 않는 문자열)
+    int queue_len;
+    unsigned long merged;
+    unsigned long preempted;
+    unsigned long dropped;
+} buzzer_public_t;
+
+static seqlock_t buzzer_public_seq;
+static buzzer_public_t buzzer_public;
+
+// 하드웨어 PWM 톤 출력 (커널 PWM sysfs, GPIO 19 = PWM0 채널 1)
+// /boot/config.txt 에 dtoverlay=pwm,pin=19,func=2 필요, 없으면 softTone 으로 대체
+#ifndef BUZZER_PWM_CHIP
+#define BUZZER_PWM_CHIP "/sys/class/pwm/pwmchip0"
+#endif
+#ifndef BUZZER_PWM_CHANNEL
+#define BUZZER_PWM_CHANNEL 1
+#endif
+
+// 톤 출력 백엔드
+typedef struct {
+    const char* name;
+    int (*init)(void);
+    void (*start)(void);                         // 재생 시작 전
+    void (*tone)(unsigned int freq_centihz);     // 0 = 무음
+    void (*stop)(void);                          // 재생 종료 후
+    void (*cleanup)(void);
+} tone_backend_t;
+
+static int pwm_period_fd = -1, pwm_duty_fd = -1, pwm_enable_fd = -1;
+static long pwm_period_ns = 0;
+
+static int pwm_sysfs_write(int fd, long value) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%ld", value);
+    return pwrite(fd, buf, len, 0) == len ? 0 : -1;
+}
+
+static int pwm_sysfs_open(const char* attr) {
+    char path[128];
+    snprintf(path, sizeof(path), BUZZER_PWM_CHIP "/pwm%d/%s", BUZZER_PWM_CHANNEL, attr);
+    return open(path, O_WRONLY);
+}
+
+static int pwm_backend_init(void) {
+    char path[128];
+    snprintf(path, sizeof(path), BUZZER_PWM_CHIP "/pwm%d", BUZZER_PWM_CHANNEL);
+
+    if (access(path, F_OK) != 0) {
+        int fd = open(BUZZER_PWM_CHIP "/export", O_WRONLY);
+        if (fd < 0) return -1;
+        pwm_sysfs_write(fd, BUZZER_PWM_CHANNEL);
+        close(fd);
+        // udev 가 속성 파일 권한을 설정할 때까지 잠시 대기
+        for (int i = 0; i < 10 && access(path, F_OK) != 0; i++) delay(10);
+    }
+
+    pwm_period_fd = pwm_sysfs_open("period");
+    pwm_duty_fd = pwm_sysfs_open("duty_cycle");
+    pwm_enable_fd = pwm_sysfs_open("enable");
+    if (pwm_period_fd < 0 || pwm_duty_fd < 0 || pwm_enable_fd < 0) {
+        if (pwm_period_fd >= 0) close(pwm_period_fd);
+        if (pwm_duty_fd >= 0) close(pwm_duty_fd);
+        if (pwm_enable_fd >= 0) close(pwm_enable_fd);
+        pwm_period_fd = pwm_duty_fd = pwm_enable_fd = -1;
+        return -1;
+    }
+    pwm_period_ns = 0;
+    return 0;
+}
+
+static void pwm_backend_start(void) {
+    pwm_sysfs_write(pwm_duty_fd, 0);
+    pwm_sysfs_write(pwm_enable_fd, 1);
+}
+
+// 주기/듀티(50%)를 직접 설정, 듀티는 항상 주기 이하여야 하므로 먼저 0 으로 내림
+static void pwm_backend_tone(unsigned int freq_centihz) {
+    if (freq_centihz == 0) {
+        pwm_sysfs_write(pwm_duty_fd, 0);
+        return;
+    }
+
+    long period = 100000000000L / freq_centihz;
+    if (period != pwm_period_ns) {
+        pwm_sysfs_write(pwm_duty_fd, 0);
+        pwm_sysfs_write(pwm_period_fd, period);
+        pwm_period_ns = period;
+    }
+    pwm_sysfs_write(pwm_duty_fd, period / 2);
+}
+
+static void pwm_backend_stop(void) {
+    pwm_sysfs_write(pwm_duty_fd, 0);
+    pwm_sysfs_write(pwm_enable_fd, 0);
+}
+
+static void pwm_backend_cleanup(void) {
+    pwm_backend_stop();
+    close(pwm_period_fd);
+    close(pwm_duty_fd);
+    close(pwm_enable_fd);
+    pwm_period_fd = pwm_duty_fd = pwm_enable_fd = -1;
+}
+
+// softTone 대체 경로: 비트뱅 스레드는 재생 중에만 유지
+static int softtone_backend_init(void) {
+    pinMode(BUZZER_PIN, OUTPUT);
+    digitalWrite(BUZZER_PIN, LOW);
+    return 0;
+}
+
+static void softtone_backend_start(void) {
+    softToneCreate(BUZZER_PIN);
+}
+
+static void softtone_backend_tone(unsigned int freq_centihz) {
+    softToneWrite(BUZZER_PIN, (freq_centihz + 50) / 100);
+}
+
+static void softtone_backend_stop(void) {
+    softToneWrite(BUZZER_PIN, 0);
+    softToneStop(BUZZER_PIN);
+}
+
+static void softtone_backend_cleanup(void) {
+    digitalWrite(BUZZER_PIN, LOW);
+}
 
-    pthread_mutex_lock(&buzzer_state.mutex);
-    is_playing = 1;
-    pthread_mutex_unlock(&buzzer_state.mutex);
+static const tone_backend_t tone_backends[] = {
+    {"pwm", pwm_backend_init, pwm_backend_start, pwm_backend_tone, pwm_backend_stop, pwm_backend_cleanup},
+    {"softtone", softtone_backend_init, softtone_backend_start, softtone_backend_tone,
+     softtone_backend_stop, softtone_backend_cleanup},
+    {NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+static const tone_backend_t* backend = NULL;
+
+// buzzer_state.mutex 를 잡은 상태에서 호출
+static void buzzer_publish(void) {
+    seqlock_write_begin(&buzzer_public_seq);
+    buzzer_public.initialized = buzzer_state.is_initialized;
+    buzzer_public.playing = has_current;
+    if (has_current) {
+        memcpy(buzzer_public.melody, current.melody.name, sizeof(buzzer_public.melody));
+        buzzer_public.priority = current.priority;
+    }
+    buzzer_public.backend = backend ? backend->name : "없음";
+    buzzer_public.queue_len = queue_len;
+    buzzer_public.merged = merged_count;
+    buzzer_public.preempted = preempted_count;
+    buzzer_public.dropped = dropped_count;
+    seqlock_write_end(&buzzer_public_seq);
+}
 
-    printf("[BUZZER] 학교종 멜로디 재생 시작\n");
+// CPU 사용량 측정 (이전 조회 이후 구간의 프로세스 CPU 사용률)
+static struct timespec cpu_sample_wall;
+static double cpu_sample_sec = -1.0;
+
+// RTTTL 파싱: "name:d=4,o=5,b=120:8c6,8p,4e.,..."
+static int melody_parse_rtttl(const char* text, melody_t* out) {
+    const char* p = strchr(text, ':');
+    if (!p || p == text || p - text >= MELODY_NAME_SIZE) return -1;
+
+    memset(out, 0, sizeof(*out));
+    memcpy(out->name, text, p - text);
+    p++;
+
+    // 기본값 섹션
+    int def_dur = 4, def_oct = 6, bpm = 63;
+    while (*p && *p != ':') {
+        while (*p == ' ' || *p == ',') p++;
+        char key = tolower((unsigned char)*p);
+        if (key && p[1] == '=') {
+            int val = atoi(p + 2);
+            if (key == 'd') def_dur = val;
+            else if (key == 'o') def_oct = val;
+            else if (key == 'b') bpm = val;
+            p += 2;
+        }
+        while (*p && *p != ',' && *p != ':') p++;
+    }
+    if (*p != ':' || bpm <= 0 || def_dur <= 0 || def_oct < 1 || def_oct > 8) return -1;
+    p++;
+
+    int whole_ms = 60000 * 4 / bpm;
+
+    // 음표 섹션
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (!*p) break;
+        if (out->note_count >= MELODY_MAX_NOTES) return -1;
+
+        int dur = def_dur, oct = def_oct, dotted = 0, semitone;
+        if (isdigit((unsigned char)*p)) {
+            dur = 0;
+            while (isdigit((unsigned char)*p)) dur = dur * 10 + (*p++ - '0');
+            if (dur <= 0) return -1;
+        }
+
+        switch (tolower((unsigned char)*p)) {
+            case 'c': semitone = 0; break;
+            case 'd': semitone = 2; break;
+            case 'e': semitone = 4; break;
+            case 'f': semitone = 5; break;
+            case 'g': semitone = 7; break;
+            case 'a': semitone = 9; break;
+            case 'b': case 'h': semitone = 11; break;
+            case 'p': semitone = -1; break;
+            default: return -1;
+        }
+        p++;
+
+        if (*p == '#') { if (semitone >= 0) semitone++; p++; }
+        if (*p == '.') { dotted = 1; p++; }
+        if (isdigit((unsigned char)*p)) oct = *p++ - '0';
+        if (*p == '.') { dotted = 1; p++; }
+        if (*p && *p != ',' && *p != ' ') return -1;
+
+        melody_note_t* note = &out->notes[out->note_count++];
+        note->duration_ms = whole_ms / dur;
+        if (dotted) note->duration_ms += note->duration_ms / 2;
+
+        if (semitone < 0) {
+            note->freq_centihz = 0;
+        } else {
+            if (semitone == 12) { semitone = 0; oct++; }
+            unsigned int f = octave4_centihz[semitone];
+            for (int o = oct; o > 4; o--) f *= 2;
+            for (int o = oct; o < 4; o++) f /= 2;
+            note->freq_centihz = f;
+        }
+    }
+
+    if (out->note_count == 0) return -1;
 
-    for (int i = 0; i < TOTAL_NOTES && is_playing && running; i++) {
-        softToneWrite(BUZZER_PIN, school_bell_notes[i]);
-        delay(280);  // 음의 전체 길이만큼 출력되도록 대기
+    // FNV-1a (음표 배열)
+    out->hash = 2166136261u;
+    const unsigned char* bytes = (const unsigned char*)out->notes;
+    for (size_t i = 0; i < out->note_count * sizeof(melody_note_t); i++) {
+        out->hash = (out->hash ^ bytes[i]) * 16777619u;
     }
+    return 0;
+}
+
+// 같은 멜로디인지 (이름과 음표/길이 배열이 모두 같음)
+static int melody_same(const melody_t* a, const melody_t* b) {
+    return a->hash == b->hash && a->note_count == b->note_count && strcmp(a->name, b->name) == 0 &&
+           memcmp(a->notes, b->notes, a->note_count * sizeof(melody_note_t)) == 0;
+}
+
+static melody_entry_t* melody_entry_find(const char* name) {
+    for (int i = 0; i < melody_count; i++) {
+        if (strcmp(melody_cache[i].melody.name, name) == 0) {
+            return &melody_cache[i];
+        }
+    }
+    return NULL;
+}
+
+// 캐시에 멜로디 저장 (같은 이름이면 교체), 가득 차면 가장 오래 쓰지 않은 사용자 멜로디 자리에 넣음
+// 내장 멜로디 이름은 사용자 멜로디로 바꿀 수 없음, buzzer_state.mutex 를 잡은 상태에서 호출
+static melody_t* melody_store(const melody_t* melody, int builtin) {
+    melody_entry_t* entry = melody_entry_find(melody->name);
+
+    if (entry && entry->builtin && !builtin) return NULL;
+    if (!entry && melody_count < MELODY_CACHE_SIZE) entry = &melody_cache[melody_count++];
+    if (!entry) {
+        for (int i = 0; i < melody_count; i++) {
+            if (!melody_cache[i].builtin && (!entry || melody_cache[i].last_used < entry->last_used)) {
+                entry = &melody_cache[i];
+            }
+        }
+        if (!entry) return NULL;
+        printf("[BUZZER] 멜로디 캐시 가득 참: %s 버림\n", entry->melody.name);
+    }
+    entry->melody = *melody;
+    entry->builtin = builtin;
+    entry->last_used = ++melody_clock;
+    return &entry->melody;
+}
+
+// 이름으로 찾고 최근 사용으로 표시
+static melody_t* melody_find(const char* name) {
+    melody_entry_t* entry = melody_entry_find(name);
+    if (!entry) return NULL;
+    entry->last_used = ++melody_clock;
+    return &entry->melody;
+}
+
+static void timespec_add_ms(struct timespec* ts, unsigned int ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// 대기열에서 가장 높은 우선순위(같으면 먼저 온) 요청 위치, 없으면 -1
+static int queue_pick(void) {
+    int best = -1;
+    for (int i = 0; i < queue_len; i++) {
+        if (best < 0 || sound_queue[i].priority > sound_queue[best].priority ||
+            (sound_queue[i].priority == sound_queue[best].priority && sound_queue[i].seq < sound_queue[best].seq)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// 대기열에서 가장 낮은 우선순위(같으면 나중에 온) 요청 위치, 없으면 -1
+static int queue_pick_lowest(void) {
+    int worst = -1;
+    for (int i = 0; i < queue_len; i++) {
+        if (worst < 0 || sound_queue[i].priority < sound_queue[worst].priority ||
+            (sound_queue[i].priority == sound_queue[worst].priority && sound_queue[i].seq > sound_queue[worst].seq)) {
+            worst = i;
+        }
+    }
+    return worst;
+}
+
+// 현재 재생보다 높은 우선순위 요청이 대기 중인지
+static int preempt_pending(void) {
+    int best = queue_pick();
+    return best >= 0 && sound_queue[best].priority > current.priority;
+}
+
+// 절대 데드라인까지 대기, 중지/선점 요청 시 즉시 깨어나 0 이 아닌 값 반환
+// buzzer_state.mutex 를 잡은 상태에서 호출
+static int wait_until(const struct timespec* deadline) {
+    while (running && !stop_requested && !preempt_pending()) {
+        if (device_cond_timedwait(&play_cond, &buzzer_state, deadline) != 0) return 0;
+    }
+    return 1;
+}
+
+static long ms_until(const struct timespec* deadline) {
+    struct timespec now;
+    dev_clock_gettime(CLOCK_MONOTONIC, &now);
+    return (deadline->tv_sec - now.tv_sec) * 1000L + (deadline->tv_nsec - now.tv_nsec) / 1000000L;
+}
 
-    softToneWrite(BUZZER_PIN, 0);  // 소리 중지
+// 현재 요청 재생, 선점되면 재개 위치를 기록하고 1 반환
+// buzzer_state.mutex 를 잡은 상태에서 호출
+static int play_current(void) {
+    struct timespec deadline;
+    dev_clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    for (int i = current.next_note; i < current.melody.note_count; i++) {
+        const melody_note_t* note = &current.melody.notes[i];
+        unsigned int duration = current.remaining_ms ? current.remaining_ms : note->duration_ms;
+        current.remaining_ms = 0;
+
+        // 같은 음이 이어져도 구분되도록 음 길이의 끝 1/10 은 무음
+        unsigned int gap_ms = note->freq_centihz ? duration / 10 : 0;
+        backend->tone(note->freq_centihz);
+        timespec_add_ms(&deadline, duration - gap_ms);
+        int interrupted = wait_until(&deadline);
+
+        if (!interrupted && gap_ms) {
+            backend->tone(0);
+            timespec_add_ms(&deadline, gap_ms);
+            interrupted = wait_until(&deadline);
+        }
+
+        if (interrupted) {
+            if (!running || stop_requested) return 0;
+            long left = ms_until(&deadline);
+            current.next_note = left > 0 ? i : i + 1;
+            current.remaining_ms = left > 0 ? (unsigned int)left : 0;
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    pthread_mutex_lock(&buzzer_state.mutex);
-    is_playing = 0;
-    pthread_mutex_unlock(&buzzer_state.mutex);
+// 지속 재생 워커: 대기열에서 가장 높은 우선순위 요청을 꺼내 재생
+// 더 높은 우선순위가 들어오면 현재 요청을 대기열로 되돌리고(도착 순서 유지) 나중에 이어서 재생
+static void* buzzer_worker_thread(void* arg) {
+    (void)arg;
 
-    printf("[BUZZER] 학교종 멜로디 재생 완료\n");
+    device_lock(&buzzer_state);
+    while (running) {
+        int idx = queue_pick();
+        if (idx < 0) {
+            stop_requested = 0;
+            device_cond_wait(&play_cond, &buzzer_state);
+            continue;
+        }
+
+        current = sound_queue[idx];
+        sound_queue[idx] = sound_queue[--queue_len];
+        has_current = 1;
+        stop_requested = 0;
+        buzzer_publish();
+
+        printf("[BUZZER] %s 재생 %s (%s)\n", current.melody.name,
+               current.next_note ? "재개" : "시작", priority_names[current.priority]);
+
+        backend->start();
+        int preempted = play_current();
+        backend->stop();
+
+        // buzzer_submit 이 재생 중에는 한 칸을 남겨 두므로 선점된 요청은 항상 대기열로 돌아감
+        if (preempted) {
+            sound_queue[queue_len++] = current;
+            preempted_count++;
+            printf("[BUZZER] %s 선점됨 (음표 %d에서 중단)\n", current.melody.name, current.next_note);
+        } else {
+            printf("[BUZZER] %s 재생 %s\n", current.melody.name, stop_requested ? "중지" : "완료");
+        }
+        has_current = 0;
+        buzzer_publish();
+    }
+    device_unlock(&buzzer_state);
     return NULL;
 }
 
 // 부저 초기화
 int buzzer_init(void) {
-    pthread_mutex_lock(&buzzer_state.mutex);
+    device_lock(&buzzer_state);
 
     if (buzzer_state.is_initialized) {
-        pthread_mutex_unlock(&buzzer_state.mutex);
+        device_unlock(&buzzer_state);
         return 0;
     }
 
     if (wiringPiSetupGpio() == -1) {
         fprintf(stderr, "[BUZZER] wiringPiSetupGpio 초기화 실패\n");
-        pthread_mutex_unlock(&buzzer_state.mutex);
+        device_unlock(&buzzer_state);
         return -1;
     }
 
-    softToneCreate(BUZZER_PIN);
-    softToneWrite(BUZZER_PIN, 0);  // 초기에는 소리 없음
+    // 하드웨어 PWM 우선, 실패하면 softTone
+    for (int i = 0; tone_backends[i].name; i++) {
+        if (tone_backends[i].init() == 0) {
+            backend = &tone_backends[i];
+            break;
+        }
+        printf("[BUZZER] %s 백엔드 사용 불가\n", tone_backends[i].name);
+    }
+    if (!backend) {
+        device_unlock(&buzzer_state);
+        return -1;
+    }
+
+    // 데드라인 대기는 단조 시계 기준
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&play_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // 내장 멜로디 미리 컴파일
+    melody_t melody;
+    for (int i = 0; builtin_melodies[i]; i++) {
+        if (melody_parse_rtttl(builtin_melodies[i], &melody) == 0) {
+            melody_store(&melody, 1);
+        }
+    }
+
+    running = 1;
+    if (pthread_create(&worker_tid, NULL, buzzer_worker_thread, NULL) != 0) {
+        fprintf(stderr, "[BUZZER] 재생 워커 생성 실패\n");
+        backend->cleanup();
+        backend = NULL;
+        device_unlock(&buzzer_state);
+        return -1;
+    }
 
     buzzer_state.is_initialized = 1;
-    pthread_mutex_unlock(&buzzer_state.mutex);
-    printf("[BUZZER] 초기화 완료 (GPIO %d)\n", BUZZER_PIN);
+    buzzer_publish();
+    device_unlock(&buzzer_state);
+    printf("[BUZZER] 초기화 완료 (GPIO %d, %s)\n", BUZZER_PIN, backend->name);
     return 0;
 }
 
-// 부저 재생 (학교종 멜로디)
-int buzzer_play(void) {
-    pthread_mutex_lock(&buzzer_state.mutex);
+// 재생 요청 등록: spec 은 저장된 이름 또는 인라인 RTTTL (인라인은 이름으로 캐시에 저장, 이후 이름만으로 재생 가능)
+// 같은 우선순위의 같은 멜로디(이름과 음표가 모두 같음)가 이미 대기/재생 중이면 합쳐짐
+int buzzer_submit(const char* spec, int priority) {
+    melody_t parsed;
+    int inline_melody = spec && strchr(spec, ':') != NULL;
 
-    if (!buzzer_state.is_initialized && buzzer_init() < 0) {
-        pthread_mutex_unlock(&buzzer_state.mutex);
+    if (priority < BUZZER_PRIO_CLICK || priority > BUZZER_PRIO_ALARM) {
         return -1;
     }
 
-    // 이미 재생 중이면 중지 후 새로 시작
-    if (is_playing && music_thread_id != 0) {
-        is_playing = 0;  // 이전 스레드 중지 신호
-        pthread_mutex_unlock(&buzzer_state.mutex);
-        pthread_join(music_thread_id, NULL);  // 이전 스레드 종료 대기
-        pthread_mutex_lock(&buzzer_state.mutex);
-        music_thread_id = 0;
+    if (inline_melody && melody_parse_rtttl(spec, &parsed) < 0) {
+        printf("[BUZZER] RTTTL 파싱 실패\n");
+        return -1;
+    }
+
+    if (buzzer_init() < 0) {
+        return -1;
+    }
+
+    device_lock(&buzzer_state);
+
+    // 인라인 멜로디는 저장 (같은 이름의 사용자 멜로디는 교체, 내장 멜로디 이름이면 거부)
+    const melody_t* melody = inline_melody ? melody_store(&parsed, 0) : melody_find(spec ? spec : DEFAULT_MELODY);
+    if (inline_melody && !melody) {
+        printf("[BUZZER] 내장 멜로디 이름은 인라인 RTTTL 에 쓸 수 없음: %s\n", parsed.name);
+        device_unlock(&buzzer_state);
+        return -1;
+    }
+    if (!melody) {
+        printf("[BUZZER] 멜로디 없음: %s\n", spec);
+        device_unlock(&buzzer_state);
+        return -1;
+    }
+
+    if (has_current && !stop_requested && current.priority == priority && melody_same(&current.melody, melody)) {
+        merged_count++;
+        buzzer_publish();
+        device_unlock(&buzzer_state);
+        return 0;
+    }
+    for (int i = 0; i < queue_len; i++) {
+        if (sound_queue[i].priority == priority && melody_same(&sound_queue[i].melody, melody)) {
+            merged_count++;
+            buzzer_publish();
+            device_unlock(&buzzer_state);
+            return 0;
+        }
+    }
+
+    // 재생 중이면 한 칸은 비워 둠 (선점된 현재 요청이 대기열로 돌아갈 자리)
+    // 가득 차면 새 요청보다 낮은 우선순위 중 가장 나중에 온 요청을 버리고 그 자리에 넣음
+    if (queue_len >= BUZZER_QUEUE_SIZE - has_current) {
+        int worst = queue_pick_lowest();
+        if (worst < 0 || sound_queue[worst].priority >= priority) {
+            printf("[BUZZER] 대기열 가득 참\n");
+            device_unlock(&buzzer_state);
+            return -1;
+        }
+        printf("[BUZZER] 대기열 가득 참: %s (%s) 버림\n", sound_queue[worst].melody.name,
+               priority_names[sound_queue[worst].priority]);
+        sound_queue[worst] = sound_queue[--queue_len];
+        dropped_count++;
+    }
+
+    sound_request_t* req = &sound_queue[queue_len++];
+    req->melody = *melody;
+    req->priority = priority;
+    req->next_note = 0;
+    req->remaining_ms = 0;
+    req->seq = next_seq++;
+    buzzer_publish();
+    pthread_cond_broadcast(&play_cond);
+
+    device_unlock(&buzzer_state);
+    return 0;
+}
+
+// 멜로디 재생 (알림 우선순위)
+int buzzer_play_melody(const char* spec) {
+    return buzzer_submit(spec, BUZZER_PRIO_NOTIFY);
+}
+
+// 부저 재생 (기본 멜로디: 학교종)
+int buzzer_play(void) {
+    return buzzer_submit(DEFAULT_MELODY, BUZZER_PRIO_NOTIFY);
+}
+
+// 저장된 멜로디 목록
+int buzzer_list_melodies(char* buf, int buf_size) {
+    device_lock(&buzzer_state);
+
+    int len = snprintf(buf, buf_size, "멜로디 %d개 (최대 %d, *=내장):", melody_count, MELODY_CACHE_SIZE);
+    for (int i = 0; i < melody_count && len < buf_size; i++) {
+        len += snprintf(buf + len, buf_size - len, " %s%s(%d음)", melody_cache[i].melody.name,
+                        melody_cache[i].builtin ? "*" : "", melody_cache[i].melody.note_count);
+    }
+
+    device_unlock(&buzzer_state);
+    return 0;
+}
+
+// 톤 백엔드 변경 (재생 중이 아닐 때만)
+int buzzer_set_backend(const char* name) {
+    if (buzzer_init() < 0) {
+        return -1;
     }
 
-    // 새로운 멜로디 재생 스레드 시작
-    if (pthread_create(&music_thread_id, NULL, melody_thread, NULL) != 0) {
-        fprintf(stderr, "[BUZZER] 스레드 생성 실패\n");
-        pthread_mutex_unlock(&buzzer_state.mutex);
+    device_lock(&buzzer_state);
+
+    if (has_current || queue_len > 0) {
+        device_unlock(&buzzer_state);
         return -1;
     }
 
-    pthread_detach(music_thread_id);
-    pthread_mutex_unlock(&buzzer_state.mutex);
+    for (int i = 0; tone_backends[i].name; i++) {
+        if (strcmp(tone_backends[i].name, name) != 0) continue;
+        if (&tone_backends[i] == backend) break;
+        if (tone_backends[i].init() < 0) {
+            device_unlock(&buzzer_state);
+            return -1;
+        }
+        backend->cleanup();
+        backend = &tone_backends[i];
+        buzzer_publish();
+        printf("[BUZZER] 톤 백엔드 변경: %s\n", backend->name);
+        device_unlock(&buzzer_state);
+        return 0;
+    }
+
+    int found = backend && strcmp(backend->name, name) == 0;
+    device_unlock(&buzzer_state);
+    return found ? 0 : -1;
+}
+
+// 현재 백엔드와 직전 조회 이후의 프로세스 CPU 사용률
+int buzzer_backend_stats(char* buf, int buf_size) {
+    struct rusage ru;
+    struct timespec now;
+
+    getrusage(RUSAGE_SELF, &ru);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double cpu_sec = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+                     (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+
+    device_lock(&buzzer_state);
+
+    const char* name = backend ? backend->name : "없음";
+    if (cpu_sample_sec < 0) {
+        snprintf(buf, buf_size, "백엔드 %s, %s, CPU 측정 시작", name, has_current ? "재생 중" : "대기 중");
+    } else {
+        double wall = (now.tv_sec - cpu_sample_wall.tv_sec) + (now.tv_nsec - cpu_sample_wall.tv_nsec) / 1e9;
+        snprintf(buf, buf_size, "백엔드 %s, %s, 최근 %.1f초 프로세스 CPU %.2f%%", name,
+                 has_current ? "재생 중" : "대기 중", wall, wall > 0 ? (cpu_sec - cpu_sample_sec) * 100.0 / wall : 0.0);
+    }
+    cpu_sample_sec = cpu_sec;
+    cpu_sample_wall = now;
+
+    device_unlock(&buzzer_state);
     return 0;
 }
 
-// 부저 중지
+// 부저 중지 (대기열 비우고 현재 재생 중단)
 int buzzer_stop(void) {
-    pthread_mutex_lock(&buzzer_state.mutex);
+    device_lock(&buzzer_state);
 
     if (!buzzer_state.is_initialized) {
-        pthread_mutex_unlock(&buzzer_state.mutex);
+        device_unlock(&buzzer_state);
         return 0;  // 초기화되지 않았으면 이미 꺼진 상태
     }
 
-    // 재생 중이면 중지
-    if (is_playing && music_thread_id != 0) {
-        is_playing = 0;  // 스레드 중지 신호
-        pthread_mutex_unlock(&buzzer_state.mutex);
-        pthread_join(music_thread_id, NULL);  // 스레드 종료 대기
-        pthread_mutex_lock(&buzzer_state.mutex);
-        music_thread_id = 0;
+    queue_len = 0;
+    if (has_current) {
+        stop_requested = 1;
+        pthread_cond_broadcast(&play_cond);
     }
-
-    softToneWrite(BUZZER_PIN, 0);  // 소리 완전 중지
+    buzzer_publish();
     printf("[BUZZER] 중지\n");
 
-    pthread_mutex_unlock(&buzzer_state.mutex);
+    device_unlock(&buzzer_state);
     return 0;
 }
 
-// 부저 상태 확인
+// 부저 상태 확인 (잠금 없이 공개 사본을 읽음, 재생 워커나 요청 등록을 기다리지 않음)
 int buzzer_get_status(char* status_buf, int buf_size) {
-    pthread_mutex_lock(&buzzer_state.mutex);
-
-    if (!buzzer_state.is_initialized) {
+    buzzer_public_t st;
+    unsigned long seq;
+    do {
+        seq = seqlock_read_begin(&buzzer_public_seq);
+        st = buzzer_public;
+    } while (seqlock_read_retry(&buzzer_public_seq, seq));
+
+    if (!st.initialized) {
         snprintf(status_buf, buf_size, "BUZZER: NOT_INITIALIZED");
-    } else if (is_playing) {
-        snprintf(status_buf, buf_size, "BUZZER: PLAYING");
+    } else if (st.playing) {
+        snprintf(status_buf, buf_size, "BUZZER: PLAYING (%s, %s, %s) 대기 %d, 병합 %lu, 선점 %lu, 버림 %lu",
+                 st.melody, priority_names[st.priority], st.backend, st.queue_len, st.merged, st.preempted, st.dropped);
     } else {
-        snprintf(status_buf, buf_size, "BUZZER: IDLE");
+        snprintf(status_buf, buf_size, "BUZZER: IDLE (%s) 병합 %lu, 선점 %lu, 버림 %lu",
+                 st.backend, st.merged, st.preempted, st.dropped);
     }
-
-    pthread_mutex_unlock(&buzzer_state.mutex);
     return 0;
 }
 
+// 잠금 계측 보고 (make LOCK_STATS=1 빌드가 아니면 -1)
+int buzzer_lock_stats(char* buf, int size, int reset) {
+    return device_lock_report(&buzzer_state, reset, buf, size);
+}
+
 // 부저 자원 해제
 void buzzer_cleanup(void) {
-    pthread_mutex_lock(&buzzer_state.mutex);
+    device_lock(&buzzer_state);
 
-    running = 0;
-
-    // 재생 중이면 중지
-    if (is_playing && music_thread_id != 0) {
-        is_playing = 0;
-        pthread_mutex_unlock(&buzzer_state.mutex);
-        pthread_join(music_thread_id, NULL);
-        pthread_mutex_lock(&buzzer_state.mutex);
-        music_thread_id = 0;
-    }
-
-    if (buzzer_state.is_initialized) {
-        softToneWrite(BUZZER_PIN, 0);
-        buzzer_state.is_initialized = 0;
-        printf("[BUZZER] 자원 해제\n");
+    if (!buzzer_state.is_initialized) {
+        device_unlock(&buzzer_state);
+        return;
     }
 
-    pthread_mutex_unlock(&buzzer_state.mutex);
+    // 재생 워커 종료
+    running = 0;
+    queue_len = 0;
+    pthread_cond_broadcast(&play_cond);
+    device_unlock(&buzzer_state);
+    pthread_join(worker_tid, NULL);
+    device_lock(&buzzer_state);
+
+    backend->cleanup();
+    backend = NULL;
+    buzzer_state.is_initialized = 0;
+    buzzer_publish();
+    printf("[BUZZER] 자원 해제\n");
+
+    device_unlock(&buzzer_state);
 }
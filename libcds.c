@@ -1,266 +1,990 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
 #include <wiringPi.h>
 #include <wiringPiI2C.h>
 #include "control_device.h"
+#include "sensor_store.h"
+#include "sensor_stats.h"
+#include "sensor_filter.h"
+#include "dev_clock.h"
 
 // 함수 선언
+int cds_init(void);
 int cds_read(void);
+static int cds_sampler_launch(void);
 
 #define CDS_I2C_ADDR 0x48
 #define CDS_CHANNEL 0
+#define CDS_ADC_CHANNELS 4       // PCF8591 입력 채널 수
+#define CDS_ADC_AUTO_INC 0x04    // 제어 바이트 자동 증가 플래그
 #define CDS_THRESHOLD 180
+#define CDS_HYSTERESIS 8         // 임계값 위아래 히스테리시스 폭
 #define AUTO_LED_PIN 17  // 자동 제어용 LED (조도 센서 연동)
 
+// 샘플러 설정
+#define CDS_SAMPLER_DEFAULT_HZ 20
+#define CDS_SAMPLER_MAX_HZ 500
+#define CDS_RING_SIZE 1024       // 2의 거듭제곱
+#define CDS_ADAPT_DEFAULT_MIN_HZ 2    // 적응형 샘플링 기본 범위
+#define CDS_ADAPT_DEFAULT_MAX_HZ 50
+
+// 조도 변화 기록 (cds_replay 로 샘플링 설정별 버스 사용량/반응 지연 비교용)
+#define CDS_TRACE_FILE "cds_trace.txt"
+#define CDS_TRACE_DEFAULT_HZ 100
+
+// 이력 저장소
+#define CDS_HISTORY_FILE "cds_history.db"
+#define CDS_HISTORY_MAX_POINTS 1000   // 단계 자동 선택 시 최대 점 개수
+
+// 읽기 캐시 설정
+#define CDS_CACHE_DEFAULT_MAXAGE_MS 100
+#define CDS_KICK_WAIT_MS 200     // 샘플러 동작 중 새 샘플을 기다리는 최대 시간
+#define CDS_LAT_BUCKETS 24       // 요청 지연 히스토그램 (2^n us 단위)
+
 // 조도 센서 상태 관리
-static device_state_t cds_state = {0, PTHREAD_MUTEX_INITIALIZER};
+static device_state_t cds_state = DEVICE_STATE_INITIALIZER("cds");
 static int cds_fd = -1;
+// 조회 함수가 잠금 없이 읽는 공개 상태 (원자적 읽기/쓰기)
 static int current_light_value = -1;
 static int is_bright = -1;  // -1: unknown, 0: dark, 1: bright
 static pthread_t auto_led_tid = 0;
 static int auto_led_enabled = 0;
 static int running = 1;
 
+// I2C 버스 접근 직렬화 (상태 mutex 와 분리하여 값 조회가 버스 I/O 를 기다리지 않음)
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 샘플 링 버퍼 (단일 생산자 = 샘플러, 다수 소비자)
+// 각 슬롯의 seq 를 마지막에 기록하고, 읽는 쪽은 읽기 전후 seq 가 같을 때만 유효로 판단
+static cds_sample_t sample_ring[CDS_RING_SIZE];
+static unsigned long ring_head = 0;          // 다음에 기록할 seq
+
+// 샘플러가 공개하는 필터링 결과 (원자적 읽기/쓰기)
+static int filtered_value = -1;
+static int filtered_bright = -1;
+static int sampler_hz = CDS_SAMPLER_DEFAULT_HZ;     // 고정 주기 모드의 주기
+static int adapt_min_hz = CDS_ADAPT_DEFAULT_MIN_HZ;  // 0 이면 고정 주기 모드
+static int adapt_max_hz = CDS_ADAPT_DEFAULT_MAX_HZ;
+static int current_hz = 0;                           // 샘플러의 현재 주기
+static int hyst_threshold = CDS_THRESHOLD;
+static int hyst_band = CDS_HYSTERESIS;
+
+static pthread_t sampler_tid;
+static int sampler_running = 0;
+static unsigned long sampler_errors = 0;
+
+// 샘플러 대기 중 설정 변경/중지를 바로 반영하기 위한 깨우기
+static pthread_mutex_t sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sampler_cond;
+static int sampler_kick = 0;
+
+// 기록 중인 조도 변화 (샘플러 스레드만 파일에 씀)
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE* trace_fp = NULL;
+static int trace_hz = 0;
+static long long trace_start_ms = 0;
+static long long trace_end_ms = 0;
+static unsigned long trace_count = 0;
+
+// 다채널 스캔 모드: 자동 증가 제어 바이트 + 블록 읽기 한 번으로 4채널 측정
+static int scan_mode = 0;
+static unsigned long i2c_transactions = 0;
+static char channel_names[CDS_ADC_CHANNELS][16] = {"light", "ain1", "ain2", "ain3"};
+
+// 읽기 캐시: 마지막 측정값과 시각, 진행 중인 버스 읽기 (동시 요청은 한 번의 읽기로 병합)
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cache_cond = PTHREAD_COND_INITIALIZER;
+static int cache_value = -1;
+static int cache_channels[CDS_ADC_CHANNELS] = {-1, -1, -1, -1};
+static int cache_bright = -1;
+static long long cache_ts_ms = -1;
+static int cache_inflight = 0;
+static int cache_kicked = 0;     // 새 샘플을 요청하며 샘플러를 깨움 (다음 샘플 저장 시 해제)
+
+// 캐시 통계 (마지막 CDS_CACHE_STATS 조회 이후)
+static unsigned long stat_requests = 0;
+static unsigned long stat_hits = 0;
+static unsigned long stat_merged = 0;
+static unsigned long stat_bus_reads = 0;
+static unsigned long stat_latency[CDS_LAT_BUCKETS];
+static long long stat_since_ms = -1;
+
+// 밝기 상태 변화 알림 (자동 LED 스레드 대기용)
+static pthread_mutex_t change_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t change_cond;
+
+// 규칙 엔진 신호 통지 (cds.value = 필터값, cds.bright = 밝음 여부, 바뀔 때만)
+static signal_hook_fn signal_hook = NULL;
+
+// 이벤트 발행 (밝음/어둠 전환 시 cds.bright / cds.dark)
+static event_publish_fn event_publisher = NULL;
+
 // 자동 LED (GPIO 17) 상태 관리
-static device_state_t auto_led_state = {0, PTHREAD_MUTEX_INITIALIZER};
+static device_state_t auto_led_state = DEVICE_STATE_INITIALIZER("cds/auto_led");
 
-// 자동 LED 초기화
-int auto_led_init(void) {
-    pthread_mutex_lock(&auto_led_state.mutex);
-    
+// 자동 LED 핀 설정 (auto_led_state 잠금을 잡은 채 호출, 잠금을 다시 잡지 않음)
+static int auto_led_setup(void) {
     if (auto_led_state.is_initialized) {
-        pthread_mutex_unlock(&auto_led_state.mutex);
         return 0;
     }
-    
+
     pinMode(AUTO_LED_PIN, OUTPUT);
     digitalWrite(AUTO_LED_PIN, LOW);
     auto_led_state.is_initialized = 1;
-    
-    pthread_mutex_unlock(&auto_led_state.mutex);
     printf("[AUTO_LED] 초기화 완료 (GPIO %d)\n", AUTO_LED_PIN);
     return 0;
 }
 
+// 자동 LED 초기화
+int auto_led_init(void) {
+    device_lock(&auto_led_state);
+    int result = auto_led_setup();
+    device_unlock(&auto_led_state);
+    return result;
+}
+
 // 자동 LED 켜기
 int auto_led_on(void) {
-    pthread_mutex_lock(&auto_led_state.mutex);
-    
-    if (!auto_led_state.is_initialized && auto_led_init() < 0) {
-        pthread_mutex_unlock(&auto_led_state.mutex);
+    device_lock(&auto_led_state);
+
+    if (auto_led_setup() < 0) {
+        device_unlock(&auto_led_state);
         return -1;
     }
-    
+
     digitalWrite(AUTO_LED_PIN, HIGH);
     printf("[AUTO_LED] ON (GPIO %d)\n", AUTO_LED_PIN);
-    
-    pthread_mutex_unlock(&auto_led_state.mutex);
+
+    device_unlock(&auto_led_state);
     return 0;
 }
 
 // 자동 LED 끄기
 int auto_led_off(void) {
-    pthread_mutex_lock(&auto_led_state.mutex);
-    
-    if (!auto_led_state.is_initialized && auto_led_init() < 0) {
-        pthread_mutex_unlock(&auto_led_state.mutex);
+    device_lock(&auto_led_state);
+
+    if (auto_led_setup() < 0) {
+        device_unlock(&auto_led_state);
         return -1;
     }
-    
+
     digitalWrite(AUTO_LED_PIN, LOW);
     printf("[AUTO_LED] OFF (GPIO %d)\n", AUTO_LED_PIN);
-    
-    pthread_mutex_unlock(&auto_led_state.mutex);
+
+    device_unlock(&auto_led_state);
+    return 0;
+}
+
+// 4채널 블록 읽기: 제어 바이트 쓰기와 5바이트 읽기를 반복 시작(repeated start)으로 묶은 한 트랜잭션
+// 첫 바이트는 이전 변환 결과이므로 버리고 나머지가 채널 0~3
+static int cds_bus_scan(int* channels) {
+    unsigned char ctrl = CDS_ADC_AUTO_INC | CDS_CHANNEL;
+    unsigned char buf[CDS_ADC_CHANNELS + 1];
+    struct i2c_msg msgs[2] = {
+        {CDS_I2C_ADDR, 0, 1, &ctrl},
+        {CDS_I2C_ADDR, I2C_M_RD, sizeof(buf), buf},
+    };
+    struct i2c_rdwr_ioctl_data xfer = {msgs, 2};
+
+    if (ioctl(cds_fd, I2C_RDWR, &xfer) == 2) {
+        i2c_transactions++;
+    } else {
+        // 결합 전송을 지원하지 않는 어댑터: 쓰기 한 번 + 블록 읽기 한 번
+        if (write(cds_fd, &ctrl, 1) != 1 || read(cds_fd, buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+            return -1;
+        }
+        i2c_transactions += 2;
+    }
+
+    for (int ch = 0; ch < CDS_ADC_CHANNELS; ch++) {
+        channels[ch] = buf[ch + 1];
+    }
+    return channels[CDS_CHANNEL];
+}
+
+// I2C 로 ADC 읽기 (bus_mutex 로 직렬화), 스캔 모드면 4채널 모두 채움
+static int cds_bus_read(int* channels) {
+    pthread_mutex_lock(&bus_mutex);
+
+    int a2dVal;
+    if (scan_mode) {
+        a2dVal = cds_bus_scan(channels);
+    } else {
+        wiringPiI2CWrite(cds_fd, 0x00 | CDS_CHANNEL);
+        (void)wiringPiI2CRead(cds_fd);
+        a2dVal = wiringPiI2CRead(cds_fd);  // 실제 값
+        i2c_transactions += 3;
+        for (int ch = 0; ch < CDS_ADC_CHANNELS; ch++) {
+            channels[ch] = ch == CDS_CHANNEL ? a2dVal : -1;
+        }
+    }
+
+    pthread_mutex_unlock(&bus_mutex);
+    return a2dVal;
+}
+
+// 히스테리시스 판정: 값이 클수록 어두움, 밴드 안에서는 이전 상태 유지
+static int cds_classify(int value, int previous) {
+    return sensor_filter_classify(value, previous, __atomic_load_n(&hyst_threshold, __ATOMIC_RELAXED),
+                                  __atomic_load_n(&hyst_band, __ATOMIC_RELAXED));
+}
+
+static long long cds_now_ms(void) {
+    struct timespec now;
+    dev_clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000L;
+}
+
+// 링 버퍼에 샘플 기록 (샘플러 스레드만 호출)
+static void cds_ring_push(long long ts_ms, int raw, int filtered) {
+    unsigned long seq = ring_head;
+    cds_sample_t* slot = &sample_ring[seq & (CDS_RING_SIZE - 1)];
+
+    __atomic_store_n(&slot->seq, 0UL, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->ts_ms = ts_ms;
+    slot->raw = raw;
+    slot->filtered = filtered;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring_head, seq + 1, __ATOMIC_RELEASE);
+}
+
+// 최근 샘플을 오래된 순으로 최대 max 개 복사 (블로킹 없음), 복사한 개수 반환
+int cds_ring_read(cds_sample_t* out, int max) {
+    unsigned long head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    unsigned long from = head > (unsigned long)max ? head - max : 0;
+    if (head - from > CDS_RING_SIZE) from = head - CDS_RING_SIZE;
+
+    int count = 0;
+    for (unsigned long seq = from; seq < head; seq++) {
+        const cds_sample_t* slot = &sample_ring[seq & (CDS_RING_SIZE - 1)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq + 1) continue;
+        cds_sample_t copy = *slot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq + 1) continue;  // 읽는 중 덮어씀
+        out[count++] = copy;
+    }
+    return count;
+}
+
+// 캐시 갱신 (버스 읽기 리더 또는 샘플러가 호출)
+static void cds_cache_store(int value, int bright, const int* channels, long long ts_ms) {
+    pthread_mutex_lock(&cache_mutex);
+    cache_value = value;
+    memcpy(cache_channels, channels, sizeof(cache_channels));
+    cache_bright = bright;
+    cache_ts_ms = ts_ms;
+    cache_kicked = 0;
+    pthread_cond_broadcast(&cache_cond);
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+// 캐시 비우기 (샘플러 시작/중지 시 다른 경로의 값을 응답하지 않도록)
+static void cds_cache_invalidate(void) {
+    pthread_mutex_lock(&cache_mutex);
+    cache_ts_ms = -1;
+    cache_kicked = 0;
+    pthread_cond_broadcast(&cache_cond);
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+static void cds_latency_record(long us) {
+    int bucket = 0;
+    while (bucket < CDS_LAT_BUCKETS - 1 && (1L << bucket) <= us) bucket++;
+    __atomic_fetch_add(&stat_latency[bucket], 1, __ATOMIC_RELAXED);
+}
+
+// 샘플러를 깨워 바뀐 주기/상태를 즉시 반영
+static void cds_sampler_kick(void) {
+    pthread_mutex_lock(&sampler_mutex);
+    sampler_kick = 1;
+    pthread_cond_signal(&sampler_cond);
+    pthread_mutex_unlock(&sampler_mutex);
+}
+
+// 최대 maxage_ms 만큼 오래된 값까지 캐시에서 응답, 더 오래되었으면 새로 측정
+// 샘플러 동작 중에는 버스를 따로 읽지 않고 샘플러를 깨워 다음 샘플을 기다림 (캐시에는 필터링된 값만 있음)
+// 샘플러가 없으면 버스에서 원시값을 읽고, 이미 다른 요청이 읽는 중이면 그 결과를 함께 사용 (single-flight)
+int cds_read_cached(int maxage_ms, int* value, int* bright) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (maxage_ms < 0) maxage_ms = 0;
+    if (cds_init() < 0) {
+        return -1;
+    }
+
+    __atomic_fetch_add(&stat_requests, 1, __ATOMIC_RELAXED);
+    long long request_ms = cds_now_ms();
+    struct timespec deadline;
+    dev_clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += CDS_KICK_WAIT_MS * 1000000L;
+    while (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&cache_mutex);
+
+    int hit = 1, merged = 0, kicked = 0, result = 0;
+    for (;;) {
+        // 요청 이후에 저장된 값은 maxage 와 상관없이 새 측정값
+        if (cache_ts_ms >= 0 && (cache_ts_ms >= request_ms || cds_now_ms() - cache_ts_ms <= maxage_ms)) {
+            break;
+        }
+        if (__atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE)) {
+            // 샘플러를 한 번만 깨우고, 함께 기다리는 요청은 병합으로 집계
+            if (!cache_kicked) {
+                cache_kicked = 1;
+                kicked = 1;
+                cds_sampler_kick();
+            } else if (!kicked) {
+                merged = 1;
+            }
+            if (dev_cond_timedwait(&cache_cond, &cache_mutex, &deadline) == ETIMEDOUT &&
+                __atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE) && cache_ts_ms < request_ms) {
+                // 샘플러가 제시간에 새 샘플을 내지 못함 (버스 오류)
+                cache_kicked = 0;
+                result = -1;
+                break;
+            }
+            continue;
+        }
+        if (!cache_inflight) {
+            hit = 0;
+            break;
+        }
+        // 진행 중인 읽기 결과를 기다린 뒤 다시 확인
+        merged = 1;
+        pthread_cond_wait(&cache_cond, &cache_mutex);
+    }
+
+    if (result < 0) {
+        __atomic_fetch_add(&stat_bus_reads, 1, __ATOMIC_RELAXED);
+    } else if (!hit) {
+        cache_inflight = 1;
+        pthread_mutex_unlock(&cache_mutex);
+
+        int channels[CDS_ADC_CHANNELS];
+        int a2dVal = cds_bus_read(channels);
+        __atomic_fetch_add(&stat_bus_reads, 1, __ATOMIC_RELAXED);
+
+        // 버스 읽기는 cache_inflight 로 한 번에 하나뿐이므로 공개 상태를 쓰는 쪽도 하나 (상태 잠금 불필요)
+        int new_bright = __atomic_load_n(&is_bright, __ATOMIC_RELAXED);
+        if (a2dVal >= 0) {
+            new_bright = cds_classify(a2dVal, new_bright);
+            __atomic_store_n(&current_light_value, a2dVal, __ATOMIC_RELEASE);
+            __atomic_store_n(&is_bright, new_bright, __ATOMIC_RELEASE);
+        }
+
+        pthread_mutex_lock(&cache_mutex);
+        if (a2dVal >= 0) {
+            cache_value = a2dVal;
+            memcpy(cache_channels, channels, sizeof(cache_channels));
+            cache_bright = new_bright;
+            cache_ts_ms = cds_now_ms();
+        } else {
+            result = -1;
+        }
+        cache_inflight = 0;
+        pthread_cond_broadcast(&cache_cond);
+    } else if (kicked) {
+        __atomic_fetch_add(&stat_bus_reads, 1, __ATOMIC_RELAXED);  // 샘플러가 대신 읽음
+    } else if (merged) {
+        __atomic_fetch_add(&stat_merged, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&stat_hits, 1, __ATOMIC_RELAXED);
+    }
+
+    if (value) *value = cache_value;
+    if (bright) *bright = cache_bright;
+    pthread_mutex_unlock(&cache_mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cds_latency_record((end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000L);
+    return result;
+}
+
+// 캐시 통계: 요청/버스 읽기 비율과 요청 지연 p99 (조회 시 초기화)
+int cds_cache_stats(char* buf, int size) {
+    long long now = cds_now_ms();
+    long long since = __atomic_exchange_n(&stat_since_ms, now, __ATOMIC_RELAXED);
+    double elapsed = since < 0 ? 0.0 : (now - since) / 1000.0;
+
+    unsigned long requests = __atomic_exchange_n(&stat_requests, 0, __ATOMIC_RELAXED);
+    unsigned long hits = __atomic_exchange_n(&stat_hits, 0, __ATOMIC_RELAXED);
+    unsigned long merged = __atomic_exchange_n(&stat_merged, 0, __ATOMIC_RELAXED);
+    unsigned long bus_reads = __atomic_exchange_n(&stat_bus_reads, 0, __ATOMIC_RELAXED);
+    unsigned long hist[CDS_LAT_BUCKETS], total = 0;
+    for (int i = 0; i < CDS_LAT_BUCKETS; i++) {
+        hist[i] = __atomic_exchange_n(&stat_latency[i], 0, __ATOMIC_RELAXED);
+        total += hist[i];
+    }
+
+    // p99 는 해당 버킷의 상한 (2^n us)
+    long p99_us = 0;
+    unsigned long acc = 0;
+    for (int i = 0; i < CDS_LAT_BUCKETS && total > 0; i++) {
+        acc += hist[i];
+        if (acc * 100 >= total * 99) {
+            p99_us = 1L << i;
+            break;
+        }
+    }
+
+    if (elapsed <= 0.0) {
+        return snprintf(buf, size, "측정 구간 없음");
+    }
+    return snprintf(buf, size, "%.1f초 동안 요청 %lu (%.1f/s), 캐시 적중 %lu, 병합 %lu, 버스 읽기 %lu (%.1f/s), p99 <= %ldus",
+                    elapsed, requests, requests / elapsed, hits, merged, bus_reads, bus_reads / elapsed, p99_us);
+}
+
+// 스캔 모드 전환 (전환 시 캐시 무효화)
+int cds_set_scan_mode(int enable) {
+    if (cds_init() < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&bus_mutex);
+    scan_mode = enable ? 1 : 0;
+    pthread_mutex_unlock(&bus_mutex);
+
+    pthread_mutex_lock(&cache_mutex);
+    cache_ts_ms = -1;
+    pthread_mutex_unlock(&cache_mutex);
+
+    printf("[CDS] ADC %s 모드\n", enable ? "4채널 스캔" : "단일 채널");
     return 0;
 }
 
-// 자동 LED 제어 스레드
+// 채널 이름 지정 (영문/숫자/_ 15자 이내)
+int cds_sensor_name(int channel, const char* name) {
+    if (channel < 0 || channel >= CDS_ADC_CHANNELS || !name || !name[0] || strlen(name) >= sizeof(channel_names[0])) {
+        return -1;
+    }
+    for (const char* p = name; *p; p++) {
+        if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_')) {
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    for (int ch = 0; ch < CDS_ADC_CHANNELS; ch++) {
+        if (ch != channel && strcmp(channel_names[ch], name) == 0) {
+            pthread_mutex_unlock(&cache_mutex);
+            return -1;  // 이름 중복
+        }
+    }
+    strcpy(channel_names[channel], name);
+    pthread_mutex_unlock(&cache_mutex);
+    return 0;
+}
+
+// 이름으로 센서 값 읽기 (캐시 규칙은 cds_read_cached 와 동일, 0번 외 채널은 스캔 모드 필요)
+int cds_sensor_read(const char* name, int maxage_ms, int* value) {
+    int channel = -1;
+    pthread_mutex_lock(&cache_mutex);
+    for (int ch = 0; ch < CDS_ADC_CHANNELS; ch++) {
+        if (strcmp(channel_names[ch], name) == 0) channel = ch;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+
+    if (channel < 0 || (channel != CDS_CHANNEL && !__atomic_load_n(&scan_mode, __ATOMIC_RELAXED))) {
+        return -1;
+    }
+    if (cds_read_cached(maxage_ms, NULL, NULL) < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    *value = cache_channels[channel];
+    pthread_mutex_unlock(&cache_mutex);
+    return *value < 0 ? -1 : 0;
+}
+
+// 모든 채널 "이름=값" 목록 (스캔 모드면 캐시 규칙에 따라 한 번의 트랜잭션으로 갱신)
+int cds_sensor_list(int maxage_ms, char* buf, int size) {
+    if (cds_read_cached(maxage_ms, NULL, NULL) < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    int len = snprintf(buf, size, "%s", scan_mode ? "스캔" : "단일");
+    for (int ch = 0; ch < CDS_ADC_CHANNELS && len < size; ch++) {
+        if (cache_channels[ch] < 0) {
+            len += snprintf(buf + len, size - len, " %s=-", channel_names[ch]);
+        } else {
+            len += snprintf(buf + len, size - len, " %s=%d", channel_names[ch], cache_channels[ch]);
+        }
+    }
+    if (len < size) {
+        len += snprintf(buf + len, size - len, " (I2C 트랜잭션 누적 %lu)", i2c_transactions);
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    return len;
+}
+
+// 조도 변화 기록: 샘플 하나를 파일에 쓰고, 기록 시간이 끝나면 닫음 (샘플러 스레드에서 호출)
+static void cds_trace_sample(long long now_ms, int raw) {
+    pthread_mutex_lock(&trace_mutex);
+    if (trace_fp) {
+        fprintf(trace_fp, "%lld %d\n", now_ms - trace_start_ms, raw);
+        trace_count++;
+        if (now_ms >= trace_end_ms) {
+            fclose(trace_fp);
+            trace_fp = NULL;
+            __atomic_store_n(&trace_hz, 0, __ATOMIC_RELEASE);
+            printf("[CDS] 조도 변화 기록 완료: %s (%lu개)\n", CDS_TRACE_FILE, trace_count);
+        }
+    }
+    pthread_mutex_unlock(&trace_mutex);
+}
+
+// 샘플러 스레드: 중앙값 -> EMA -> 히스테리시스 필터링, 적응형 모드면 변화에 따라 주기 조절
+static void* cds_sampler_thread(void* arg) {
+    (void)arg;
+    sensor_filter_t filter;
+    struct timespec next;
+    long long last_ms = -1;      // 직전 샘플 시각 (통계/이력 가중치 계산)
+
+    sensor_filter_init(&filter, __atomic_load_n(&filtered_bright, __ATOMIC_RELAXED),
+                       __atomic_load_n(&adapt_min_hz, __ATOMIC_RELAXED) > 0 ?
+                       __atomic_load_n(&adapt_max_hz, __ATOMIC_RELAXED) : __atomic_load_n(&sampler_hz, __ATOMIC_RELAXED));
+
+    dev_clock_gettime(CLOCK_MONOTONIC, &next);
+    while (__atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE)) {
+        sensor_filter_cfg_t cfg = {
+            __atomic_load_n(&hyst_threshold, __ATOMIC_RELAXED),
+            __atomic_load_n(&hyst_band, __ATOMIC_RELAXED),
+            __atomic_load_n(&adapt_min_hz, __ATOMIC_RELAXED),
+            __atomic_load_n(&adapt_max_hz, __ATOMIC_RELAXED),
+        };
+        int bright = filter.bright;
+        int previous = filter.filtered;
+
+        int channels[CDS_ADC_CHANNELS];
+        int raw = cds_bus_read(channels);
+        if (raw < 0) {
+            __atomic_fetch_add(&sampler_errors, 1, __ATOMIC_RELAXED);
+        } else {
+            int filtered = sensor_filter_step(&filter, raw, &cfg);
+            int new_bright = filter.bright;
+
+            __atomic_store_n(&filtered_value, filtered, __ATOMIC_RELEASE);
+            __atomic_store_n(&filtered_bright, new_bright, __ATOMIC_RELEASE);
+            long long now_ms = cds_now_ms();
+            cds_ring_push(now_ms, raw, filtered);
+            cds_cache_store(filtered, new_bright, channels, now_ms);
+
+            // 샘플마다 직전 샘플과의 간격으로 가중 (50Hz 구간이 2Hz 구간보다 25배 반영되지 않도록)
+            // 첫 샘플이나 오류/중지로 길어진 간격은 최저 주기의 한 주기로 제한
+            int hz_now = __atomic_load_n(&current_hz, __ATOMIC_RELAXED);
+            long long max_weight = 1000 / (cfg.min_hz > 0 ? cfg.min_hz : (hz_now > 0 ? hz_now : 1));
+            long long weight_ms = last_ms < 0 ? max_weight : now_ms - last_ms;
+            if (weight_ms > max_weight) weight_ms = max_weight;
+            last_ms = now_ms;
+            sensor_stats_add(now_ms, raw, (int)weight_ms);
+            if (__atomic_load_n(&trace_hz, __ATOMIC_ACQUIRE)) {
+                cds_trace_sample(now_ms, raw);
+            }
+
+            // 이력은 실제 시각 기준으로 기록
+            struct timespec wall;
+            dev_clock_gettime(CLOCK_REALTIME, &wall);
+            sensor_store_append(wall.tv_sec * 1000LL + wall.tv_nsec / 1000000, raw, (int)weight_ms);
+
+            signal_hook_fn hook = __atomic_load_n(&signal_hook, __ATOMIC_ACQUIRE);
+            if (hook && filtered != previous) hook("cds.value", filtered);
+            if (hook && new_bright != bright) hook("cds.bright", new_bright);
+
+            event_publish_fn publish = __atomic_load_n(&event_publisher, __ATOMIC_ACQUIRE);
+            if (publish && bright >= 0 && new_bright != bright) {
+                publish(new_bright ? EVENT_CDS_BRIGHT : EVENT_CDS_DARK, filtered);
+            }
+
+            if (new_bright != bright) {
+                pthread_mutex_lock(&change_mutex);
+                pthread_cond_broadcast(&change_cond);
+                pthread_mutex_unlock(&change_mutex);
+            }
+        }
+
+        // 다음 주기: 기록 중이면 기록 주기, 고정 모드면 설정 주기, 적응형이면 필터가 정한 주기
+        int hz = __atomic_load_n(&trace_hz, __ATOMIC_ACQUIRE);
+        if (hz == 0) hz = cfg.min_hz > 0 ? filter.hz : __atomic_load_n(&sampler_hz, __ATOMIC_RELAXED);
+        __atomic_store_n(&current_hz, hz, __ATOMIC_RELAXED);
+
+        next.tv_nsec += 1000000000L / hz;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+
+        // 주기가 길어진 동안 밀린 시점은 건너뜀 (한꺼번에 몰아서 읽지 않음)
+        struct timespec now;
+        dev_clock_gettime(CLOCK_MONOTONIC, &now);
+        if (next.tv_sec < now.tv_sec - 1) next = now;
+
+        // 다음 시점까지 대기, 설정이 바뀌면 즉시 다음 샘플
+        pthread_mutex_lock(&sampler_mutex);
+        while (!sampler_kick && __atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE)) {
+            if (dev_cond_timedwait(&sampler_cond, &sampler_mutex, &next) == ETIMEDOUT) break;
+        }
+        if (sampler_kick) {
+            sampler_kick = 0;
+            dev_clock_gettime(CLOCK_MONOTONIC, &next);
+        }
+        pthread_mutex_unlock(&sampler_mutex);
+    }
+    return NULL;
+}
+
+// 자동 LED 제어 스레드 (샘플러의 필터링된 상태 변화를 기다림, I2C 직접 접근 없음)
 void* auto_led_thread(void *arg) {
     (void)arg;
-    
+
     printf("[CDS] 자동 LED 제어 시작 (어두우면 GPIO %d ON)\n", AUTO_LED_PIN);
-    printf("[CDS] 모니터링 간격: 1초, 주기적 출력: 5초마다\n");
-    
+    printf("[CDS] 샘플링 %dHz, 상태 변화 즉시 반영, 주기적 출력: 5초마다\n",
+           __atomic_load_n(&current_hz, __ATOMIC_RELAXED));
+
     int previous_bright = -1;  // 이전 상태 저장 (-1: 초기값)
     int loop_count = 0;        // 주기적 출력을 위한 카운터
-    
+    struct timespec deadline;
+
     while (running && auto_led_enabled) {
-        // 조도 센서 값 읽기
-        if (cds_read() == 0) {
-            pthread_mutex_lock(&cds_state.mutex);
-            int bright = is_bright;
-            int light_val = current_light_value;
-            pthread_mutex_unlock(&cds_state.mutex);
-            
+        int bright = __atomic_load_n(&filtered_bright, __ATOMIC_ACQUIRE);
+
+        if (bright >= 0) {
             // 상태가 변경되었거나 5초마다 출력 (주기적 모니터링)
             int should_print = (bright != previous_bright) || (loop_count % 5 == 0);
-            
-            if (bright == 0) {  // 어두우면 LED ON
-                auto_led_on();
-                if (should_print) {
-                    printf("[CDS] 어두움 -> AUTO_LED ON\n");
-                }
-            } else if (bright == 1) {  // 밝으면 LED OFF
-                auto_led_off();
-                if (should_print) {
-                    printf("[CDS] 밝음 -> AUTO_LED OFF\n");
+
+            if (bright != previous_bright) {
+                if (bright == 0) {  // 어두우면 LED ON
+                    auto_led_on();
+                } else {            // 밝으면 LED OFF
+                    auto_led_off();
                 }
             }
-            
+            if (should_print) {
+                printf("[CDS] %s (값:%d) -> AUTO_LED %s\n", bright ? "밝음" : "어두움",
+                       __atomic_load_n(&filtered_value, __ATOMIC_RELAXED), bright ? "OFF" : "ON");
+            }
+
             // 상태 변경 시 즉시 출력
             if (bright != previous_bright && previous_bright != -1) {
-                printf("[CDS] 조도 상태 변경: %s -> %s\n", 
+                printf("[CDS] 조도 상태 변경: %s -> %s\n",
                        previous_bright ? "밝음" : "어둠",
                        bright ? "밝음" : "어둠");
             }
-            
+
             // 첫 번째 실행 시 현재 상태 출력
             if (previous_bright == -1) {
-                printf("[CDS] 초기 조도 상태: %s\n", 
+                printf("[CDS] 초기 조도 상태: %s\n",
                        bright ? "밝음" : "어둠");
             }
-            
+
             previous_bright = bright;
-        } else {
-            printf("[CDS] 조도 센서 읽기 실패\n");
         }
-        
+
         loop_count++;
-        delay(1000);  // 1초마다 체크
+
+        // 상태 변화 또는 1초 경과까지 대기
+        dev_clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += 1;
+        pthread_mutex_lock(&change_mutex);
+        if (running && auto_led_enabled &&
+            __atomic_load_n(&filtered_bright, __ATOMIC_ACQUIRE) == previous_bright) {
+            dev_cond_timedwait(&change_cond, &change_mutex, &deadline);
+        }
+        pthread_mutex_unlock(&change_mutex);
     }
-    
+
     printf("[CDS] 자동 LED 제어 종료\n");
     return NULL;
 }
 
 // 조도 센서 초기화
 int cds_init(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    
+    device_lock(&cds_state);
+
     if (cds_state.is_initialized) {
-        pthread_mutex_unlock(&cds_state.mutex);
+        device_unlock(&cds_state);
         return 0;
     }
 
     // I2C 인터페이스 설정
     if ((cds_fd = wiringPiI2CSetupInterface("/dev/i2c-1", CDS_I2C_ADDR)) < 0) {
         fprintf(stderr, "[CDS] I2C 설정 실패\n");
-        pthread_mutex_unlock(&cds_state.mutex);
+        device_unlock(&cds_state);
         return -1;
     }
-    
+
     // 자동 LED 초기화
     if (auto_led_init() < 0) {
         fprintf(stderr, "[CDS] 자동 LED 초기화 실패\n");
-        pthread_mutex_unlock(&cds_state.mutex);
+        device_unlock(&cds_state);
         return -1;
     }
-    
-    cds_state.is_initialized = 1;
-    pthread_mutex_unlock(&cds_state.mutex);
+
+    // 상태 변화 대기는 단조 시계 기준
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&change_cond, &attr);
+    pthread_cond_init(&sampler_cond, &attr);
+    pthread_cond_init(&cache_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    __atomic_store_n(&stat_since_ms, cds_now_ms(), __ATOMIC_RELAXED);
+    __atomic_store_n(&cds_state.is_initialized, 1, __ATOMIC_RELEASE);
+    device_unlock(&cds_state);
     printf("[CDS] 조도 센서 초기화 완료 (I2C 주소: 0x%02X)\n", CDS_I2C_ADDR);
+
+    // 이력 기록: 저장소를 열고 샘플러를 계속 동작시킴 (저장소 실패 시 이력 없이 동작)
+    if (sensor_store_open(CDS_HISTORY_FILE) < 0) {
+        fprintf(stderr, "[CDS] 이력 저장소 없이 동작\n");
+    }
+    cds_sampler_launch();
     return 0;
 }
 
-// 조도 센서 값 읽기
+// 조도 센서 값 읽기 (항상 새로 측정, 동시에 들어온 요청은 한 번의 버스 읽기로 병합)
 int cds_read(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    
-    if (!cds_state.is_initialized && cds_init() < 0) {
-        pthread_mutex_unlock(&cds_state.mutex);
+    int value, bright;
+    if (cds_read_cached(0, &value, &bright) < 0) {
         return -1;
     }
-    
-    // ADC 채널 설정 및 읽기
-    wiringPiI2CWrite(cds_fd, 0x00 | CDS_CHANNEL);
-    (void)wiringPiI2CRead(cds_fd);
-    int a2dVal = wiringPiI2CRead(cds_fd);  // 실제 값
-    
-    current_light_value = a2dVal;
-    
-    // 밝기 판단
-    if (a2dVal < CDS_THRESHOLD) {
-        is_bright = 1;  // 밝음
-    } else {
-        is_bright = 0;  // 어둠
-    }
-    
+
     // 수동 읽기일 때만 출력 (자동 모드에서는 스레드에서 출력)
     if (!auto_led_enabled) {
-        printf("[CDS] 조도값: %d (%s)\n", a2dVal, is_bright ? "밝음" : "어둠");
+        printf("[CDS] 조도값: %d (%s)\n", value, bright ? "밝음" : "어둠");
     }
-    
-    pthread_mutex_unlock(&cds_state.mutex);
     return 0;
 }
-// 조도 센서 값 가져오기
+
+// 조도 센서 값 가져오기 (샘플러 동작 중에는 필터링된 값, 잠금 없음)
 int cds_get_value(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    int value = current_light_value;
-    pthread_mutex_unlock(&cds_state.mutex);
-    return value;
+    if (__atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE)) {
+        return __atomic_load_n(&filtered_value, __ATOMIC_ACQUIRE);
+    }
+    return __atomic_load_n(&current_light_value, __ATOMIC_ACQUIRE);
 }
 
-// 밝기 상태 가져오기
+// 밝기 상태 가져오기 (샘플러 동작 중에는 히스테리시스 적용 결과, 잠금 없음)
 int cds_is_bright(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    int bright = is_bright;
-    pthread_mutex_unlock(&cds_state.mutex);
-    return bright;
+    if (__atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE)) {
+        return __atomic_load_n(&filtered_bright, __ATOMIC_ACQUIRE);
+    }
+    return __atomic_load_n(&is_bright, __ATOMIC_ACQUIRE);
+}
+
+// 샘플러 스레드가 없으면 현재 설정(고정/적응형)으로 시작
+static int cds_sampler_launch(void) {
+    device_lock(&cds_state);
+
+    if (!sampler_running) {
+        __atomic_store_n(&sampler_running, 1, __ATOMIC_RELEASE);
+        if (pthread_create(&sampler_tid, NULL, cds_sampler_thread, NULL) != 0) {
+            fprintf(stderr, "[CDS] 샘플러 스레드 생성 실패\n");
+            __atomic_store_n(&sampler_running, 0, __ATOMIC_RELEASE);
+            device_unlock(&cds_state);
+            return -1;
+        }
+        cds_cache_invalidate();
+    }
+
+    device_unlock(&cds_state);
+    return 0;
+}
+
+// 고정 주기로 샘플러 시작 (이미 동작 중이면 주기만 변경, 적응형 모드 해제)
+int cds_sampler_start(int hz) {
+    if (hz < 1 || hz > CDS_SAMPLER_MAX_HZ) {
+        return -1;
+    }
+
+    if (cds_init() < 0) {
+        return -1;
+    }
+
+    __atomic_store_n(&sampler_hz, hz, __ATOMIC_RELAXED);
+    __atomic_store_n(&adapt_min_hz, 0, __ATOMIC_RELAXED);
+    if (cds_sampler_launch() < 0) {
+        return -1;
+    }
+    cds_sampler_kick();
+
+    printf("[CDS] 샘플러 동작 (고정 %dHz)\n", hz);
+    return 0;
+}
+
+// 적응형 샘플링: 안정되면 min_hz 까지 느려지고 변화가 크거나 임계값 근처면 max_hz 로
+// min_hz 가 0 이면 고정 주기 모드로 되돌림
+int cds_set_adaptive(int min_hz, int max_hz) {
+    if (min_hz != 0 && (min_hz < 1 || max_hz < min_hz || max_hz > CDS_SAMPLER_MAX_HZ)) {
+        return -1;
+    }
+
+    if (cds_init() < 0) {
+        return -1;
+    }
+
+    if (min_hz > 0) {
+        __atomic_store_n(&adapt_max_hz, max_hz, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&adapt_min_hz, min_hz, __ATOMIC_RELAXED);
+    if (cds_sampler_launch() < 0) {
+        return -1;
+    }
+    cds_sampler_kick();
+
+    if (min_hz > 0) {
+        printf("[CDS] 샘플러 동작 (적응형 %d-%dHz)\n", min_hz, max_hz);
+    } else {
+        printf("[CDS] 샘플러 동작 (고정 %dHz)\n", __atomic_load_n(&sampler_hz, __ATOMIC_RELAXED));
+    }
+    return 0;
+}
+
+// 조도 변화 기록 시작: seconds 동안 hz 고정 주기로 원시값을 CDS_TRACE_FILE 에 기록
+// 기록한 파일은 cds_replay 로 샘플링 설정별 버스 사용량과 반응 지연을 비교하는 데 사용
+int cds_trace_record(int seconds, int hz) {
+    if (seconds < 1 || seconds > 3600 || hz < 1 || hz > CDS_SAMPLER_MAX_HZ) {
+        return -1;
+    }
+
+    if (cds_init() < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&trace_mutex);
+    if (trace_fp) {
+        pthread_mutex_unlock(&trace_mutex);
+        return -1;  // 이미 기록 중
+    }
+
+    trace_fp = fopen(CDS_TRACE_FILE, "w");
+    if (!trace_fp) {
+        pthread_mutex_unlock(&trace_mutex);
+        fprintf(stderr, "[CDS] 기록 파일 열기 실패: %s\n", CDS_TRACE_FILE);
+        return -1;
+    }
+
+    fprintf(trace_fp, "# cds_trace hz=%d threshold=%d band=%d\n", hz,
+            __atomic_load_n(&hyst_threshold, __ATOMIC_RELAXED), __atomic_load_n(&hyst_band, __ATOMIC_RELAXED));
+    trace_start_ms = cds_now_ms();
+    trace_end_ms = trace_start_ms + seconds * 1000LL;
+    trace_count = 0;
+    __atomic_store_n(&trace_hz, hz, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&trace_mutex);
+
+    printf("[CDS] 조도 변화 기록 시작: %d초, %dHz -> %s\n", seconds, hz, CDS_TRACE_FILE);
+    if (cds_sampler_launch() < 0) {
+        return -1;
+    }
+    cds_sampler_kick();
+    return 0;
+}
+
+// 샘플러 중지 (자동 LED 제어 중에는 중지하지 않음)
+int cds_sampler_stop(void) {
+    device_lock(&cds_state);
+
+    if (!sampler_running || auto_led_enabled) {
+        int busy = sampler_running && auto_led_enabled;
+        device_unlock(&cds_state);
+        return busy ? -1 : 0;
+    }
+
+    __atomic_store_n(&sampler_running, 0, __ATOMIC_RELEASE);
+    device_unlock(&cds_state);
+    cds_sampler_kick();
+    pthread_join(sampler_tid, NULL);
+    cds_cache_invalidate();
+
+    printf("[CDS] 샘플러 중지\n");
+    return 0;
+}
+
+// 히스테리시스 설정: threshold 기준 ±band 밖으로 나가야 상태 변경
+int cds_set_hysteresis(int threshold, int band) {
+    if (threshold < 0 || threshold > 255 || band < 0 || band > 127) {
+        return -1;
+    }
+    __atomic_store_n(&hyst_threshold, threshold, __ATOMIC_RELAXED);
+    __atomic_store_n(&hyst_band, band, __ATOMIC_RELAXED);
+    printf("[CDS] 히스테리시스: %d ± %d\n", threshold, band);
+    return 0;
 }
 
 // 자동 LED 제어 시작
 int cds_auto_led_start(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    
-    if (!cds_state.is_initialized && cds_init() < 0) {
-        pthread_mutex_unlock(&cds_state.mutex);
+    // 초기화는 cds_state 를 직접 잡으므로 잠그기 전에
+    if (cds_init() < 0) {
         return -1;
     }
-    
+
+    device_lock(&cds_state);
     if (auto_led_enabled) {
-        pthread_mutex_unlock(&cds_state.mutex);
+        device_unlock(&cds_state);
         return 0;  // 이미 실행 중
     }
-    
-    auto_led_enabled = 1;
-    
+    device_unlock(&cds_state);
+
+    // 자동 LED 는 샘플러의 필터링 결과를 사용
+    if (cds_sampler_launch() < 0) {
+        return -1;
+    }
+
+    device_lock(&cds_state);
+    __atomic_store_n(&auto_led_enabled, 1, __ATOMIC_RELEASE);
+
     if (pthread_create(&auto_led_tid, NULL, auto_led_thread, NULL) != 0) {
         fprintf(stderr, "[CDS] 자동 LED 스레드 생성 실패\n");
-        auto_led_enabled = 0;
-        pthread_mutex_unlock(&cds_state.mutex);
+        __atomic_store_n(&auto_led_enabled, 0, __ATOMIC_RELEASE);
+        device_unlock(&cds_state);
         return -1;
     }
-    
-    pthread_detach(auto_led_tid);
-    pthread_mutex_unlock(&cds_state.mutex);
+
+    device_unlock(&cds_state);
     printf("[CDS] 자동 LED 제어 시작 (GPIO %d)\n", AUTO_LED_PIN);
     return 0;
 }
 
 // 자동 LED 제어 중지
 int cds_auto_led_stop(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    
+    device_lock(&cds_state);
+
     if (!auto_led_enabled) {
-        pthread_mutex_unlock(&cds_state.mutex);
+        device_unlock(&cds_state);
         return 0;  // 이미 중지됨
     }
-    
-    auto_led_enabled = 0;
-    pthread_mutex_unlock(&cds_state.mutex);
-    
+
+    __atomic_store_n(&auto_led_enabled, 0, __ATOMIC_RELEASE);
+    device_unlock(&cds_state);
+
+    // 대기 중인 자동 LED 스레드 깨우기
+    pthread_mutex_lock(&change_mutex);
+    pthread_cond_broadcast(&change_cond);
+    pthread_mutex_unlock(&change_mutex);
+
     // 스레드 종료 대기
     if (auto_led_tid != 0) {
         pthread_join(auto_led_tid, NULL);
         auto_led_tid = 0;
     }
-    
+
     // 자동 LED 끄기
     auto_led_off();
-    
+
     printf("[CDS] 자동 LED 제어 중지\n");
     return 0;
 }
@@ -274,55 +998,133 @@ int auto_led_manual_off(void) {
     return auto_led_off();
 }
 
-// 조도 센서 상태 확인
+// 조도 센서 상태 확인 (잠금 없이 각 값을 원자적으로 읽음, 초기화나 샘플러 시작/중지를 기다리지 않음)
 int cds_get_status(char* status_buf, int buf_size) {
-    pthread_mutex_lock(&cds_state.mutex);
-    
-    if (!cds_state.is_initialized) {
-        snprintf(status_buf, buf_size, "CDS: NOT_INITIALIZED");
-    } else if (auto_led_enabled) {
-        snprintf(status_buf, buf_size, "CDS: AUTO_LED_ON (값:%d, %s)", 
-                current_light_value, is_bright ? "밝음" : "어둠");
+    int sampling = __atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE);
+    int value = sampling ? __atomic_load_n(&filtered_value, __ATOMIC_ACQUIRE) :
+                           __atomic_load_n(&current_light_value, __ATOMIC_ACQUIRE);
+    int bright = sampling ? __atomic_load_n(&filtered_bright, __ATOMIC_ACQUIRE) :
+                            __atomic_load_n(&is_bright, __ATOMIC_ACQUIRE);
+
+    int len = 0;
+    if (!__atomic_load_n(&cds_state.is_initialized, __ATOMIC_ACQUIRE)) {
+        len = snprintf(status_buf, buf_size, "CDS: NOT_INITIALIZED");
+    } else if (__atomic_load_n(&auto_led_enabled, __ATOMIC_ACQUIRE)) {
+        len = snprintf(status_buf, buf_size, "CDS: AUTO_LED_ON (값:%d, %s)",
+                value, bright ? "밝음" : "어둠");
     } else {
-        snprintf(status_buf, buf_size, "CDS: IDLE (값:%d, %s)", 
-                current_light_value, is_bright ? "밝음" : "어둠");
+        len = snprintf(status_buf, buf_size, "CDS: IDLE (값:%d, %s)",
+                value, bright ? "밝음" : "어둠");
+    }
+
+    if (sampling && len < buf_size) {
+        int min_hz = __atomic_load_n(&adapt_min_hz, __ATOMIC_RELAXED);
+        len += snprintf(status_buf + len, buf_size - len, " 샘플러 %dHz", __atomic_load_n(&current_hz, __ATOMIC_RELAXED));
+        if (len < buf_size && min_hz > 0) {
+            len += snprintf(status_buf + len, buf_size - len, " (적응형 %d-%dHz)", min_hz,
+                            __atomic_load_n(&adapt_max_hz, __ATOMIC_RELAXED));
+        }
+        if (len < buf_size) {
+            len += snprintf(status_buf + len, buf_size - len, ", 샘플 %lu, 오류 %lu, 히스테리시스 %d±%d%s",
+                            __atomic_load_n(&ring_head, __ATOMIC_RELAXED), __atomic_load_n(&sampler_errors, __ATOMIC_RELAXED),
+                            __atomic_load_n(&hyst_threshold, __ATOMIC_RELAXED), __atomic_load_n(&hyst_band, __ATOMIC_RELAXED),
+                            __atomic_load_n(&trace_hz, __ATOMIC_RELAXED) ? ", 변화 기록 중" : "");
+        }
     }
-    
-    pthread_mutex_unlock(&cds_state.mutex);
     return 0;
 }
 
+// 규칙 엔진 신호 통지 등록, 등록 즉시 현재 값을 한 번 알림
+void cds_set_signal_hook(signal_hook_fn hook) {
+    __atomic_store_n(&signal_hook, hook, __ATOMIC_RELEASE);
+    if (hook && __atomic_load_n(&sampler_running, __ATOMIC_ACQUIRE)) {
+        int value = __atomic_load_n(&filtered_value, __ATOMIC_ACQUIRE);
+        int bright = __atomic_load_n(&filtered_bright, __ATOMIC_ACQUIRE);
+        if (value >= 0) hook("cds.value", value);
+        if (bright >= 0) hook("cds.bright", bright);
+    }
+}
+
+// 이벤트 발행 함수 등록 (main 이 이벤트 버스의 event_publish 를 전달)
+void cds_set_event_publisher(event_publish_fn publish) {
+    __atomic_store_n(&event_publisher, publish, __ATOMIC_RELEASE);
+}
+
+// 이력 조회: tier 가 CDS_TIER_AUTO 면 구간에 맞는 단계를 골라 *tier 에 기록
+int cds_history_query(long long from_ms, long long to_ms, int* tier, sensor_visit_fn visit, void* ctx) {
+    if (*tier == CDS_TIER_AUTO) {
+        // raw 점 개수는 가장 빠른 주기로 추정 (적응형은 최대 주기, 기록 중이면 기록 주기까지 포함)
+        int hz = __atomic_load_n(&adapt_min_hz, __ATOMIC_RELAXED) > 0 ?
+                 __atomic_load_n(&adapt_max_hz, __ATOMIC_RELAXED) : __atomic_load_n(&sampler_hz, __ATOMIC_RELAXED);
+        int trace = __atomic_load_n(&trace_hz, __ATOMIC_ACQUIRE);
+        if (trace > hz) hz = trace;
+        int raw_period_ms = 1000 / hz;
+        *tier = sensor_store_pick_tier(from_ms, to_ms, raw_period_ms > 0 ? raw_period_ms : 1, CDS_HISTORY_MAX_POINTS);
+    }
+    return sensor_store_query(*tier, from_ms, to_ms, visit, ctx);
+}
+
+// 슬라이딩 윈도우 통계 (window: NULL 이면 전체, "1m"/"15m"/"1h")
+int cds_stats(const char* window, char* buf, int size) {
+    return sensor_stats_format(window, cds_now_ms(), buf, size);
+}
+
+int cds_history_stats(char* buf, int size) {
+    return sensor_store_stats(buf, size);
+}
+
+// 잠금 계측 보고 (make LOCK_STATS=1 빌드가 아니면 -1), 센서 잠금과 자동 LED 잠금
+int cds_lock_stats(char* buf, int size, int reset) {
+    int len = device_lock_report(&cds_state, reset, buf, size);
+    if (len < 0 || len >= size) return len;
+    return len + device_lock_report(&auto_led_state, reset, buf + len, size - len);
+}
+
 // 조도 센서 자원 해제
 void cds_cleanup(void) {
-    pthread_mutex_lock(&cds_state.mutex);
-    
+    device_lock(&cds_state);
+
     running = 0;
-    
+
     // 자동 LED 제어 중지
     if (auto_led_enabled) {
-        auto_led_enabled = 0;
-        pthread_mutex_unlock(&cds_state.mutex);
+        __atomic_store_n(&auto_led_enabled, 0, __ATOMIC_RELEASE);
+        device_unlock(&cds_state);
+        pthread_mutex_lock(&change_mutex);
+        pthread_cond_broadcast(&change_cond);
+        pthread_mutex_unlock(&change_mutex);
         if (auto_led_tid != 0) {
             pthread_join(auto_led_tid, NULL);
             auto_led_tid = 0;
         }
-        pthread_mutex_lock(&cds_state.mutex);
+        device_lock(&cds_state);
     }
-    
+
+    // 샘플러 중지
+    if (sampler_running) {
+        __atomic_store_n(&sampler_running, 0, __ATOMIC_RELEASE);
+        device_unlock(&cds_state);
+        cds_sampler_kick();
+        pthread_join(sampler_tid, NULL);
+        cds_cache_invalidate();
+        device_lock(&cds_state);
+    }
+    sensor_store_close();
+
     // 자동 LED 끄기
     if (auto_led_state.is_initialized) {
         digitalWrite(AUTO_LED_PIN, LOW);
         auto_led_state.is_initialized = 0;
         printf("[AUTO_LED] 자원 해제\n");
     }
-    
+
     if (cds_state.is_initialized) {
         if (cds_fd >= 0) {
             // I2C 연결 정리
         }
-        cds_state.is_initialized = 0;
+        __atomic_store_n(&cds_state.is_initialized, 0, __ATOMIC_RELEASE);
         printf("[CDS] 자원 해제\n");
     }
-    
-    pthread_mutex_unlock(&cds_state.mutex);
+
+    device_unlock(&cds_state);
 }
@@ -1,127 +1,689 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <time.h>
 #include <wiringPi.h>
 #include "control_device.h"
+#include "dev_clock.h"
+#include "seqlock.h"
 
 #define LED_PIN 18
+#define LED_PWM_RANGE 1024
+#define LED_FADE_TICK_MS 10          // 페이드 갱신 주기 (100Hz)
+#define LED_FADE_MAX_MS 3600000      // 페이드 최대 길이 (1시간)
 
-static device_state_t led_state = {0, PTHREAD_MUTEX_INITIALIZER};
+// 지각 밝기 감마 테이블 (CIE 1931 명도 곡선, 컴파일 타임 상수식으로 생성)
+// 인덱스: 밝기 퍼센트(0~100), 값: PWM 듀티 (0~LED_PWM_RANGE)
+#define LED_CIE_Y(p) ((p) <= 8 ? (p) / 903.3 : \
+                      (((p) + 16.0) / 116.0) * (((p) + 16.0) / 116.0) * (((p) + 16.0) / 116.0))
+#define LED_GAMMA(p) ((unsigned short)(LED_CIE_Y(p) * LED_PWM_RANGE + 0.5))
+#define LED_GAMMA10(b) LED_GAMMA((b) + 0), LED_GAMMA((b) + 1), LED_GAMMA((b) + 2), LED_GAMMA((b) + 3), \
+                       LED_GAMMA((b) + 4), LED_GAMMA((b) + 5), LED_GAMMA((b) + 6), LED_GAMMA((b) + 7), \
+                       LED_GAMMA((b) + 8), LED_GAMMA((b) + 9)
+
+static const unsigned short led_gamma_lut[101] = {
+    LED_GAMMA10(0),  LED_GAMMA10(10), LED_GAMMA10(20), LED_GAMMA10(30), LED_GAMMA10(40),
+    LED_GAMMA10(50), LED_GAMMA10(60), LED_GAMMA10(70), LED_GAMMA10(80), LED_GAMMA10(90),
+    LED_GAMMA(100)
+};
+
+static device_state_t led_state = DEVICE_STATE_INITIALIZER("led");
 static int current_brightness = -1;
+static int current_level = 0;        // 현재 밝기 (퍼센트 x 100, 0~10000)
 
-int led_init(void) {
-    pthread_mutex_lock(&led_state.mutex);
-    
+// 페이드 상태 (공유 타이머 스레드 하나가 모든 페이드를 처리)
+typedef struct {
+    int active;
+    int from_level;                  // 시작 밝기 (퍼센트 x 100)
+    int to_level;                    // 목표 밝기 (퍼센트 x 100)
+    int duration_ms;
+    struct timespec start;
+} led_fade_t;
+
+static led_fade_t fade = {0};
+
+// 상태 조회용 공개 사본: led_state 를 잡고 상태를 바꾼 쪽이 led_publish, 조회는 잠금 없이 복사
+typedef struct {
+    int initialized;
+    int brightness;                  // PWM 값
+    int level;                       // 퍼센트 x 100
+    int fading;
+} led_public_t;
+
+static seqlock_t led_public_seq;
+static led_public_t led_public = {0, -1, 0, 0};
+
+// led_state.mutex 를 잡은 상태에서 호출
+static void led_publish(void) {
+    seqlock_write_begin(&led_public_seq);
+    led_public.initialized = led_state.is_initialized;
+    led_public.brightness = current_brightness;
+    led_public.level = current_level;
+    led_public.fading = fade.active;
+    seqlock_write_end(&led_public_seq);
+}
+static pthread_cond_t fade_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t led_timer_tid;
+static int led_timer_started = 0;
+static int led_timer_running = 0;
+
+// 패턴 바이트코드 명령어
+// SET  pct           : 밝기 즉시 설정
+// WAIT ms(16bit)     : 대기
+// RAMP pct ms(16bit) : 현재 밝기에서 pct 까지 선형 변화
+// LOOP count         : 처음으로 되돌아감 (0 = 무한 반복)
+enum {
+    PAT_OP_END = 0,
+    PAT_OP_SET,
+    PAT_OP_WAIT,
+    PAT_OP_RAMP,
+    PAT_OP_LOOP
+};
+
+#define LED_PATTERN_SLOTS 128
+#define LED_PATTERN_CODE_SIZE 48
+#define LED_SIM_PIN_BASE 100             // 이 번호 이상의 핀은 메모리상의 시뮬레이션 핀
+#define LED_SIM_PIN_COUNT 128
+
+// 패턴 실행 슬롯 (핀 하나당 하나)
+typedef struct {
+    int active;
+    int pin;
+    unsigned char code[LED_PATTERN_CODE_SIZE];
+    int pc;
+    int loops_done;
+    int level;                       // 현재 출력 밝기 (퍼센트 x 100)
+    int waiting;                     // 0: 명령 실행 가능, 1: WAIT 중, 2: RAMP 중
+    int ramp_from;
+    int ramp_to;
+    long long step_start_ms;         // 현재 WAIT/RAMP 시작 시각
+    long long step_end_ms;           // 현재 WAIT/RAMP 종료 시각 (누적 기준이라 주기가 밀리지 않음)
+} led_pattern_t;
+
+static led_pattern_t patterns[LED_PATTERN_SLOTS];
+static int patterns_active = 0;
+static unsigned char sim_pin_level[LED_SIM_PIN_COUNT];
+
+// 타이머 스레드 부하 측정
+static unsigned long timer_ticks = 0;
+static unsigned long long timer_tick_ns_total = 0;
+static unsigned long timer_tick_ns_max = 0;
+
+static const struct {
+    const char* name;
+    const char* desc;
+} builtin_patterns[] = {
+    {"blink",     "on 500 off 500"},
+    {"breathe",   "ramp 100 1500 ramp 0 1500"},
+    {"heartbeat", "on 100 off 100 on 100 off 700"},
+    {NULL, NULL}
+};
+
+// 퍼센트 x 100 단위 밝기를 PWM 값으로 변환 (감마 테이블 선형 보간)
+static int led_level_to_pwm(int level) {
+    if (level <= 0) return 0;
+    if (level >= 10000) return led_gamma_lut[100];
+
+    int idx = level / 100;
+    int frac = level % 100;
+    return led_gamma_lut[idx] + (led_gamma_lut[idx + 1] - led_gamma_lut[idx]) * frac / 100;
+}
+
+// PWM 값에 가장 가까운 밝기 레벨 (기존 0~2 단계 명령과 페이드 시작점 연동용)
+static int led_pwm_to_level(int pwm) {
+    int idx = 0;
+    while (idx < 100 && led_gamma_lut[idx + 1] <= pwm) idx++;
+    return idx * 100;
+}
+
+// 32비트 long 은 단조 시계 약 24.8일 뒤 넘치므로 long long (libcds 와 같음)
+static long long led_now_ms(void) {
+    struct timespec now;
+    dev_clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000L;
+}
+
+static long long led_elapsed_ms(const struct timespec* since) {
+    struct timespec now;
+    dev_clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000LL + (now.tv_nsec - since->tv_nsec) / 1000000L;
+}
+
+// led_state.mutex 를 잡은 상태에서 호출
+static void led_apply_level(int level) {
+    int pwm_value = led_level_to_pwm(level);
+    if (pwm_value != current_brightness) {
+        pwmWrite(LED_PIN, pwm_value);
+        current_brightness = pwm_value;
+    }
+    current_level = level;
+}
+
+// 패턴 출력: PWM 핀은 감마 보정, 일반 GPIO 는 50% 기준 ON/OFF, 시뮬레이션 핀은 메모리에 기록
+static void led_pattern_output(led_pattern_t* p, int level) {
+    if (p->pin == LED_PIN) {
+        led_apply_level(level);
+    } else if (p->pin >= LED_SIM_PIN_BASE) {
+        sim_pin_level[p->pin - LED_SIM_PIN_BASE] = (unsigned char)(level / 100);
+    } else if ((level >= 5000) != (p->level >= 5000)) {
+        digitalWrite(p->pin, level >= 5000 ? HIGH : LOW);
+    }
+    p->level = level;
+}
+
+// 텍스트 패턴을 바이트코드로 컴파일 (패턴 시작 시 한 번만 수행)
+// 문법: on <ms> | off <ms> | level <pct> <ms> | ramp <pct> <ms> ... [once | repeat <n>]
+static int led_pattern_compile(const char* desc, unsigned char* code, int code_size) {
+    for (int i = 0; builtin_patterns[i].name; i++) {
+        if (strcmp(desc, builtin_patterns[i].name) == 0) {
+            desc = builtin_patterns[i].desc;
+            break;
+        }
+    }
+
+    int len = 0;
+    long total_ms = 0;
+    int loop_count = 0;
+    const char* p = desc;
+    char word[16];
+    int consumed;
+
+    while (sscanf(p, "%15s%n", word, &consumed) == 1) {
+        p += consumed;
+        int pct = -1, ms = -1;
+
+        if (strcmp(word, "once") == 0) {
+            loop_count = 1;
+            continue;
+        } else if (strcmp(word, "repeat") == 0) {
+            if (sscanf(p, "%d%n", &loop_count, &consumed) != 1 || loop_count < 1 || loop_count > 255) return -1;
+            p += consumed;
+            continue;
+        } else if (strcmp(word, "on") == 0 || strcmp(word, "off") == 0) {
+            pct = word[1] == 'n' ? 100 : 0;
+            if (sscanf(p, "%d%n", &ms, &consumed) != 1) return -1;
+            p += consumed;
+        } else if (strcmp(word, "level") == 0 || strcmp(word, "ramp") == 0) {
+            if (sscanf(p, "%d %d%n", &pct, &ms, &consumed) != 2) return -1;
+            p += consumed;
+        } else {
+            return -1;
+        }
+
+        if (pct < 0 || pct > 100 || ms < 0 || ms > 65535) return -1;
+
+        if (word[0] == 'r') {
+            if (len + 4 > code_size - 3) return -1;
+            code[len++] = PAT_OP_RAMP;
+            code[len++] = (unsigned char)pct;
+        } else {
+            if (len + 5 > code_size - 3) return -1;
+            code[len++] = PAT_OP_SET;
+            code[len++] = (unsigned char)pct;
+            code[len++] = PAT_OP_WAIT;
+        }
+        code[len++] = (unsigned char)(ms & 0xFF);
+        code[len++] = (unsigned char)(ms >> 8);
+        total_ms += ms;
+    }
+
+    // 길이 0 인 무한 반복은 타이머 틱 안에서 끝나지 않으므로 거부
+    if (len == 0 || (loop_count != 1 && total_ms == 0)) return -1;
+
+    if (loop_count != 1) {
+        code[len++] = PAT_OP_LOOP;
+        code[len++] = (unsigned char)loop_count;
+    }
+    code[len++] = PAT_OP_END;
+    return len;
+}
+
+// 슬롯 하나를 현재 시각까지 진행 (문자열 파싱/메모리 할당 없음)
+static void led_pattern_step(led_pattern_t* p, long long now_ms) {
+    for (;;) {
+        if (p->waiting) {
+            if (now_ms < p->step_end_ms) {
+                if (p->waiting == 2) {
+                    long long span = p->step_end_ms - p->step_start_ms;
+                    long long done = now_ms - p->step_start_ms;
+                    led_pattern_output(p, p->ramp_from + (int)((p->ramp_to - p->ramp_from) * done / span));
+                }
+                return;
+            }
+            if (p->waiting == 2) {
+                led_pattern_output(p, p->ramp_to);
+            }
+            p->waiting = 0;
+        }
+
+        const unsigned char* op = &p->code[p->pc];
+        switch (op[0]) {
+            case PAT_OP_SET:
+                led_pattern_output(p, op[1] * 100);
+                p->pc += 2;
+                break;
+            case PAT_OP_WAIT:
+                p->step_start_ms = p->step_end_ms;
+                p->step_end_ms += op[1] | (op[2] << 8);
+                p->waiting = 1;
+                p->pc += 3;
+                break;
+            case PAT_OP_RAMP:
+                p->ramp_from = p->level;
+                p->ramp_to = op[1] * 100;
+                p->step_start_ms = p->step_end_ms;
+                p->step_end_ms += op[2] | (op[3] << 8);
+                p->waiting = 2;
+                p->pc += 4;
+                break;
+            case PAT_OP_LOOP:
+                if (op[1] == 0 || ++p->loops_done < op[1]) {
+                    p->pc = 0;
+                } else {
+                    p->pc += 2;
+                }
+                break;
+            default:
+                p->active = 0;
+                patterns_active--;
+                return;
+        }
+    }
+}
+
+// 핀에서 실행 중인 패턴 해제 (led_state.mutex 를 잡은 상태에서 호출)
+// 일반 GPIO 는 HIGH 단계에서 멈췄을 수 있으므로 시작할 때처럼 LOW 로 (PWM LED 는 호출한 쪽이 밝기를 정함)
+static void led_pattern_release(int pin) {
+    for (int i = 0; i < LED_PATTERN_SLOTS; i++) {
+        if (patterns[i].active && (pin < 0 || patterns[i].pin == pin)) {
+            patterns[i].active = 0;
+            patterns_active--;
+            if (patterns[i].pin != LED_PIN && patterns[i].pin < LED_SIM_PIN_BASE) {
+                digitalWrite(patterns[i].pin, LOW);
+            }
+        }
+    }
+}
+
+// 공유 타이머 스레드: 고정 주기(절대 데드라인)로 진행 중인 페이드와 패턴을 한 단계씩 진행
+static void* led_timer_thread(void* arg) {
+    (void)arg;
+    struct timespec next, tick_start, tick_end;
+    dev_clock_gettime(CLOCK_MONOTONIC, &next);
+
+    device_lock(&led_state);
+    while (led_timer_running) {
+        if (!fade.active && patterns_active == 0) {
+            device_cond_wait(&fade_cond, &led_state);
+            dev_clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &tick_start);
+
+        if (fade.active) {
+            long long elapsed = led_elapsed_ms(&fade.start);
+            if (elapsed >= fade.duration_ms) {
+                led_apply_level(fade.to_level);
+                fade.active = 0;
+                printf("[LED] 페이드 완료 (%d%%)\n", fade.to_level / 100);
+            } else {
+                int delta = fade.to_level - fade.from_level;
+                led_apply_level(fade.from_level + (int)(delta * elapsed / fade.duration_ms));
+            }
+        }
+
+        if (patterns_active > 0) {
+            long long now_ms = led_now_ms();
+            for (int i = 0; i < LED_PATTERN_SLOTS; i++) {
+                if (patterns[i].active) {
+                    led_pattern_step(&patterns[i], now_ms);
+                }
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &tick_end);
+        unsigned long tick_ns = (tick_end.tv_sec - tick_start.tv_sec) * 1000000000UL +
+                                tick_end.tv_nsec - tick_start.tv_nsec;
+        timer_ticks++;
+        timer_tick_ns_total += tick_ns;
+        if (tick_ns > timer_tick_ns_max) timer_tick_ns_max = tick_ns;
+        led_publish();
+        device_unlock(&led_state);
+
+        next.tv_nsec += LED_FADE_TICK_MS * 1000000L;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        dev_sleep_until(CLOCK_MONOTONIC, &next);
+
+        device_lock(&led_state);
+    }
+    device_unlock(&led_state);
+    return NULL;
+}
+
+// 공유 타이머 스레드가 없으면 시작 (led_state.mutex 를 잡은 상태에서 호출)
+static int led_timer_ensure(void) {
+    if (led_timer_started) {
+        return 0;
+    }
+
+    led_timer_running = 1;
+    if (pthread_create(&led_timer_tid, NULL, led_timer_thread, NULL) != 0) {
+        fprintf(stderr, "[LED] 타이머 스레드 생성 실패\n");
+        led_timer_running = 0;
+        return -1;
+    }
+    led_timer_started = 1;
+    return 0;
+}
+
+// 하드웨어 초기화 (led_state 잠금을 잡은 채 호출, 이미 되어 있으면 바로 0)
+// 잠금을 잡은 함수가 led_init 을 다시 부르면 같은 스레드가 같은 잠금을 두 번 잡아 멈춤
+static int led_setup(void) {
     if (led_state.is_initialized) {
-        pthread_mutex_unlock(&led_state.mutex);
         return 0;
     }
-    
+
     if (wiringPiSetupGpio() == -1) {
         fprintf(stderr, "[LED] wiringPi 초기화 실패\n");
-        pthread_mutex_unlock(&led_state.mutex);
         return -1;
     }
-    
+
     pinMode(LED_PIN, PWM_OUTPUT);
     pwmSetMode(PWM_MODE_MS);
-    pwmSetRange(1024);
+    pwmSetRange(LED_PWM_RANGE);
     pwmSetClock(375);
     pwmWrite(LED_PIN, 0);
-    
+
     led_state.is_initialized = 1;
-    pthread_mutex_unlock(&led_state.mutex);
+    led_publish();
     printf("[LED] 초기화 완료 (GPIO %d)\n", LED_PIN);
     return 0;
 }
 
+int led_init(void) {
+    device_lock(&led_state);
+    int result = led_setup();
+    device_unlock(&led_state);
+    return result;
+}
+
 int led_on(void) {
-    pthread_mutex_lock(&led_state.mutex);
-    
-    if (!led_state.is_initialized && led_init() < 0) {
-        pthread_mutex_unlock(&led_state.mutex);
+    device_lock(&led_state);
+
+    if (led_setup() < 0) {
+        device_unlock(&led_state);
         return -1;
     }
-    
+
+    fade.active = 0;
+    led_pattern_release(LED_PIN);
     pwmWrite(LED_PIN, 1024);
     current_brightness = 1024;
+    current_level = 10000;
+    led_publish();
     printf("[LED] ON\n");
-    
-    pthread_mutex_unlock(&led_state.mutex);
+
+    device_unlock(&led_state);
     return 0;
 }
 
 int led_off(void) {
-    pthread_mutex_lock(&led_state.mutex);
-    
-    if (!led_state.is_initialized && led_init() < 0) {
-        pthread_mutex_unlock(&led_state.mutex);
+    device_lock(&led_state);
+
+    if (led_setup() < 0) {
+        device_unlock(&led_state);
         return -1;
     }
-    
+
+    fade.active = 0;
+    led_pattern_release(LED_PIN);
     pwmWrite(LED_PIN, 0);
     current_brightness = 0;
+    current_level = 0;
+    led_publish();
     printf("[LED] OFF\n");
-    
-    pthread_mutex_unlock(&led_state.mutex);
+
+    device_unlock(&led_state);
     return 0;
 }
 
 int led_brightness(int level) {
-    pthread_mutex_lock(&led_state.mutex);
-    
-    if (!led_state.is_initialized && led_init() < 0) {
-        pthread_mutex_unlock(&led_state.mutex);
+    device_lock(&led_state);
+
+    if (led_setup() < 0) {
+        device_unlock(&led_state);
         return -1;
     }
-    
+
     int pwm_value;
     switch (level) {
         case 0: pwm_value = 102; break;   // 10%
         case 1: pwm_value = 512; break;   // 50%
         case 2: pwm_value = 1024; break;  // 100%
         default:
-            pthread_mutex_unlock(&led_state.mutex);
+            device_unlock(&led_state);
             return -1;
     }
-    
+
+    fade.active = 0;
+    led_pattern_release(LED_PIN);
     pwmWrite(LED_PIN, pwm_value);
     current_brightness = pwm_value;
+    current_level = led_pwm_to_level(pwm_value);
+    led_publish();
     printf("[LED] 밝기 레벨 %d\n", level);
-    
-    pthread_mutex_unlock(&led_state.mutex);
+
+    device_unlock(&led_state);
+    return 0;
+}
+
+// 0~100% 밝기 설정 (감마 보정 적용)
+int led_set_percent(int percent) {
+    if (percent < 0 || percent > 100) {
+        return -1;
+    }
+
+    if (led_init() < 0) {
+        return -1;
+    }
+
+    device_lock(&led_state);
+    fade.active = 0;
+    led_pattern_release(LED_PIN);
+    led_apply_level(percent * 100);
+    led_publish();
+    printf("[LED] 밝기 %d%% (PWM %d)\n", percent, current_brightness);
+    device_unlock(&led_state);
+    return 0;
+}
+
+// 현재 밝기에서 목표 밝기까지 duration_ms 동안 페이드
+// 진행 중인 페이드는 join 없이 상태만 교체하여 취소됨
+int led_fade(int target_percent, int duration_ms) {
+    if (target_percent < 0 || target_percent > 100 ||
+        duration_ms < 0 || duration_ms > LED_FADE_MAX_MS) {
+        return -1;
+    }
+
+    if (led_init() < 0) {
+        return -1;
+    }
+
+    device_lock(&led_state);
+    led_pattern_release(LED_PIN);
+
+    if (duration_ms == 0) {
+        fade.active = 0;
+        led_apply_level(target_percent * 100);
+        led_publish();
+        device_unlock(&led_state);
+        return 0;
+    }
+
+    if (led_timer_ensure() < 0) {
+        device_unlock(&led_state);
+        return -1;
+    }
+
+    fade.from_level = current_level;
+    fade.to_level = target_percent * 100;
+    fade.duration_ms = duration_ms;
+    dev_clock_gettime(CLOCK_MONOTONIC, &fade.start);
+    fade.active = 1;
+    led_publish();
+    pthread_cond_signal(&fade_cond);
+
+    printf("[LED] 페이드 시작: %d%% -> %d%% (%dms)\n", current_level / 100, target_percent, duration_ms);
+    device_unlock(&led_state);
     return 0;
 }
 
+// 핀에 패턴 시작 (pin: GPIO 번호 또는 LED_SIM_PIN_BASE 이상의 시뮬레이션 핀)
+// desc: blink | breathe | heartbeat | 사용자 정의 텍스트 패턴
+int led_pattern_start(int pin, const char* desc) {
+    unsigned char code[LED_PATTERN_CODE_SIZE];
+
+    if (pin < 0 || pin >= LED_SIM_PIN_BASE + LED_SIM_PIN_COUNT || !desc) {
+        return -1;
+    }
+
+    if (led_pattern_compile(desc, code, sizeof(code)) < 0) {
+        printf("[LED] 잘못된 패턴: %s\n", desc);
+        return -1;
+    }
+
+    if (led_init() < 0) {
+        return -1;
+    }
+
+    device_lock(&led_state);
+
+    if (pin == LED_PIN) {
+        fade.active = 0;
+    }
+    led_pattern_release(pin);
+
+    led_pattern_t* slot = NULL;
+    for (int i = 0; i < LED_PATTERN_SLOTS; i++) {
+        if (!patterns[i].active) {
+            slot = &patterns[i];
+            break;
+        }
+    }
+
+    if (!slot || led_timer_ensure() < 0) {
+        device_unlock(&led_state);
+        return -1;
+    }
+
+    if (pin != LED_PIN && pin < LED_SIM_PIN_BASE) {
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+    }
+
+    memcpy(slot->code, code, sizeof(code));
+    slot->pin = pin;
+    slot->pc = 0;
+    slot->loops_done = 0;
+    slot->waiting = 0;
+    slot->level = pin == LED_PIN ? current_level : 0;
+    slot->step_end_ms = led_now_ms();
+    slot->active = 1;
+    patterns_active++;
+    pthread_cond_signal(&fade_cond);
+
+    printf("[LED] 패턴 시작 (GPIO %d): %s\n", pin, desc);
+    device_unlock(&led_state);
+    return 0;
+}
+
+// 패턴 중지 (pin < 0 이면 전체 중지)
+int led_pattern_stop(int pin) {
+    device_lock(&led_state);
+    led_pattern_release(pin);
+    device_unlock(&led_state);
+    printf("[LED] 패턴 중지 (%s)\n", pin < 0 ? "전체" : "단일 핀");
+    return 0;
+}
+
+// 타이머 스레드 부하 통계
+int led_pattern_stats(char* status_buf, int buf_size) {
+    device_lock(&led_state);
+
+    double cpu_ms = 0.0;
+    clockid_t cid;
+    struct timespec cpu;
+    if (led_timer_started && pthread_getcpuclockid(led_timer_tid, &cid) == 0 &&
+        clock_gettime(cid, &cpu) == 0) {
+        cpu_ms = cpu.tv_sec * 1000.0 + cpu.tv_nsec / 1000000.0;
+    }
+
+    snprintf(status_buf, buf_size, "패턴 %d개 실행 중, tick %lu회, 평균 %lluns, 최대 %luns, 타이머 CPU %.1fms",
+             patterns_active, timer_ticks,
+             timer_ticks ? timer_tick_ns_total / timer_ticks : 0ULL, timer_tick_ns_max, cpu_ms);
+
+    device_unlock(&led_state);
+    return 0;
+}
+
+// 상태 조회 (잠금 없이 공개 사본을 읽음, 페이드/패턴 진행이나 밝기 변경을 기다리지 않음)
 int led_get_status(char* status_buf, int buf_size) {
-    pthread_mutex_lock(&led_state.mutex);
-    
-    if (!led_state.is_initialized) {
+    led_public_t st;
+    unsigned long seq;
+    do {
+        seq = seqlock_read_begin(&led_public_seq);
+        st = led_public;
+    } while (seqlock_read_retry(&led_public_seq, seq));
+
+    const char* fading = st.fading ? ", FADING" : "";
+    if (!st.initialized) {
         snprintf(status_buf, buf_size, "LED: NOT_INITIALIZED");
-    } else if (current_brightness == 0) {
-        snprintf(status_buf, buf_size, "LED: OFF");
-    } else if (current_brightness <= 102) {
-        snprintf(status_buf, buf_size, "LED: LOW");
-    } else if (current_brightness <= 512) {
-        snprintf(status_buf, buf_size, "LED: MIDDLE");
+    } else if (st.brightness == 0) {
+        snprintf(status_buf, buf_size, "LED: OFF%s", fading);
+    } else if (st.brightness <= 102) {
+        snprintf(status_buf, buf_size, "LED: LOW (%d%%%s)", st.level / 100, fading);
+    } else if (st.brightness <= 512) {
+        snprintf(status_buf, buf_size, "LED: MIDDLE (%d%%%s)", st.level / 100, fading);
     } else {
-        snprintf(status_buf, buf_size, "LED: HIGH");
+        snprintf(status_buf, buf_size, "LED: HIGH (%d%%%s)", st.level / 100, fading);
     }
-    
-    pthread_mutex_unlock(&led_state.mutex);
     return 0;
 }
 
+// 잠금 계측 보고 (make LOCK_STATS=1 빌드가 아니면 -1)
+int led_lock_stats(char* buf, int size, int reset) {
+    return device_lock_report(&led_state, reset, buf, size);
+}
+
 void led_cleanup(void) {
-    pthread_mutex_lock(&led_state.mutex);
-    
+    device_lock(&led_state);
+
+    fade.active = 0;
+    led_pattern_release(-1);
+    if (led_timer_started) {
+        led_timer_running = 0;
+        pthread_cond_signal(&fade_cond);
+        device_unlock(&led_state);
+        pthread_join(led_timer_tid, NULL);
+        device_lock(&led_state);
+        led_timer_started = 0;
+    }
+
     if (led_state.is_initialized) {
         pwmWrite(LED_PIN, 0);
         led_state.is_initialized = 0;
         current_brightness = 0;
+        current_level = 0;
+        led_publish();
         printf("[LED] 자원 해제\n");
     }
-    
-    pthread_mutex_unlock(&led_state.mutex);
+
+    device_unlock(&led_state);
 }
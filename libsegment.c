@@ -1,12 +1,13 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <wiringPi.h>
 #include <signal.h>
-#include <dlfcn.h>
 #include <sys/time.h>
 #include "control_device.h"
+#include "dev_clock.h"
 
 #define FND_PINS_COUNT 4
 static int fnd_pins[FND_PINS_COUNT] = {16, 20, 21, 12};
@@ -16,31 +17,37 @@ static int number_patterns[10][4] = {
 };
 
 // FND 상태 관리
-static device_state_t fnd_state = {0, PTHREAD_MUTEX_INITIALIZER};
+static device_state_t fnd_state = DEVICE_STATE_INITIALIZER("segment");
 static int display_time = 1;
 static pthread_t auto_off_tid = 0;
-static pthread_t countdown_tid = 0;
-static volatile int is_counting = 0;
+static volatile int is_counting = 0;     // 상태 조회가 잠금 없이 읽음 (원자적 쓰기)
 static volatile int running = 1;
-static volatile int countdown_stop_requested = 0;
-
-// 부저 함수 포인터 (동적 로딩용)
-static int (*buzzer_play_func)(void) = NULL;
-static int (*buzzer_stop_func)(void) = NULL;
-static void* buzzer_lib = NULL;
-
-// 부저 라이브러리 로딩
-static void load_buzzer_functions() {
-    if (buzzer_lib == NULL) {
-        buzzer_lib = dlopen("./libbuzzer.so", RTLD_LAZY);
-        if (buzzer_lib) {
-            buzzer_play_func = dlsym(buzzer_lib, "buzzer_play");
-            buzzer_stop_func = dlsym(buzzer_lib, "buzzer_stop");
-            printf("[FND] 부저 라이브러리 로딩 성공\n");
-        } else {
-            printf("[FND] 부저 라이브러리 로딩 실패: %s\n", dlerror());
-        }
-    }
+
+// 카운트다운: 상주 스레드 하나가 데드라인마다 한 칸씩 진행 (아래 값은 모두 fnd_state 잠금으로 보호)
+// 중지/새 시작은 값을 바꾸고 깨우기만 하므로 스레드 종료를 기다리지 않음
+static pthread_t countdown_tid;
+static int countdown_started = 0;
+static pthread_cond_t countdown_cond;        // 시작/중지/종료 알림 (단조 시계 기준)
+static int countdown_value = -1;             // 지금 표시 중인 남은 카운트
+static int countdown_start_num = 0;
+static struct timespec countdown_deadline;   // 다음 칸으로 넘어갈 시각
+static unsigned long countdown_gen = 0;      // 표시를 바꾸는 요청마다 증가 (잠금을 놓은 사이 바뀌었는지 확인)
+
+// 규칙 엔진 신호 통지 (segment.value = 표시 숫자, segment.countdown = 남은 카운트, 꺼짐/없음은 -1)
+static signal_hook_fn signal_hook = NULL;
+static int shown_value = -1;
+
+static void fnd_signal(const char* name, int value) {
+    signal_hook_fn hook = __atomic_load_n(&signal_hook, __ATOMIC_ACQUIRE);
+    if (hook) hook(name, value);
+}
+
+// 이벤트 발행 (countdown.tick / countdown.finished, 부저 등 반응은 구독자가 담당)
+static event_publish_fn event_publisher = NULL;
+
+static int fnd_publish(int type, int value) {
+    event_publish_fn publish = __atomic_load_n(&event_publisher, __ATOMIC_ACQUIRE);
+    return publish ? publish(type, value) : 0;
 }
 
 // 자동 꺼짐 스레드
@@ -51,140 +58,135 @@ void *auto_off_thread(void *arg) {
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
 
-    sleep(seconds);
+    dev_sleep_ms(seconds * 1000U);
     
-    pthread_mutex_lock(&fnd_state.mutex);
+    device_lock(&fnd_state);
     if (fnd_state.is_initialized) {
         for (int i = 0; i < FND_PINS_COUNT; i++) {
             digitalWrite(fnd_pins[i], HIGH);
         }
+        shown_value = -1;
+        fnd_signal("segment.value", -1);
         printf("[FND] 자동 꺼짐\n");
     }
-    pthread_mutex_unlock(&fnd_state.mutex);
+    device_unlock(&fnd_state);
     
     auto_off_tid = 0;
     return NULL;
 }
 
-// 카운트다운 스레드 (수정된 버전)
-void *countdown_thread(void *arg) {
-    int start_num = *((int *)arg);
-    free(arg);
-    
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
-    
-    pthread_mutex_lock(&fnd_state.mutex);
-    is_counting = 1;
-    countdown_stop_requested = 0;
-    pthread_mutex_unlock(&fnd_state.mutex);
-
-    printf("[FND] 카운트다운 스레드 시작: %d\n", start_num);
-
-    for (int i = start_num; i >= 0; i--) {
-        // 중지 요청 확인
-        pthread_mutex_lock(&fnd_state.mutex);
-        int should_stop = countdown_stop_requested || !running;
-        pthread_mutex_unlock(&fnd_state.mutex);
-        
-        if (should_stop) {
-            printf("[FND] 카운트다운 중지 요청 감지\n");
-            break;
+// 숫자 표시 (num < 0 이면 끄기), fnd_state 잠금을 잡은 채 호출
+static void fnd_write(int num) {
+    for (int i = 0; i < FND_PINS_COUNT; i++) {
+        digitalWrite(fnd_pins[i], num < 0 || number_patterns[num][i] ? HIGH : LOW);
+    }
+    shown_value = num;
+    fnd_signal("segment.value", num);
+}
+
+// 진행 중인 카운트다운 취소 (잠금을 잡은 채 호출, 표시를 바꾸는 요청마다 부름)
+static void countdown_cancel(void) {
+    countdown_gen++;
+    if (!is_counting) return;
+
+    __atomic_store_n(&is_counting, 0, __ATOMIC_RELEASE);
+    countdown_value = -1;
+    fnd_signal("segment.countdown", -1);
+    pthread_cond_signal(&countdown_cond);
+    printf("[FND] 진행 중인 카운트다운 중지\n");
+}
+
+static int deadline_reached(const struct timespec* deadline) {
+    struct timespec now;
+    dev_clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+// 카운트다운 스레드: 시작할 때 한 번 만들고 fnd_cleanup 까지 유지
+static void* countdown_thread(void* arg) {
+    (void)arg;
+    device_lock(&fnd_state);
+
+    while (running) {
+        if (!is_counting) {
+            device_cond_wait(&countdown_cond, &fnd_state);
+            continue;
         }
-        
-        // 숫자 표시
-        pthread_mutex_lock(&fnd_state.mutex);
-        if (fnd_state.is_initialized) {
-            for (int j = 0; j < FND_PINS_COUNT; j++) {
-                digitalWrite(fnd_pins[j], number_patterns[i][j] ? HIGH : LOW);
-            }
-            printf("[FND] 카운트다운: %d\n", i);
+        if (!deadline_reached(&countdown_deadline)) {
+            device_cond_timedwait(&countdown_cond, &fnd_state, &countdown_deadline);
+            continue;
         }
-        pthread_mutex_unlock(&fnd_state.mutex);
-
-        if (i > 0) {
-            // 1초 대기 (취소 포인트)
-            for (int wait = 0; wait < 10; wait++) {
-                delay(100); // 0.1초씩 대기 (wiringPi의 delay 함수 사용)
-                pthread_testcancel();
-                
-                pthread_mutex_lock(&fnd_state.mutex);
-                int should_stop = countdown_stop_requested || !running;
-                pthread_mutex_unlock(&fnd_state.mutex);
-                
-                if (should_stop) break;
-            }
-        } else {
-            // 0이 되면 부저 울림
-            printf("[FND] 카운트다운 완료! 부저 울림\n");
-            
-            // 부저 라이브러리 로딩 시도
-            if (!buzzer_play_func) {
-                load_buzzer_functions();
-            }
-            
-            // 부저 함수 호출
-            if (buzzer_play_func) {
-                printf("[FND] 부저 재생 시작\n");
-                buzzer_play_func();
-                
-                // 3초간 부저 재생
-                for (int wait = 0; wait < 30; wait++) { // 3초 = 30 * 0.1초
-                    delay(100); // 0.1초씩 대기 (wiringPi의 delay 함수 사용)
-                    pthread_testcancel();
-                    
-                    pthread_mutex_lock(&fnd_state.mutex);
-                    int should_stop = countdown_stop_requested || !running;
-                    pthread_mutex_unlock(&fnd_state.mutex);
-                    
-                    if (should_stop) break;
-                }
-                
-                if (buzzer_stop_func) {
-                    printf("[FND] 부저 재생 중지\n");
-                    buzzer_stop_func();
-                }
-            } else {
-                printf("[FND] 부저 함수를 찾을 수 없음 - 대신 비ープ음 출력\n");
-                // 대안: 시스템 비프음
-                system("echo -e '\\a'");
-            }
-            
-            // FND 끄기
-            pthread_mutex_lock(&fnd_state.mutex);
-            if (fnd_state.is_initialized) {
-                for (int j = 0; j < FND_PINS_COUNT; j++) {
-                    digitalWrite(fnd_pins[j], HIGH);
-                }
-                printf("[FND] 카운트다운 완료 후 꺼짐\n");
-            }
-            pthread_mutex_unlock(&fnd_state.mutex);
+
+        int value = --countdown_value;
+        fnd_write(value);
+        fnd_signal("segment.countdown", value);
+        printf("[FND] 카운트다운: %d\n", value);
+
+        if (value > 0) {
+            countdown_deadline.tv_sec++;
+            device_unlock(&fnd_state);
+            fnd_publish(EVENT_COUNTDOWN_TICK, value);
+            device_lock(&fnd_state);
+            continue;
+        }
+
+        // 0 이 되면 완료 이벤트 발행 (부저 알람은 구독자가 요청)
+        int start_num = countdown_start_num;
+        unsigned long gen = ++countdown_gen;
+        __atomic_store_n(&is_counting, 0, __ATOMIC_RELEASE);
+        countdown_value = -1;
+        fnd_signal("segment.countdown", -1);
+        device_unlock(&fnd_state);
+
+        printf("[FND] 카운트다운 완료! 완료 이벤트 발행\n");
+        if (fnd_publish(EVENT_COUNTDOWN_FINISHED, start_num) <= 0) {
+            printf("[FND] 완료 이벤트 구독자 없음 - 대신 비프음 출력\n");
+            // 대안: 시스템 비프음
+            system("echo -e '\\a'");
+        }
+
+        // 그 사이 다른 표시 요청이 없었으면 끄기
+        device_lock(&fnd_state);
+        if (gen == countdown_gen && fnd_state.is_initialized) {
+            fnd_write(-1);
+            printf("[FND] 카운트다운 완료 후 꺼짐\n");
         }
     }
 
-    // 스레드 종료 처리
-    pthread_mutex_lock(&fnd_state.mutex);
-    is_counting = 0;
-    countdown_stop_requested = 0;
-    countdown_tid = 0;
-    pthread_mutex_unlock(&fnd_state.mutex);
-    
+    device_unlock(&fnd_state);
     printf("[FND] 카운트다운 스레드 종료\n");
     return NULL;
 }
 
-// FND 초기화
-int fnd_init(void) {
-    pthread_mutex_lock(&fnd_state.mutex);
+// 카운트다운 스레드가 없으면 시작 (잠금을 잡은 채 호출)
+static int countdown_launch(void) {
+    if (countdown_started) return 0;
+
+    // 데드라인 대기는 단조 시계 기준
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&countdown_cond, &attr);
+    pthread_condattr_destroy(&attr);
 
+    if (pthread_create(&countdown_tid, NULL, countdown_thread, NULL) != 0) {
+        printf("[FND] 카운트다운 스레드 생성 실패\n");
+        pthread_cond_destroy(&countdown_cond);
+        return -1;
+    }
+    countdown_started = 1;
+    return 0;
+}
+
+// 핀 초기화 (fnd_state 잠금을 잡은 채 호출, 이미 되어 있으면 바로 0)
+// 잠금을 잡은 함수가 fnd_init 을 다시 부르면 같은 잠금을 두 번 잡아 멈춤
+static int fnd_setup(void) {
     if (fnd_state.is_initialized) {
-        pthread_mutex_unlock(&fnd_state.mutex);
         return 0;
     }
 
     if (wiringPiSetupGpio() == -1) {
         fprintf(stderr, "[FND] wiringPiSetupGpio 초기화 실패\n");
-        pthread_mutex_unlock(&fnd_state.mutex);
         return -1;
     }
 
@@ -194,94 +196,65 @@ int fnd_init(void) {
         digitalWrite(fnd_pins[i], HIGH);  // 초기에는 꺼진 상태
     }
 
-    fnd_state.is_initialized = 1;
+    __atomic_store_n(&fnd_state.is_initialized, 1, __ATOMIC_RELEASE);
     running = 1;
-    
-    // 부저 라이브러리 미리 로딩
-    load_buzzer_functions();
-    
-    pthread_mutex_unlock(&fnd_state.mutex);
     printf("[FND] 초기화 완료\n");
     return 0;
 }
 
-// FND에 숫자 표시
-int fnd_display(int num) {
-    pthread_mutex_lock(&fnd_state.mutex);
-
-    if (!fnd_state.is_initialized && fnd_init() < 0) {
-        pthread_mutex_unlock(&fnd_state.mutex);
-        return -1;
-    }
+// FND 초기화
+int fnd_init(void) {
+    device_lock(&fnd_state);
+    int result = fnd_setup();
+    device_unlock(&fnd_state);
+    return result;
+}
 
+// FND에 숫자 표시 (진행 중인 카운트다운은 취소)
+int fnd_display(int num) {
     if (num < 0 || num > 9) {
-        pthread_mutex_unlock(&fnd_state.mutex);
         return -1;
     }
 
-    // 진행 중인 카운트다운이 있으면 중지
-    if (is_counting && countdown_tid != 0) {
-        countdown_stop_requested = 1;
-        pthread_mutex_unlock(&fnd_state.mutex);
-        
-        // 카운트다운 스레드 종료 대기
-        printf("[FND] 기존 카운트다운 중지 중...\n");
-        pthread_join(countdown_tid, NULL);
-        
-        pthread_mutex_lock(&fnd_state.mutex);
-        is_counting = 0;
-        countdown_stop_requested = 0;
-        countdown_tid = 0;
-    }
+    device_lock(&fnd_state);
 
-    for (int i = 0; i < FND_PINS_COUNT; i++) {
-        digitalWrite(fnd_pins[i], number_patterns[num][i] ? HIGH : LOW);
+    if (fnd_setup() < 0) {
+        device_unlock(&fnd_state);
+        return -1;
     }
 
+    countdown_cancel();
+    fnd_write(num);
     printf("[FND] 숫자 %d 표시\n", num);
-    pthread_mutex_unlock(&fnd_state.mutex);
+
+    device_unlock(&fnd_state);
     return 0;
 }
 
 // FND 끄기
 void fnd_off(void) {
-    pthread_mutex_lock(&fnd_state.mutex);
-
-    // 진행 중인 카운트다운이 있으면 중지
-    if (is_counting && countdown_tid != 0) {
-        countdown_stop_requested = 1;
-        pthread_mutex_unlock(&fnd_state.mutex);
-        
-        printf("[FND] 카운트다운 중지 중...\n");
-        pthread_join(countdown_tid, NULL);
-        
-        pthread_mutex_lock(&fnd_state.mutex);
-        is_counting = 0;
-        countdown_stop_requested = 0;
-        countdown_tid = 0;
-    }
+    device_lock(&fnd_state);
 
+    countdown_cancel();
     if (fnd_state.is_initialized) {
-        for (int i = 0; i < FND_PINS_COUNT; i++) {
-            digitalWrite(fnd_pins[i], HIGH);
-        }
+        fnd_write(-1);
         printf("[FND] 꺼짐\n");
     }
 
-    pthread_mutex_unlock(&fnd_state.mutex);
+    device_unlock(&fnd_state);
 }
 
-// 카운트다운 시작 (수정된 버전)
+// 카운트다운 시작: 시작 숫자를 바로 표시하고 1초마다 -1 (진행 중인 카운트다운은 새것으로 대체)
 int fnd_countdown(int start_num) {
     if (start_num < 1 || start_num > 9) {
         printf("[FND] 잘못된 카운트다운 값: %d (1-9 범위여야 함)\n", start_num);
         return -1;
     }
 
-    pthread_mutex_lock(&fnd_state.mutex);
+    device_lock(&fnd_state);
 
-    if (!fnd_state.is_initialized && fnd_init() < 0) {
-        pthread_mutex_unlock(&fnd_state.mutex);
+    if (fnd_setup() < 0 || countdown_launch() < 0) {
+        device_unlock(&fnd_state);
         return -1;
     }
 
@@ -291,78 +264,53 @@ int fnd_countdown(int start_num) {
         auto_off_tid = 0;
     }
 
-    // 이미 카운트다운 중이면 중지
-    if (is_counting && countdown_tid != 0) {
-        countdown_stop_requested = 1;
-        pthread_mutex_unlock(&fnd_state.mutex);
-        
-        printf("[FND] 기존 카운트다운 중지 중...\n");
-        pthread_join(countdown_tid, NULL);
-        
-        pthread_mutex_lock(&fnd_state.mutex);
-        is_counting = 0;
-        countdown_stop_requested = 0;
-        countdown_tid = 0;
-    }
-
-    // 카운트다운 스레드 시작
-    int *start_ptr = malloc(sizeof(int));
-    if (!start_ptr) {
-        printf("[FND] 메모리 할당 실패\n");
-        pthread_mutex_unlock(&fnd_state.mutex);
-        return -1;
-    }
-    *start_ptr = start_num;
-
-    int result = pthread_create(&countdown_tid, NULL, countdown_thread, start_ptr);
-    if (result != 0) {
-        printf("[FND] 카운트다운 스레드 생성 실패: %d\n", result);
-        free(start_ptr);
-        pthread_mutex_unlock(&fnd_state.mutex);
-        return -1;
-    }
-
-    // detach 사용으로 자동 정리
-    pthread_detach(countdown_tid);
+    countdown_cancel();
+    countdown_start_num = start_num;
+    countdown_value = start_num;
+    dev_clock_gettime(CLOCK_MONOTONIC, &countdown_deadline);
+    countdown_deadline.tv_sec++;
+    __atomic_store_n(&is_counting, 1, __ATOMIC_RELEASE);
 
+    fnd_write(start_num);
+    fnd_signal("segment.countdown", start_num);
+    pthread_cond_signal(&countdown_cond);
     printf("[FND] 카운트다운 시작: %d\n", start_num);
-    pthread_mutex_unlock(&fnd_state.mutex);
+
+    device_unlock(&fnd_state);
+    fnd_publish(EVENT_COUNTDOWN_TICK, start_num);
     return 0;
 }
 
-// 카운트다운 중지
+// 카운트다운 중지 (진행 중이면 끄기, 스레드는 다음 시작까지 대기)
 int fnd_stop(void) {
-    pthread_mutex_lock(&fnd_state.mutex);
-
-    if (is_counting && countdown_tid != 0) {
-        countdown_stop_requested = 1;
-        pthread_mutex_unlock(&fnd_state.mutex);
-        
-        printf("[FND] 카운트다운 중지 요청\n");
-        
-        // detach된 스레드는 join할 수 없으므로 플래그로만 제어
-        // 스레드가 자연스럽게 종료되도록 대기
-        sleep(1);
-        
-        pthread_mutex_lock(&fnd_state.mutex);
-        is_counting = 0;
-        countdown_stop_requested = 0;
-        countdown_tid = 0;
-        
-        // FND 끄기
+    device_lock(&fnd_state);
+
+    if (is_counting) {
+        countdown_cancel();
         if (fnd_state.is_initialized) {
-            for (int i = 0; i < FND_PINS_COUNT; i++) {
-                digitalWrite(fnd_pins[i], HIGH);
-            }
+            fnd_write(-1);
         }
-        
         printf("[FND] 카운트다운 중지 완료\n");
     }
 
-    pthread_mutex_unlock(&fnd_state.mutex);
+    device_unlock(&fnd_state);
     return 0;
 }
 
+// 규칙 엔진 신호 통지 등록, 등록 즉시 현재 값을 한 번 알림
+void fnd_set_signal_hook(signal_hook_fn hook) {
+    device_lock(&fnd_state);
+    __atomic_store_n(&signal_hook, hook, __ATOMIC_RELEASE);
+    fnd_signal("segment.value", shown_value);
+    fnd_signal("segment.countdown", is_counting ? shown_value : -1);
+    device_unlock(&fnd_state);
+}
+
+// 이벤트 발행 함수 등록 (main 이 이벤트 버스의 event_publish 를 전달)
+void fnd_set_event_publisher(event_publish_fn publish) {
+    __atomic_store_n(&event_publisher, publish, __ATOMIC_RELEASE);
+}
+
 // 표시 시간 설정
 int fnd_set_display_time(int seconds) {
     if (seconds < 1 || seconds > 3600) {
@@ -374,35 +322,36 @@ int fnd_set_display_time(int seconds) {
     return 0;
 }
 
-// FND 상태 확인
+// FND 상태 확인 (잠금 없이 원자적 읽기, 카운트다운 정지 대기 등을 기다리지 않음)
 int fnd_get_status(char* status_buf, int buf_size) {
-    pthread_mutex_lock(&fnd_state.mutex);
-
-    if (!fnd_state.is_initialized) {
+    if (!__atomic_load_n(&fnd_state.is_initialized, __ATOMIC_ACQUIRE)) {
         snprintf(status_buf, buf_size, "FND: NOT_INITIALIZED");
-    } else if (is_counting) {
+    } else if (__atomic_load_n(&is_counting, __ATOMIC_ACQUIRE)) {
         snprintf(status_buf, buf_size, "FND: COUNTING");
     } else {
         snprintf(status_buf, buf_size, "FND: IDLE");
     }
-
-    pthread_mutex_unlock(&fnd_state.mutex);
     return 0;
 }
 
+// 잠금 계측 보고 (make LOCK_STATS=1 빌드가 아니면 -1)
+int fnd_lock_stats(char* buf, int size, int reset) {
+    return device_lock_report(&fnd_state, reset, buf, size);
+}
+
 // FND 자원 해제
 void fnd_cleanup(void) {
-    pthread_mutex_lock(&fnd_state.mutex);
-
+    device_lock(&fnd_state);
     running = 0;
-    countdown_stop_requested = 1;
+    countdown_cancel();
+    int started = countdown_started;
+    if (started) pthread_cond_signal(&countdown_cond);
+    countdown_started = 0;
+    device_unlock(&fnd_state);
 
-    pthread_mutex_unlock(&fnd_state.mutex);
-
-    // detach된 스레드들은 자연스럽게 종료되도록 대기
-    if (countdown_tid != 0 || is_counting) {
-        printf("[FND] 카운트다운 스레드 종료 대기 중...\n");
-        sleep(2); // 스레드가 종료될 시간을 줌
+    if (started) {
+        pthread_join(countdown_tid, NULL);
+        pthread_cond_destroy(&countdown_cond);
     }
 
     if (auto_off_tid != 0) {
@@ -410,28 +359,12 @@ void fnd_cleanup(void) {
         auto_off_tid = 0;
     }
 
-    pthread_mutex_lock(&fnd_state.mutex);
-    
+    device_lock(&fnd_state);
     if (fnd_state.is_initialized) {
         // FND 끄기
-        for (int i = 0; i < FND_PINS_COUNT; i++) {
-            digitalWrite(fnd_pins[i], HIGH);
-        }
-        fnd_state.is_initialized = 0;
+        fnd_write(-1);
+        __atomic_store_n(&fnd_state.is_initialized, 0, __ATOMIC_RELEASE);
         printf("[FND] 자원 해제 완료\n");
     }
-
-    is_counting = 0;
-    countdown_stop_requested = 0;
-    countdown_tid = 0;
-    
-    // 부저 라이브러리 해제
-    if (buzzer_lib) {
-        dlclose(buzzer_lib);
-        buzzer_lib = NULL;
-        buzzer_play_func = NULL;
-        buzzer_stop_func = NULL;
-    }
-    
-    pthread_mutex_unlock(&fnd_state.mutex);
+    device_unlock(&fnd_state);
 }
@@ -0,0 +1,147 @@
+#ifndef LOCK_STATS_H
+#define LOCK_STATS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+// 장치 잠금 계측 (make LOCK_STATS=1 빌드에서 control_device.h 의 device_lock/device_unlock 이 사용)
+// 통계는 그 잠금을 잡은 채로 갱신하므로 따로 동기화하지 않음
+// 대기/보유 시간은 모의 가상 시간과 상관없이 실제 경과 시간 (CLOCK_MONOTONIC)
+
+#define LOCK_HIST_BUCKETS 16        // <1us, <2us, <4us, ... <16384us, 그 이상 (2배 간격)
+
+typedef struct {
+    const char* name;
+    unsigned long acquisitions;
+    unsigned long contended;        // 바로 잡지 못하고 기다린 횟수
+    unsigned long wait_hist[LOCK_HIST_BUCKETS];
+    unsigned long hold_hist[LOCK_HIST_BUCKETS];
+    long long wait_total_ns, wait_max_ns;
+    long long hold_total_ns, hold_max_ns;
+    const char* hold_max_site;      // 가장 오래 잡고 있던 위치 (함수 이름 또는 명령)
+    int hold_max_line;
+    long long held_since_ns;        // 현재 보유자 정보
+    const char* held_site;
+    int held_line;
+} lock_stats_t;
+
+static inline long long lock_stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline int lock_stats_bucket(long long ns) {
+    int bucket = 0;
+    for (long long us = ns / 1000; us > 0 && bucket < LOCK_HIST_BUCKETS - 1; us >>= 1) bucket++;
+    return bucket;
+}
+
+// 잠금을 잡은 직후 호출: 보유 시작 기록
+static inline void lock_stats_resume(lock_stats_t* st, const char* site, int line) {
+    st->held_since_ns = lock_stats_now_ns();
+    st->held_site = site;
+    st->held_line = line;
+}
+
+// 잠금을 놓기 직전 호출 (조건 변수 대기로 잠시 놓는 경우 포함): 보유 시간 기록
+static inline void lock_stats_release(lock_stats_t* st) {
+    long long hold_ns = lock_stats_now_ns() - st->held_since_ns;
+    st->hold_hist[lock_stats_bucket(hold_ns)]++;
+    st->hold_total_ns += hold_ns;
+    if (hold_ns > st->hold_max_ns) {
+        st->hold_max_ns = hold_ns;
+        st->hold_max_site = st->held_site;
+        st->hold_max_line = st->held_line;
+    }
+}
+
+static inline int lock_stats_lock(pthread_mutex_t* mutex, lock_stats_t* st, const char* site, int line) {
+    long long wait_ns = 0;
+    int contended = 0;
+    int ret = pthread_mutex_trylock(mutex);
+
+    if (ret == EBUSY) {
+        long long start = lock_stats_now_ns();
+        contended = 1;
+        ret = pthread_mutex_lock(mutex);
+        wait_ns = lock_stats_now_ns() - start;
+    }
+    if (ret != 0) return ret;
+
+    st->acquisitions++;
+    st->wait_hist[lock_stats_bucket(wait_ns)]++;
+    if (contended) {
+        st->contended++;
+        st->wait_total_ns += wait_ns;
+        if (wait_ns > st->wait_max_ns) st->wait_max_ns = wait_ns;
+    }
+    lock_stats_resume(st, site, line);
+    return 0;
+}
+
+static inline int lock_stats_unlock(pthread_mutex_t* mutex, lock_stats_t* st) {
+    lock_stats_release(st);
+    return pthread_mutex_unlock(mutex);
+}
+
+// 조건 변수 대기 결과를 받아 보유를 다시 시작 (대기 시간은 보유에서 빠짐)
+static inline int lock_stats_rewait(lock_stats_t* st, const char* site, int line, int ret) {
+    lock_stats_resume(st, site, line);
+    return ret;
+}
+
+static inline int lock_stats_hist_format(const char* label, const unsigned long* hist, char* buf, int size) {
+    int len = snprintf(buf, size, "\n  %s", label);
+    for (int i = 0; i < LOCK_HIST_BUCKETS && len < size; i++) {
+        if (!hist[i]) continue;
+        if (i == LOCK_HIST_BUCKETS - 1) {
+            len += snprintf(buf + len, size - len, " >=%d:%lu", 1 << (i - 1), hist[i]);
+        } else {
+            len += snprintf(buf + len, size - len, " <%d:%lu", 1 << i, hist[i]);
+        }
+    }
+    return len;
+}
+
+// 통계 한 덩어리를 buf 에 작성 (잠금을 잠깐 잡고 복사, reset 이면 복사 후 0 으로), 작성 길이 반환
+// 보유 평균은 놓은 횟수 기준 (조건 변수 대기로 놓은 구간은 따로 셈)
+static inline int lock_stats_format(pthread_mutex_t* mutex, lock_stats_t* st, int reset, char* buf, int size) {
+    lock_stats_t snap;
+    unsigned long holds = 0;
+    int len;
+
+    if (size <= 0) return 0;
+    pthread_mutex_lock(mutex);
+    snap = *st;
+    if (reset) {
+        const char* name = st->name;
+        memset(st, 0, sizeof(*st));
+        st->name = name;
+    }
+    pthread_mutex_unlock(mutex);
+
+    for (int i = 0; i < LOCK_HIST_BUCKETS; i++) holds += snap.hold_hist[i];
+    len = snprintf(buf, size, "\n%s: 획득 %lu", snap.name ? snap.name : "?", snap.acquisitions);
+    if (!snap.acquisitions || len >= size) return len;
+
+    len += snprintf(buf + len, size - len, ", 경합 %lu (%.1f%%, 평균 대기 %.1fus, 최대 %.1fus)",
+                    snap.contended, snap.contended * 100.0 / snap.acquisitions,
+                    snap.contended ? snap.wait_total_ns / 1000.0 / snap.contended : 0.0, snap.wait_max_ns / 1000.0);
+    if (len < size) {
+        len += snprintf(buf + len, size - len, ", 보유 평균 %.1fus, 최대 %.1fus @ %s",
+                        holds ? snap.hold_total_ns / 1000.0 / holds : 0.0, snap.hold_max_ns / 1000.0,
+                        snap.hold_max_site ? snap.hold_max_site : "?");
+    }
+    if (len < size && snap.hold_max_line) len += snprintf(buf + len, size - len, ":%d", snap.hold_max_line);
+    if (len < size && snap.contended) {
+        len += lock_stats_hist_format("대기 us", snap.wait_hist, buf + len, size - len);
+    }
+    if (len < size) len += lock_stats_hist_format("보유 us", snap.hold_hist, buf + len, size - len);
+    return len;
+}
+
+#endif // LOCK_STATS_H
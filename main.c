@@ -6,6 +6,7 @@
 #include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <dlfcn.h>
 #include <sys/stat.h>
@@ -15,15 +16,44 @@
 #include <syslog.h>
 #include <sys/resource.h>
 #include <errno.h>
+#include <poll.h>
 #include "control_device.h"
 #include "web_server.h"
+#include "rule_engine.h"
+#include "event_bus.h"
+#include "scheduler.h"
+#include "dev_clock.h"
+#include "device_actor.h"
 
 #define PORT 8080
 #define PID_FILE "/var/run/iot_server.pid"
+#define SCHEDULE_FILE "schedule.log"
 #define MAX_LIBS 4
+#define MAX_CLIENTS 64
+#define PARTIAL_CMD_WAIT_MS 200    // 줄바꿈 없이 보낸 명령을 처리하기 전 기다리는 시간
+#define MAX_SCENES 32
+#define MAX_SCENE_STEPS 16
+#define MAX_SCENE_CMD 128
+
+// 명령이 사용하는 장치 (비트 위치 = 장치 스레드 번호)
+#define DEVICE_COUNT 4
+#define DEV_LED (1 << 0)
+#define DEV_SEGMENT (1 << 1)
+#define DEV_BUZZER (1 << 2)
+#define DEV_CDS (1 << 3)
+#define DEV_ALL (DEV_LED | DEV_SEGMENT | DEV_BUZZER | DEV_CDS)
+
+// 합침 키: 같은 키의 설정 명령이 우편함에 이어서 쌓이면 마지막 것만 장치에 적용
+#define COALESCE_LED_OUTPUT 1        // LED_ON, LED_OFF, LED_BRIGHTNESS (PWM 출력을 통째로 덮어씀)
+#define COALESCE_SEGMENT_VALUE 2     // SEGMENT_DISPLAY
+
+// 명령 등급: 비상 명령은 장치 스레드의 비상 통로로 가서 대기 중인 일반 명령을 앞지르고 취소
+#define CMD_NORMAL 0
+#define CMD_EMERGENCY 1              // ALL_OFF, BUZZER_STOP
 
 // 전역 변수
-static int server_fd = -1, running = 1, daemon_mode = 0;
+static int server_fd = -1, daemon_mode = 0;
+static volatile sig_atomic_t running = 1, stop_signal = 0;   // 시그널 핸들러가 씀
 device_functions_t device_funcs = {0};
 
 // 라이브러리 정보 구조체
@@ -31,42 +61,84 @@ typedef struct {
     const char* name;
     const char* filename;
     void** handle;
-    const char* symbols[12];
-    void** functions[12];
+    const char* symbols[32];
+    void** functions[32];
 } lib_info_t;
 
 // 라이브러리 정보 배열
 static void *led_lib, *segment_lib, *buzzer_lib, *cds_lib;
 static lib_info_t libs[MAX_LIBS] = {
     {"LED", "./libled.so", &led_lib, 
-     {"led_init", "led_on", "led_off", "led_brightness", "led_cleanup", "led_get_status", NULL},
+     {"led_init", "led_on", "led_off", "led_brightness", "led_set_percent", "led_fade",
+      "led_pattern_start", "led_pattern_stop", "led_pattern_stats", "led_lock_stats", "led_cleanup", "led_get_status", NULL},
      {(void**)&device_funcs.led.init, (void**)&device_funcs.led.on, (void**)&device_funcs.led.off, 
-      (void**)&device_funcs.led.brightness, (void**)&device_funcs.led.cleanup, (void**)&device_funcs.led.get_status}},
+      (void**)&device_funcs.led.brightness, (void**)&device_funcs.led.set_percent, (void**)&device_funcs.led.fade,
+      (void**)&device_funcs.led.pattern_start, (void**)&device_funcs.led.pattern_stop, (void**)&device_funcs.led.pattern_stats,
+      (void**)&device_funcs.led.lock_stats, (void**)&device_funcs.led.cleanup, (void**)&device_funcs.led.get_status}},
     
     {"SEGMENT", "./libsegment.so", &segment_lib,
-     {"fnd_init", "fnd_display", "fnd_countdown", "fnd_stop", "fnd_off", "fnd_cleanup", "fnd_get_status", NULL},
+     {"fnd_init", "fnd_display", "fnd_countdown", "fnd_stop", "fnd_off", "fnd_set_signal_hook", "fnd_set_event_publisher", "fnd_lock_stats", "fnd_cleanup", "fnd_get_status", NULL},
      {(void**)&device_funcs.segment.init, (void**)&device_funcs.segment.display, (void**)&device_funcs.segment.countdown,
-      (void**)&device_funcs.segment.stop, (void**)&device_funcs.segment.off, (void**)&device_funcs.segment.cleanup, (void**)&device_funcs.segment.get_status}},
+      (void**)&device_funcs.segment.stop, (void**)&device_funcs.segment.off, (void**)&device_funcs.segment.set_signal_hook,
+      (void**)&device_funcs.segment.set_event_publisher, (void**)&device_funcs.segment.lock_stats, (void**)&device_funcs.segment.cleanup, (void**)&device_funcs.segment.get_status}},
     
     {"BUZZER", "./libbuzzer.so", &buzzer_lib,
-     {"buzzer_init", "buzzer_play", "buzzer_stop", "buzzer_cleanup", "buzzer_get_status", NULL},
-     {(void**)&device_funcs.buzzer.init, (void**)&device_funcs.buzzer.play, (void**)&device_funcs.buzzer.stop,
-      (void**)&device_funcs.buzzer.cleanup, (void**)&device_funcs.buzzer.get_status}},
+     {"buzzer_init", "buzzer_play", "buzzer_submit", "buzzer_play_melody", "buzzer_list_melodies", "buzzer_set_backend",
+      "buzzer_backend_stats", "buzzer_stop", "buzzer_lock_stats", "buzzer_cleanup", "buzzer_get_status", NULL},
+     {(void**)&device_funcs.buzzer.init, (void**)&device_funcs.buzzer.play, (void**)&device_funcs.buzzer.submit,
+      (void**)&device_funcs.buzzer.play_melody,
+      (void**)&device_funcs.buzzer.list_melodies, (void**)&device_funcs.buzzer.set_backend,
+      (void**)&device_funcs.buzzer.backend_stats, (void**)&device_funcs.buzzer.stop,
+      (void**)&device_funcs.buzzer.lock_stats, (void**)&device_funcs.buzzer.cleanup, (void**)&device_funcs.buzzer.get_status}},
     
     {"CDS", "./libcds.so", &cds_lib,
      {"cds_init", "cds_read", "cds_get_value", "cds_is_bright", "cds_auto_led_start", "cds_auto_led_stop", 
-      "auto_led_manual_on", "auto_led_manual_off", "cds_cleanup", "cds_get_status", NULL},
+      "auto_led_manual_on", "auto_led_manual_off", "cds_sampler_start", "cds_sampler_stop", "cds_set_hysteresis",
+      "cds_ring_read", "cds_read_cached", "cds_cache_stats", "cds_set_scan_mode",
+      "cds_sensor_name", "cds_sensor_read", "cds_sensor_list", "cds_history_query", "cds_history_stats", "cds_stats", "cds_set_adaptive",
+      "cds_trace_record", "cds_set_signal_hook", "cds_set_event_publisher", "cds_lock_stats", "cds_cleanup", "cds_get_status", NULL},
      {(void**)&device_funcs.cds.init, (void**)&device_funcs.cds.read, (void**)&device_funcs.cds.get_value,
       (void**)&device_funcs.cds.is_bright, (void**)&device_funcs.cds.auto_led_start, (void**)&device_funcs.cds.auto_led_stop,
-      (void**)&device_funcs.cds.manual_on, (void**)&device_funcs.cds.manual_off, (void**)&device_funcs.cds.cleanup, (void**)&device_funcs.cds.get_status}}
+      (void**)&device_funcs.cds.manual_on, (void**)&device_funcs.cds.manual_off, (void**)&device_funcs.cds.sampler_start,
+      (void**)&device_funcs.cds.sampler_stop, (void**)&device_funcs.cds.set_hysteresis, (void**)&device_funcs.cds.ring_read,
+      (void**)&device_funcs.cds.read_cached, (void**)&device_funcs.cds.cache_stats,
+      (void**)&device_funcs.cds.set_scan_mode, (void**)&device_funcs.cds.sensor_name, (void**)&device_funcs.cds.sensor_read,
+      (void**)&device_funcs.cds.sensor_list, (void**)&device_funcs.cds.history_query, (void**)&device_funcs.cds.history_stats,
+      (void**)&device_funcs.cds.stats, (void**)&device_funcs.cds.set_adaptive, (void**)&device_funcs.cds.trace_record,
+      (void**)&device_funcs.cds.set_signal_hook, (void**)&device_funcs.cds.set_event_publisher,
+      (void**)&device_funcs.cds.lock_stats, (void**)&device_funcs.cds.cleanup, (void**)&device_funcs.cds.get_status}}
 };
 
 // 명령어 처리 구조체
 typedef struct {
     const char* cmd;
     int (*handler)(const char* cmd, char* response, int size);
+    unsigned int devices;    // 처리기를 실행할 장치 스레드 (DEV_*)
+    unsigned int coalesce;   // 합침 키 (COALESCE_*, 0 = 합치지 않음)
+    int priority;            // CMD_NORMAL, CMD_EMERGENCY (처리기가 직접 device_actor_urgent 로 장치를 멈춤)
 } cmd_handler_t;
 
+// 장면: 정의할 때 명령을 처리기에 미리 연결해 두고, 실행 시 필요한 장치 스레드를 모두 멈춘 채 차례로 실행
+typedef struct {
+    int (*handler)(const char* cmd, char* response, int size);
+    char cmd[MAX_SCENE_CMD];
+} scene_step_t;
+
+typedef struct {
+    char name[32];               // 빈 문자열이면 빈 칸
+    int step_count;
+    unsigned int devices;        // 모든 단계 장치의 합
+    unsigned long runs;
+    scene_step_t steps[MAX_SCENE_STEPS];
+} scene_t;
+
+static const char* const device_names[DEVICE_COUNT] = {"LED", "SEGMENT", "BUZZER", "CDS"};
+static scene_t scenes[MAX_SCENES];
+static pthread_mutex_t scene_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const cmd_handler_t* find_handler(const char* command);
+static void stop_clients(void);
+
 // 로그 함수
 void write_log(const char* format, ...) {
     va_list args;
@@ -156,22 +228,11 @@ void unload_device_libraries(void) {
     }
 }
 
-// 시그널 핸들러
+// 시그널 핸들러: 비동기 시그널 안전한 일만 함 (표시 후 대기 소켓을 깨움), 정리는 메인 루프가 끝난 뒤 메인 스레드에서
 void signal_handler(int sig) {
-    write_log("종료 신호 수신 (%d)", sig);
+    stop_signal = sig;
     running = 0;
-    if (server_fd != -1) { shutdown(server_fd, SHUT_RDWR); close(server_fd); }
-    
-    alarm(2);
-    if (device_funcs.led.cleanup) device_funcs.led.cleanup();
-    if (device_funcs.segment.cleanup) device_funcs.segment.cleanup();
-    if (device_funcs.buzzer.cleanup) device_funcs.buzzer.cleanup();
-    if (device_funcs.cds.cleanup) device_funcs.cds.cleanup();
-    alarm(0);
-    
-    unload_device_libraries();
-    if (daemon_mode) { remove_pid_file(); closelog(); }
-    _exit(0);
+    if (server_fd != -1) shutdown(server_fd, SHUT_RDWR);
 }
 
 // 명령어 핸들러 함수들 (기존과 동일)
@@ -194,6 +255,56 @@ int handle_led_brightness(const char* cmd, char* resp, int size) {
     return snprintf(resp, size, "ERROR: LED_BRIGHTNESS <0-2> 형식으로 입력");
 }
 
+int handle_led_percent(const char* cmd, char* resp, int size) {
+    int percent;
+    if (sscanf(cmd, "LED_PERCENT %d", &percent) == 1) {
+        return snprintf(resp, size, device_funcs.led.set_percent && device_funcs.led.set_percent(percent) == 0 ?
+                       "OK: LED 밝기 %d%%로 설정" : "ERROR: LED 밝기 설정 실패", percent);
+    }
+    return snprintf(resp, size, "ERROR: LED_PERCENT <0-100> 형식으로 입력");
+}
+
+int handle_led_fade(const char* cmd, char* resp, int size) {
+    int target, ms;
+    if (sscanf(cmd, "LED_FADE %d %d", &target, &ms) == 2) {
+        return snprintf(resp, size, device_funcs.led.fade && device_funcs.led.fade(target, ms) == 0 ?
+                       "OK: LED %d%%까지 %dms 페이드" : "ERROR: LED 페이드 실패", target, ms);
+    }
+    return snprintf(resp, size, "ERROR: LED_FADE <0-100> <ms> 형식으로 입력");
+}
+
+// LED_PATTERN [핀] <blink|breathe|heartbeat|사용자 패턴> (핀 생략 시 PWM LED)
+int handle_led_pattern(const char* cmd, char* resp, int size) {
+    const char* desc = cmd + strlen("LED_PATTERN");
+    int pin = 18, consumed = 0;
+
+    if (sscanf(desc, " %d%n", &pin, &consumed) == 1) {
+        desc += consumed;
+    }
+    while (*desc == ' ') desc++;
+
+    if (*desc == '\0') {
+        return snprintf(resp, size, "ERROR: LED_PATTERN [핀] <blink|breathe|heartbeat|패턴> 형식으로 입력");
+    }
+    return snprintf(resp, size, device_funcs.led.pattern_start && device_funcs.led.pattern_start(pin, desc) == 0 ?
+                   "OK: GPIO %d 패턴 시작" : "ERROR: GPIO %d 패턴 시작 실패", pin);
+}
+
+int handle_led_pattern_stop(const char* cmd, char* resp, int size) {
+    int pin = -1;
+    sscanf(cmd, "LED_PATTERN_STOP %d", &pin);
+    return snprintf(resp, size, device_funcs.led.pattern_stop && device_funcs.led.pattern_stop(pin) == 0 ?
+                   "OK: 패턴 중지" : "ERROR: 패턴 중지 실패");
+}
+
+int handle_led_pattern_stats(const char* cmd, char* resp, int size) {
+    char status_buf[256];
+    if (device_funcs.led.pattern_stats && device_funcs.led.pattern_stats(status_buf, sizeof(status_buf)) == 0) {
+        return snprintf(resp, size, "OK: %s", status_buf);
+    }
+    return snprintf(resp, size, "ERROR: 패턴 통계 확인 실패");
+}
+
 int handle_segment_display(const char* cmd, char* resp, int size) {
     int num;
     if (sscanf(cmd, "SEGMENT_DISPLAY %d", &num) == 1) {
@@ -212,21 +323,115 @@ int handle_segment_countdown(const char* cmd, char* resp, int size) {
     return snprintf(resp, size, "ERROR: SEGMENT_COUNTDOWN <1-9> 형식으로 입력");
 }
 
+// BUZZER_PLAY [멜로디 이름 | 인라인 RTTTL]
+int handle_buzzer_play(const char* cmd, char* resp, int size) {
+    const char* spec = cmd + strlen("BUZZER_PLAY");
+    while (*spec == ' ') spec++;
+
+    if (*spec == '\0') {
+        return snprintf(resp, size, device_funcs.buzzer.play && device_funcs.buzzer.play() == 0 ?
+                       "OK: 부저 재생 시작" : "ERROR: 부저 재생 실패");
+    }
+    return snprintf(resp, size, device_funcs.buzzer.play_melody && device_funcs.buzzer.play_melody(spec) == 0 ?
+                   "OK: 부저 재생 시작" : "ERROR: 부저 재생 실패 (멜로디 이름 또는 RTTTL 확인)");
+}
+
+// BUZZER_QUEUE <alarm|notify|click> <멜로디 이름 | 인라인 RTTTL>
+int handle_buzzer_queue(const char* cmd, char* resp, int size) {
+    static const char* prio_names[] = {"click", "notify", "alarm"};
+    char prio[16];
+    int consumed = 0;
+
+    if (sscanf(cmd, "BUZZER_QUEUE %15s %n", prio, &consumed) == 1 && consumed > 0 && cmd[consumed]) {
+        for (int p = BUZZER_PRIO_CLICK; p <= BUZZER_PRIO_ALARM; p++) {
+            if (strcmp(prio, prio_names[p]) == 0) {
+                return snprintf(resp, size, device_funcs.buzzer.submit && device_funcs.buzzer.submit(cmd + consumed, p) == 0 ?
+                               "OK: 부저 %s 요청 등록" : "ERROR: 부저 요청 실패", prio);
+            }
+        }
+    }
+    return snprintf(resp, size, "ERROR: BUZZER_QUEUE <alarm|notify|click> <이름|RTTTL> 형식으로 입력");
+}
+
+int handle_buzzer_status(const char* cmd, char* resp, int size) {
+    char status_buf[256];
+    if (device_funcs.buzzer.get_status && device_funcs.buzzer.get_status(status_buf, sizeof(status_buf)) == 0) {
+        return snprintf(resp, size, "OK: %s", status_buf);
+    }
+    return snprintf(resp, size, "ERROR: 부저 상태 확인 실패");
+}
+
+int handle_buzzer_list(const char* cmd, char* resp, int size) {
+    char list_buf[512];
+    if (device_funcs.buzzer.list_melodies && device_funcs.buzzer.list_melodies(list_buf, sizeof(list_buf)) == 0) {
+        return snprintf(resp, size, "OK: %s", list_buf);
+    }
+    return snprintf(resp, size, "ERROR: 멜로디 목록 확인 실패");
+}
+
+// BUZZER_BACKEND [pwm|softtone]: 톤 백엔드 변경, 인자 없으면 백엔드와 CPU 사용률 조회
+int handle_buzzer_backend(const char* cmd, char* resp, int size) {
+    char name[16];
+    char stats_buf[256];
+
+    if (sscanf(cmd, "BUZZER_BACKEND %15s", name) == 1 &&
+        (!device_funcs.buzzer.set_backend || device_funcs.buzzer.set_backend(name) != 0)) {
+        return snprintf(resp, size, "ERROR: 백엔드 %s 사용 불가 (재생 중이거나 지원되지 않음)", name);
+    }
+    if (device_funcs.buzzer.backend_stats && device_funcs.buzzer.backend_stats(stats_buf, sizeof(stats_buf)) == 0) {
+        return snprintf(resp, size, "OK: %s", stats_buf);
+    }
+    return snprintf(resp, size, "ERROR: 부저 백엔드 확인 실패");
+}
+
+// 장치 하나 비상 정지 (그 장치 스레드에서 실행), 진행 중인 시간 작업(페이드, 패턴, 카운트다운, 멜로디, 자동 LED)도 멈춤
+static int device_stop(int device) {
+    unsigned int bit = 1u << device;
+    int result = 0;
+
+    if (bit == DEV_LED) {
+        if (device_funcs.led.pattern_stop) device_funcs.led.pattern_stop(-1);
+        if (device_funcs.led.off && device_funcs.led.off() < 0) result = -1;
+    } else if (bit == DEV_SEGMENT) {
+        if (device_funcs.segment.off) device_funcs.segment.off();
+    } else if (bit == DEV_BUZZER) {
+        if (!device_funcs.buzzer.stop || device_funcs.buzzer.stop() < 0) result = -1;
+    } else if (bit == DEV_CDS) {
+        if (device_funcs.cds.auto_led_stop) device_funcs.cds.auto_led_stop();
+        if (device_funcs.cds.manual_off && device_funcs.cds.manual_off() < 0) result = -1;
+    }
+    return result;
+}
+
 int handle_all_off(const char* cmd, char* resp, int size) {
-    if (device_funcs.led.off) device_funcs.led.off();
-    if (device_funcs.segment.off) device_funcs.segment.off();
-    if (device_funcs.buzzer.stop) device_funcs.buzzer.stop();
-    if (device_funcs.cds.auto_led_stop) device_funcs.cds.auto_led_stop();
-    if (device_funcs.cds.manual_off) device_funcs.cds.manual_off();
-    return snprintf(resp, size, "OK: 모든 디바이스 꺼짐");
+    unsigned int failed = device_actor_urgent(DEV_ALL, device_stop);
+    if (!failed) return snprintf(resp, size, "OK: 모든 디바이스 꺼짐");
+
+    int len = snprintf(resp, size, "ERROR: 일부 디바이스 끄기 실패:");
+    for (int d = 0; d < DEVICE_COUNT && len < size; d++) {
+        if (failed & (1u << d)) len += snprintf(resp + len, size - len, " %s", device_names[d]);
+    }
+    return len;
 }
 
 int handle_help(const char* cmd, char* resp, int size) {
-    return snprintf(resp, size, "LED: LED_ON, LED_OFF, LED_BRIGHTNESS [0-2]\n"
+    return snprintf(resp, size, "LED: LED_ON, LED_OFF, LED_BRIGHTNESS [0-2], LED_PERCENT [0-100], LED_FADE [0-100] [ms]\n"
+                               "     LED_PATTERN [핀] <blink|breathe|heartbeat|패턴>, LED_PATTERN_STOP [핀], LED_PATTERN_STATS\n"
                                "SEGMENT: SEGMENT_DISPLAY [0-9], SEGMENT_COUNTDOWN [1-9], SEGMENT_STOP, SEGMENT_OFF\n"
-                               "BUZZER: BUZZER_PLAY, BUZZER_STOP\n"
-                               "CDS: CDS_READ, CDS_AUTO_START, CDS_AUTO_STOP, CDS_GET_STATUS\n"
-                               "기타: ALL_OFF, HELP, QUIT");
+                               "BUZZER: BUZZER_PLAY [이름|RTTTL], BUZZER_QUEUE <alarm|notify|click> <이름|RTTTL>, BUZZER_LIST,\n"
+                               "        BUZZER_STATUS, BUZZER_STOP, BUZZER_BACKEND [pwm|softtone]\n"
+                               "CDS: CDS_READ [maxage=200ms], CDS_CACHE_STATS, CDS_AUTO_START, CDS_AUTO_STOP, CDS_GET_STATUS,\n"
+                               "     CDS_SAMPLER_START [hz], CDS_SAMPLER_STOP, CDS_ADAPTIVE <min> <max>|off, CDS_TRACE_RECORD <초> [hz],\n"
+                               "     CDS_HYSTERESIS <임계값> <폭>, CDS_SAMPLES [n],\n"
+                               "     CDS_SCAN_MODE <on|off>, CDS_SENSORS, CDS_SENSOR <이름>, CDS_SENSOR_NAME <채널> <이름>,\n"
+                               "     CDS_HISTORY <from> <to> [raw|1s|1m|1h], CDS_HISTORY_STATS, CDS_STATS [1m|15m|1h]\n"
+                               "RULE: RULE_ADD when <신호> <연산자> <값> [and ...] [for <n>s] then <명령>, RULE_DEL <번호>,\n"
+                               "      RULE_LIST [번호], RULE_SIGNALS (신호: cds.value, cds.bright, segment.value, segment.countdown)\n"
+                               "EVENT: EVENT_STATS, EVENT_PUBLISH <countdown.tick|countdown.finished|cds.dark|cds.bright|user> [값]\n"
+                               "SCHED: AT <HH:MM[:SS]|+<n>s|m|h|d|epoch> [daily] <명령>, EVERY <n>ms|s|m|h|d <명령>,\n"
+                               "       SCHED_LIST [번호], SCHED_CANCEL <번호>\n"
+                               "SCENE: SCENE_DEFINE <이름> {명령; 명령; ...}, SCENE_RUN <이름>, SCENE_LIST, SCENE_DELETE <이름>\n"
+                               "기타: ALL_OFF, LOCKSTATS [RESET], ACTOR_STATS, HELP, QUIT");
 }
 
 int handle_quit(const char* cmd, char* resp, int size) {
@@ -245,16 +450,216 @@ int handle_cds_auto_stop(const char* cmd, char* resp, int size) {
                    "OK: 조도 센서 자동 LED 제어 중지" : "ERROR: 조도 센서 자동 제어 중지 실패");
 }
 
+// "maxage=<n>ms|<n>s" 옵션 해석 (없으면 기본 100ms), 형식 오류는 -1
+static int parse_maxage(const char* cmd) {
+    int maxage_ms = 100;
+    const char* opt = strstr(cmd, "maxage=");
+    if (opt) {
+        char unit[4] = "";
+        if (sscanf(opt, "maxage=%d%3s", &maxage_ms, unit) < 1 || maxage_ms < 0) {
+            return -1;
+        }
+        if (strcmp(unit, "s") == 0) maxage_ms *= 1000;
+        else if (unit[0] && strcmp(unit, "ms") != 0) return -1;
+    }
+    return maxage_ms;
+}
+
+// CDS_READ [maxage=<n>ms|<n>s]: 지정한 시간 이내의 측정값은 캐시에서 응답 (기본 100ms, maxage=0 은 새로 측정)
 int handle_cds_read(const char* cmd, char* resp, int size) {
-    if (device_funcs.cds.read && device_funcs.cds.read() == 0) {
-        int value = device_funcs.cds.get_value ? device_funcs.cds.get_value() : -1;
-        int bright = device_funcs.cds.is_bright ? device_funcs.cds.is_bright() : -1;
+    int maxage_ms = parse_maxage(cmd);
+    if (maxage_ms < 0) {
+        return snprintf(resp, size, "ERROR: CDS_READ maxage=<n>ms 형식으로 입력");
+    }
+
+    int value, bright;
+    if (device_funcs.cds.read_cached && device_funcs.cds.read_cached(maxage_ms, &value, &bright) == 0) {
         return snprintf(resp, size, "OK: 조도값 %d (%s)", value, bright ? "밝음" : "어둠");
     } else {
         return snprintf(resp, size, "ERROR: 조도 센서 읽기 실패");
     }
 }
 
+// CDS_SCAN_MODE <on|off>: 4채널 자동 증가 블록 읽기 모드 전환
+int handle_cds_scan_mode(const char* cmd, char* resp, int size) {
+    char mode[8];
+    if (sscanf(cmd, "CDS_SCAN_MODE %7s", mode) == 1 && (strcmp(mode, "on") == 0 || strcmp(mode, "off") == 0)) {
+        int enable = strcmp(mode, "on") == 0;
+        if (device_funcs.cds.set_scan_mode && device_funcs.cds.set_scan_mode(enable) == 0) {
+            return snprintf(resp, size, "OK: ADC %s 모드", enable ? "4채널 스캔" : "단일 채널");
+        }
+        return snprintf(resp, size, "ERROR: ADC 모드 변경 실패");
+    }
+    return snprintf(resp, size, "ERROR: CDS_SCAN_MODE <on|off> 형식으로 입력");
+}
+
+// CDS_SENSOR_NAME <채널 0-3> <이름>
+int handle_cds_sensor_name(const char* cmd, char* resp, int size) {
+    int channel;
+    char name[32];
+    if (sscanf(cmd, "CDS_SENSOR_NAME %d %31s", &channel, name) == 2) {
+        if (device_funcs.cds.sensor_name && device_funcs.cds.sensor_name(channel, name) == 0) {
+            return snprintf(resp, size, "OK: 채널 %d 이름 %s", channel, name);
+        }
+        return snprintf(resp, size, "ERROR: 이름 지정 실패 (채널 0-3, 영문/숫자/_ 15자 이내, 중복 불가)");
+    }
+    return snprintf(resp, size, "ERROR: CDS_SENSOR_NAME <채널> <이름> 형식으로 입력");
+}
+
+// CDS_SENSORS [maxage=..]: 모든 채널 값
+int handle_cds_sensors(const char* cmd, char* resp, int size) {
+    char list_buf[256];
+    int maxage_ms = parse_maxage(cmd);
+    if (maxage_ms < 0) {
+        return snprintf(resp, size, "ERROR: CDS_SENSORS maxage=<n>ms 형식으로 입력");
+    }
+    if (device_funcs.cds.sensor_list && device_funcs.cds.sensor_list(maxage_ms, list_buf, sizeof(list_buf)) >= 0) {
+        return snprintf(resp, size, "OK: %s", list_buf);
+    }
+    return snprintf(resp, size, "ERROR: ADC 읽기 실패");
+}
+
+// CDS_SENSOR <이름> [maxage=..]: 이름으로 지정한 채널 값
+int handle_cds_sensor(const char* cmd, char* resp, int size) {
+    char name[32];
+    int value;
+    int maxage_ms = parse_maxage(cmd);
+    if (sscanf(cmd, "CDS_SENSOR %31s", name) != 1 || maxage_ms < 0) {
+        return snprintf(resp, size, "ERROR: CDS_SENSOR <이름> [maxage=<n>ms] 형식으로 입력");
+    }
+    if (device_funcs.cds.sensor_read && device_funcs.cds.sensor_read(name, maxage_ms, &value) == 0) {
+        return snprintf(resp, size, "OK: %s %d", name, value);
+    }
+    return snprintf(resp, size, "ERROR: %s 읽기 실패 (이름 확인, 0번 외 채널은 CDS_SCAN_MODE on 필요)", name);
+}
+
+// 이력 단계 이름 (CDS_TIER_* 순서)
+static const char* history_tiers[CDS_TIER_COUNT] = {"raw", "1s", "1m", "1h"};
+
+const char* history_tier_name(int tier) {
+    return tier >= 0 && tier < CDS_TIER_COUNT ? history_tiers[tier] : "auto";
+}
+
+// 시각 지정 해석: now, -<n>[s|m|h|d] (현재 기준), 또는 epoch 초
+static int parse_time_spec(const char* spec, long long now_ms, long long* out_ms) {
+    long long n;
+    char unit = 's', extra;
+
+    if (strcmp(spec, "now") == 0) {
+        *out_ms = now_ms;
+        return 0;
+    }
+    if (spec[0] == '-') {
+        int fields = sscanf(spec + 1, "%lld%c%c", &n, &unit, &extra);
+        if (fields < 1 || fields > 2 || n < 0) return -1;
+        long long scale = unit == 's' ? 1000LL : unit == 'm' ? 60000LL : unit == 'h' ? 3600000LL : unit == 'd' ? 86400000LL : 0;
+        if (scale == 0) return -1;
+        *out_ms = now_ms - n * scale;
+        return 0;
+    }
+    if (sscanf(spec, "%lld%c", &n, &extra) == 1 && n >= 0) {
+        *out_ms = n * 1000LL;
+        return 0;
+    }
+    return -1;
+}
+
+// 이력 조회 (CDS_HISTORY 명령과 HTTP /api/history 공용), 사용한 단계는 *tier, 전달한 레코드 수 반환
+int history_query(const char* from, const char* to, const char* res, int* tier, sensor_visit_fn visit, void* ctx) {
+    struct timespec now;
+    long long from_ms, to_ms;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long now_ms = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+    if (!device_funcs.cds.history_query || parse_time_spec(from, now_ms, &from_ms) < 0 ||
+        parse_time_spec(to, now_ms, &to_ms) < 0 || from_ms > to_ms) {
+        return -1;
+    }
+
+    *tier = CDS_TIER_AUTO;
+    for (int t = 0; res && t < CDS_TIER_COUNT; t++) {
+        if (strcmp(res, history_tiers[t]) == 0) *tier = t;
+    }
+    if (res && *tier == CDS_TIER_AUTO && strcmp(res, "auto") != 0) {
+        return -1;
+    }
+    return device_funcs.cds.history_query(from_ms, to_ms, tier, visit, ctx);
+}
+
+// CDS_HISTORY 응답 작성용 상태
+typedef struct {
+    char* buf;
+    int size;
+    int len;
+    int shown;
+} history_text_t;
+
+static int history_text_visit(const sensor_record_t* rec, void* ctx) {
+    history_text_t* out = ctx;
+    time_t ts = rec->ts_s;
+    struct tm tm;
+    char line[64];
+
+    localtime_r(&ts, &tm);
+    int n = snprintf(line, sizeof(line), "\n%02d-%02d %02d:%02d:%02d.%03d %d (%d-%d)", tm.tm_mon + 1, tm.tm_mday,
+                     tm.tm_hour, tm.tm_min, tm.tm_sec, rec->ts_ms, rec->avg, rec->min, rec->max);
+    if (out->len + n + 32 >= out->size) {
+        return 0;  // 공간이 없으면 개수만 계속 셈
+    }
+    memcpy(out->buf + out->len, line, n + 1);
+    out->len += n;
+    out->shown++;
+    return 0;
+}
+
+// CDS_HISTORY <from> <to> [raw|1s|1m|1h|auto]: 이력 구간 조회 (예: CDS_HISTORY -1h now 1m)
+int handle_cds_history(const char* cmd, char* resp, int size) {
+    char from[32], to[32], res[8] = "auto";
+    char points[MAX_RESPONSE_SIZE];
+    history_text_t out = {points, sizeof(points) - 128, 0, 0};
+    int tier;
+
+    points[0] = '\0';
+    if (sscanf(cmd, "CDS_HISTORY %31s %31s %7s", from, to, res) < 2) {
+        return snprintf(resp, size, "ERROR: CDS_HISTORY <from> <to> [raw|1s|1m|1h|auto] 형식으로 입력 (예: -1h now 1m)");
+    }
+
+    int count = history_query(from, to, res, &tier, history_text_visit, &out);
+    if (count < 0) {
+        return snprintf(resp, size, "ERROR: 이력 조회 실패 (시각: now, -30m, -2h, -7d, epoch 초)");
+    }
+    return snprintf(resp, size, "OK: %s 단계 %d개%s (시각 평균 (최소-최대))%s", history_tier_name(tier), count,
+                    out.shown < count ? ", 앞부분만 표시" : "", points);
+}
+
+int handle_cds_history_stats(const char* cmd, char* resp, int size) {
+    char stats_buf[256];
+    if (device_funcs.cds.history_stats && device_funcs.cds.history_stats(stats_buf, sizeof(stats_buf)) >= 0) {
+        return snprintf(resp, size, "OK: %s", stats_buf);
+    }
+    return snprintf(resp, size, "ERROR: 이력 저장소 상태 확인 실패");
+}
+
+// CDS_STATS [1m|15m|1h]: 슬라이딩 윈도우 통계 (최소/최대/평균/분산/백분위)
+int handle_cds_stats(const char* cmd, char* resp, int size) {
+    char window[8];
+    char stats_buf[1024];
+    int has_window = sscanf(cmd, "CDS_STATS %7s", window) == 1;
+
+    if (device_funcs.cds.stats && device_funcs.cds.stats(has_window ? window : NULL, stats_buf, sizeof(stats_buf)) >= 0) {
+        return snprintf(resp, size, "OK: %s", stats_buf);
+    }
+    return snprintf(resp, size, "ERROR: 조도 통계 조회 실패 (윈도우: 1m, 15m, 1h)");
+}
+
+int handle_cds_cache_stats(const char* cmd, char* resp, int size) {
+    char stats_buf[256];
+    if (device_funcs.cds.cache_stats && device_funcs.cds.cache_stats(stats_buf, sizeof(stats_buf)) >= 0) {
+        return snprintf(resp, size, "OK: %s", stats_buf);
+    }
+    return snprintf(resp, size, "ERROR: 조도 캐시 통계 확인 실패");
+}
+
 int handle_cds_get_status(const char* cmd, char* resp, int size) {
     char status_buf[256];
     if (device_funcs.cds.get_status && device_funcs.cds.get_status(status_buf, sizeof(status_buf)) == 0) {
@@ -264,54 +669,554 @@ int handle_cds_get_status(const char* cmd, char* resp, int size) {
     }
 }
 
-// 명령어 핸들러 테이블
+// CDS_SAMPLER_START [hz]: 샘플러 시작 또는 주기 변경
+int handle_cds_sampler_start(const char* cmd, char* resp, int size) {
+    int hz = 20;
+    sscanf(cmd, "CDS_SAMPLER_START %d", &hz);
+    return snprintf(resp, size, device_funcs.cds.sampler_start && device_funcs.cds.sampler_start(hz) == 0 ?
+                   "OK: 조도 샘플러 %dHz 동작" : "ERROR: 조도 샘플러 시작 실패 (1-500Hz)", hz);
+}
+
+int handle_cds_sampler_stop(const char* cmd, char* resp, int size) {
+    return snprintf(resp, size, device_funcs.cds.sampler_stop && device_funcs.cds.sampler_stop() == 0 ?
+                   "OK: 조도 샘플러 중지" : "ERROR: 조도 샘플러 중지 실패 (자동 LED 제어 중)");
+}
+
+// CDS_ADAPTIVE <min_hz> <max_hz> | off: 적응형 샘플링 범위 설정/해제
+int handle_cds_adaptive(const char* cmd, char* resp, int size) {
+    int min_hz, max_hz;
+    if (strcmp(cmd, "CDS_ADAPTIVE off") == 0) {
+        return snprintf(resp, size, device_funcs.cds.set_adaptive && device_funcs.cds.set_adaptive(0, 0) == 0 ?
+                       "OK: 적응형 샘플링 해제 (고정 주기)" : "ERROR: 적응형 샘플링 해제 실패");
+    }
+    if (sscanf(cmd, "CDS_ADAPTIVE %d %d", &min_hz, &max_hz) == 2) {
+        return snprintf(resp, size, device_funcs.cds.set_adaptive && device_funcs.cds.set_adaptive(min_hz, max_hz) == 0 ?
+                       "OK: 적응형 샘플링 %d-%dHz" : "ERROR: 적응형 샘플링 설정 실패 (1 <= min <= max <= 500)", min_hz, max_hz);
+    }
+    return snprintf(resp, size, "ERROR: CDS_ADAPTIVE <min_hz> <max_hz> 또는 CDS_ADAPTIVE off 형식으로 입력");
+}
+
+// CDS_TRACE_RECORD <초> [hz]: 조도 변화를 고정 주기로 cds_trace.txt 에 기록 (cds_replay 입력)
+int handle_cds_trace_record(const char* cmd, char* resp, int size) {
+    int seconds, hz = 100;
+    if (sscanf(cmd, "CDS_TRACE_RECORD %d %d", &seconds, &hz) < 1) {
+        return snprintf(resp, size, "ERROR: CDS_TRACE_RECORD <초> [hz] 형식으로 입력");
+    }
+    return snprintf(resp, size, device_funcs.cds.trace_record && device_funcs.cds.trace_record(seconds, hz) == 0 ?
+                   "OK: 조도 변화 기록 시작 (%d초, %dHz, cds_trace.txt)" : "ERROR: 기록 시작 실패 (1-3600초, 1-500Hz, 이미 기록 중인지 확인)",
+                   seconds, hz);
+}
+
+int handle_cds_hysteresis(const char* cmd, char* resp, int size) {
+    int threshold, band;
+    if (sscanf(cmd, "CDS_HYSTERESIS %d %d", &threshold, &band) == 2) {
+        return snprintf(resp, size, device_funcs.cds.set_hysteresis && device_funcs.cds.set_hysteresis(threshold, band) == 0 ?
+                       "OK: 히스테리시스 %d±%d" : "ERROR: 히스테리시스 설정 실패", threshold, band);
+    }
+    return snprintf(resp, size, "ERROR: CDS_HYSTERESIS <임계값 0-255> <폭> 형식으로 입력");
+}
+
+// CDS_SAMPLES [n]: 최근 샘플의 원시값/필터값
+int handle_cds_samples(const char* cmd, char* resp, int size) {
+    cds_sample_t samples[32];
+    int n = 10;
+    sscanf(cmd, "CDS_SAMPLES %d", &n);
+    if (n < 1) n = 1;
+    if (n > 32) n = 32;
+
+    int count = device_funcs.cds.ring_read ? device_funcs.cds.ring_read(samples, n) : 0;
+    int len = snprintf(resp, size, "OK: 샘플 %d개 (원시/필터)", count);
+    for (int i = 0; i < count && len < size; i++) {
+        len += snprintf(resp + len, size - len, " %d/%d", samples[i].raw, samples[i].filtered);
+    }
+    return len;
+}
+
+// RULE_ADD when <신호> <연산자> <값> [and ...] [for <n>s] then <명령>
+int handle_rule_add(const char* cmd, char* resp, int size) {
+    char err[160];
+    int id = rule_add(cmd + strlen("RULE_ADD"), err, sizeof(err));
+    if (id < 0) {
+        return snprintf(resp, size, "ERROR: 규칙 추가 실패 - %s", err);
+    }
+    return snprintf(resp, size, "OK: 규칙 #%d 추가", id);
+}
+
+int handle_rule_del(const char* cmd, char* resp, int size) {
+    int id;
+    if (sscanf(cmd, "RULE_DEL %d", &id) == 1) {
+        return snprintf(resp, size, rule_delete(id) == 0 ? "OK: 규칙 #%d 삭제" : "ERROR: 규칙 #%d 없음", id);
+    }
+    return snprintf(resp, size, "ERROR: RULE_DEL <번호> 형식으로 입력");
+}
+
+// RULE_LIST [번호]: 규칙 목록 (번호부터, 응답에 다 들어가지 않으면 다음 번호 안내)
+int handle_rule_list(const char* cmd, char* resp, int size) {
+    char list_buf[MAX_RESPONSE_SIZE - 8];
+    int from_id = 0;
+    if (strcmp(cmd, "RULE_LIST") != 0 && (sscanf(cmd, "RULE_LIST %d", &from_id) != 1 || from_id < 0)) {
+        return snprintf(resp, size, "ERROR: RULE_LIST [번호] 형식으로 입력");
+    }
+    rule_list(from_id, list_buf, sizeof(list_buf));
+    return snprintf(resp, size, "OK: %s", list_buf);
+}
+
+int handle_rule_signals(const char* cmd, char* resp, int size) {
+    char list_buf[MAX_RESPONSE_SIZE - 8];
+    rule_signals(list_buf, sizeof(list_buf));
+    return snprintf(resp, size, "OK: %s", list_buf);
+}
+
+// EVENT_PUBLISH <이벤트> [값]: 이벤트 직접 발행 (예: EVENT_PUBLISH countdown.finished)
+int handle_event_publish(const char* cmd, char* resp, int size) {
+    char name[32];
+    int value = 0;
+    if (sscanf(cmd, "EVENT_PUBLISH %31s %d", name, &value) < 1) {
+        return snprintf(resp, size, "ERROR: EVENT_PUBLISH <이벤트> [값] 형식으로 입력");
+    }
+    int type = event_type_from_name(name);
+    if (type < 0) {
+        return snprintf(resp, size, "ERROR: 알 수 없는 이벤트 %s (countdown.tick, countdown.finished, cds.dark, cds.bright, user)", name);
+    }
+    return snprintf(resp, size, "OK: %s 발행, 구독자 %d", name, event_publish(type, value));
+}
+
+int handle_event_stats(const char* cmd, char* resp, int size) {
+    char stats_buf[MAX_RESPONSE_SIZE - 8];
+    event_bus_stats(stats_buf, sizeof(stats_buf));
+    return snprintf(resp, size, "OK: %s", stats_buf);
+}
+
+// LOCKSTATS [RESET]: 각 라이브러리 상태 잠금의 계측 결과 (make LOCK_STATS=1 빌드)
+// 명령 처리 경로는 장치 스레드가 차례로 실행하므로 잠금이 없음 (대기는 ACTOR_STATS 로 확인)
+int handle_lockstats(const char* cmd, char* resp, int size) {
+    int (*lib_reports[])(char* buf, int size, int reset) = {
+        device_funcs.led.lock_stats, device_funcs.segment.lock_stats,
+        device_funcs.buzzer.lock_stats, device_funcs.cds.lock_stats
+    };
+    int reset = strstr(cmd, "RESET") != NULL;
+    int len = snprintf(resp, size, "OK: 잠금 통계%s", reset ? " (조회 후 초기화)" : "");
+
+    for (int i = 0; i < DEVICE_COUNT && len < size; i++) {
+        if (!lib_reports[i]) continue;
+        int n = lib_reports[i](resp + len, size - len, reset);
+        if (n < 0) return snprintf(resp, size, "ERROR: 잠금 계측이 꺼진 빌드 (make LOCK_STATS=1 로 빌드)");
+        len += n;
+    }
+    return len;
+}
+
+// ACTOR_STATS: 장치 스레드별 처리 수, 대기 중인 요청, 우편함 대기 지연 (조회 시 지연 통계 초기화)
+int handle_actor_stats(const char* cmd, char* resp, int size) {
+    char stats_buf[MAX_RESPONSE_SIZE - 8];
+    device_actor_stats(stats_buf, sizeof(stats_buf));
+    return snprintf(resp, size, "OK: %s", stats_buf);
+}
+
+// AT <시각> [daily] <명령>: 예 AT 18:30 daily LED_BRIGHTNESS 2, AT +10m BUZZER_PLAY
+int handle_at(const char* cmd, char* resp, int size) {
+    char when[32], err[160];
+    int consumed = 0, daily = 0;
+
+    if (sscanf(cmd, "AT %31s %n", when, &consumed) != 1 || consumed == 0) {
+        return snprintf(resp, size, "ERROR: AT <시각> [daily] <명령> 형식으로 입력");
+    }
+    const char* rest = cmd + consumed;
+    if (strncmp(rest, "daily ", 6) == 0) {
+        daily = 1;
+        rest += 6;
+        while (*rest == ' ') rest++;
+    }
+    int id = scheduler_at(when, daily, rest, err, sizeof(err));
+    if (id < 0) {
+        return snprintf(resp, size, "ERROR: 예약 실패 - %s", err);
+    }
+    return snprintf(resp, size, "OK: 예약 #%d 추가", id);
+}
+
+// EVERY <간격> <명령>: 예 EVERY 10m CDS_READ
+int handle_every(const char* cmd, char* resp, int size) {
+    char interval[16], err[160];
+    int consumed = 0;
+
+    if (sscanf(cmd, "EVERY %15s %n", interval, &consumed) != 1 || consumed == 0) {
+        return snprintf(resp, size, "ERROR: EVERY <간격> <명령> 형식으로 입력");
+    }
+    int id = scheduler_every(interval, cmd + consumed, err, sizeof(err));
+    if (id < 0) {
+        return snprintf(resp, size, "ERROR: 예약 실패 - %s", err);
+    }
+    return snprintf(resp, size, "OK: 예약 #%d 추가", id);
+}
+
+int handle_sched_cancel(const char* cmd, char* resp, int size) {
+    int id;
+    if (sscanf(cmd, "SCHED_CANCEL %d", &id) == 1) {
+        return snprintf(resp, size, scheduler_cancel(id) == 0 ? "OK: 예약 #%d 취소" : "ERROR: 예약 #%d 없음", id);
+    }
+    return snprintf(resp, size, "ERROR: SCHED_CANCEL <번호> 형식으로 입력");
+}
+
+// SCHED_LIST [번호]: 예약 목록 (번호부터, 응답에 다 들어가지 않으면 다음 번호 안내)
+int handle_sched_list(const char* cmd, char* resp, int size) {
+    char list_buf[MAX_RESPONSE_SIZE - 8];
+    int from_id = 0;
+    if (strcmp(cmd, "SCHED_LIST") != 0 && (sscanf(cmd, "SCHED_LIST %d", &from_id) != 1 || from_id < 0)) {
+        return snprintf(resp, size, "ERROR: SCHED_LIST [번호] 형식으로 입력");
+    }
+    scheduler_list(from_id, list_buf, sizeof(list_buf));
+    return snprintf(resp, size, "OK: %s", list_buf);
+}
+
+int handle_segment_stop(const char* cmd, char* resp, int size) {
+    return snprintf(resp, size, device_funcs.segment.stop && device_funcs.segment.stop() == 0 ?
+                   "OK: SEGMENT 카운트다운 중지" : "ERROR: SEGMENT 중지 실패");
+}
+
+int handle_segment_off(const char* cmd, char* resp, int size) {
+    if (device_funcs.segment.off) device_funcs.segment.off();
+    return snprintf(resp, size, "OK: SEGMENT 꺼짐");
+}
+
+int handle_buzzer_stop(const char* cmd, char* resp, int size) {
+    return snprintf(resp, size, device_actor_urgent(DEV_BUZZER, device_stop) == 0 ?
+                   "OK: 부저 중지" : "ERROR: 부저 중지 실패");
+}
+
+// "{명령; 명령; ...}" 를 단계 목록으로 변환 (알 수 없는 명령, 장면/종료 명령은 거부)
+static int scene_compile(const char* body, scene_t* scene, char* err, int err_size) {
+    const char* open = strchr(body, '{');
+    const char* close = strrchr(body, '}');
+    if (!open || !close || close < open) {
+        snprintf(err, err_size, "명령 목록은 {명령; 명령; ...} 형식");
+        return -1;
+    }
+
+    scene->step_count = 0;
+    scene->devices = 0;
+    for (const char* p = open + 1; p < close;) {
+        const char* end = memchr(p, ';', close - p);
+        if (!end) end = close;
+        while (p < end && *p == ' ') p++;
+        int len = end - p;
+        while (len > 0 && p[len - 1] == ' ') len--;
+
+        if (len > 0) {
+            char step_cmd[MAX_SCENE_CMD];
+            if (len >= MAX_SCENE_CMD || scene->step_count >= MAX_SCENE_STEPS) {
+                snprintf(err, err_size, "명령은 %d개, 각 %d자 이내", MAX_SCENE_STEPS, MAX_SCENE_CMD - 1);
+                return -1;
+            }
+            memcpy(step_cmd, p, len);
+            step_cmd[len] = '\0';
+
+            const cmd_handler_t* entry = find_handler(step_cmd);
+            if (!entry) {
+                snprintf(err, err_size, "알 수 없는 명령 '%s'", step_cmd);
+                return -1;
+            }
+            if (strncmp(step_cmd, "SCENE_", 6) == 0 || strcmp(entry->cmd, "QUIT") == 0) {
+                snprintf(err, err_size, "장면 안에서 SCENE_*/QUIT 사용 불가");
+                return -1;
+            }
+            scene_step_t* step = &scene->steps[scene->step_count++];
+            step->handler = entry->handler;
+            strcpy(step->cmd, step_cmd);
+            scene->devices |= entry->devices;
+        }
+        p = end + 1;
+    }
+    if (scene->step_count == 0) {
+        snprintf(err, err_size, "명령이 없음");
+        return -1;
+    }
+    return 0;
+}
+
+static scene_t* scene_find(const char* name) {
+    for (int i = 0; i < MAX_SCENES; i++) {
+        if (scenes[i].name[0] && strcmp(scenes[i].name, name) == 0) return &scenes[i];
+    }
+    return NULL;
+}
+
+// SCENE_DEFINE <이름> {명령; 명령; ...}: 같은 이름이 있으면 교체
+int handle_scene_define(const char* cmd, char* resp, int size) {
+    scene_t compiled;
+    char name[32], err[160];
+    int consumed = 0;
+
+    if (sscanf(cmd, "SCENE_DEFINE %31[^ {] %n", name, &consumed) != 1 || consumed == 0) {
+        return snprintf(resp, size, "ERROR: SCENE_DEFINE <이름> {명령; 명령; ...} 형식으로 입력");
+    }
+
+    pthread_mutex_lock(&scene_mutex);
+    if (scene_compile(cmd + consumed, &compiled, err, sizeof(err)) < 0) {
+        pthread_mutex_unlock(&scene_mutex);
+        return snprintf(resp, size, "ERROR: 장면 정의 실패 - %s", err);
+    }
+    scene_t* scene = scene_find(name);
+    for (int i = 0; !scene && i < MAX_SCENES; i++) {
+        if (!scenes[i].name[0]) scene = &scenes[i];
+    }
+    if (!scene) {
+        pthread_mutex_unlock(&scene_mutex);
+        return snprintf(resp, size, "ERROR: 장면은 %d개까지", MAX_SCENES);
+    }
+    snprintf(compiled.name, sizeof(compiled.name), "%s", name);
+    compiled.runs = 0;
+    *scene = compiled;
+    pthread_mutex_unlock(&scene_mutex);
+    return snprintf(resp, size, "OK: 장면 %s 정의 (%d단계)", name, compiled.step_count);
+}
+
+typedef struct {
+    const scene_t* scene;
+    char first_error[256];
+} scene_run_t;
+
+// 장면 단계 실행 (장면이 쓰는 장치 스레드가 모두 멈춘 상태), 실패한 단계 수 반환
+static int scene_run_steps(void* arg) {
+    scene_run_t* run = arg;
+    char step_resp[MAX_RESPONSE_SIZE];
+    int failed = 0;
+
+    unsigned long epoch = device_actor_urgent_epoch(run->scene->devices);
+
+    for (int i = 0; i < run->scene->step_count; i++) {
+        const scene_step_t* step = &run->scene->steps[i];
+        if (device_actor_urgent_epoch(run->scene->devices) != epoch) {
+            // 비상 명령이 들어옴: 남은 단계는 실행하지 않고 장치 스레드를 풀어 줌
+            if (failed == 0) snprintf(run->first_error, sizeof(run->first_error), "%s -> 비상 명령으로 중단", step->cmd);
+            failed += run->scene->step_count - i;
+            break;
+        }
+        step_resp[0] = '\0';
+        step->handler(step->cmd, step_resp, sizeof(step_resp));
+        if (strncmp(step_resp, "ERROR", 5) == 0 && failed++ == 0) {
+            snprintf(run->first_error, sizeof(run->first_error), "%s -> %s", step->cmd, step_resp);
+        }
+    }
+    return failed;
+}
+
+// SCENE_RUN <이름>: 필요한 장치 스레드를 모두 멈춰 세우고 실행하여 다른 클라이언트가 중간 상태를 보지 않음
+int handle_scene_run(const char* cmd, char* resp, int size) {
+    scene_t scene;
+    scene_run_t run = {&scene, ""};
+    char name[32];
+
+    if (sscanf(cmd, "SCENE_RUN %31s", name) != 1) {
+        return snprintf(resp, size, "ERROR: SCENE_RUN <이름> 형식으로 입력");
+    }
+    pthread_mutex_lock(&scene_mutex);
+    scene_t* found = scene_find(name);
+    if (found) {
+        found->runs++;
+        scene = *found;
+    }
+    pthread_mutex_unlock(&scene_mutex);
+    if (!found) {
+        return snprintf(resp, size, "ERROR: 장면 %s 없음", name);
+    }
+
+    int failed = device_actor_call(scene.devices, scene_run_steps, &run);
+    if (failed == ACTOR_CANCELLED) {
+        return snprintf(resp, size, "ERROR: 장면 %s 실행 전 비상 명령으로 취소됨", name);
+    }
+    if (failed) {
+        return snprintf(resp, size, "ERROR: 장면 %s %d/%d단계 실패 (%s)", name, failed, scene.step_count, run.first_error);
+    }
+    return snprintf(resp, size, "OK: 장면 %s 실행 (%d단계)", name, scene.step_count);
+}
+
+int handle_scene_delete(const char* cmd, char* resp, int size) {
+    char name[32];
+    if (sscanf(cmd, "SCENE_DELETE %31s", name) != 1) {
+        return snprintf(resp, size, "ERROR: SCENE_DELETE <이름> 형식으로 입력");
+    }
+    pthread_mutex_lock(&scene_mutex);
+    scene_t* scene = scene_find(name);
+    if (scene) scene->name[0] = '\0';
+    pthread_mutex_unlock(&scene_mutex);
+    return snprintf(resp, size, scene ? "OK: 장면 %s 삭제" : "ERROR: 장면 %s 없음", name);
+}
+
+int handle_scene_list(const char* cmd, char* resp, int size) {
+    int count = 0;
+    int len = snprintf(resp, size, "OK: 장면");
+
+    pthread_mutex_lock(&scene_mutex);
+    for (int i = 0; i < MAX_SCENES && len < size; i++) {
+        const scene_t* scene = &scenes[i];
+        if (!scene->name[0]) continue;
+        count++;
+        len += snprintf(resp + len, size - len, "\n%s (실행 %lu, 장치", scene->name, scene->runs);
+        for (int d = 0; d < DEVICE_COUNT && len < size; d++) {
+            if (scene->devices & (1u << d)) len += snprintf(resp + len, size - len, " %s", device_names[d]);
+        }
+        for (int s = 0; s < scene->step_count && len < size; s++) {
+            len += snprintf(resp + len, size - len, "%s%s", s == 0 ? "): " : "; ", scene->steps[s].cmd);
+        }
+    }
+    pthread_mutex_unlock(&scene_mutex);
+    if (count == 0 && len < size) len += snprintf(resp + len, size - len, " 없음");
+    return len;
+}
+
+// 카운트다운 알람 등록 (BUZZER 장치 스레드에서 실행)
+static int countdown_alarm(void* arg) {
+    (void)arg;
+    return device_funcs.buzzer.submit ? device_funcs.buzzer.submit("school_bell", BUZZER_PRIO_ALARM) : -1;
+}
+
+// 이벤트 구독자: 카운트다운 완료 -> 알람 우선순위로 부저 대기열에 등록
+// 이벤트 버스 스레드는 부저를 직접 부르지 않고 BUZZER 장치 스레드 우편함에 넣기만 함 (완료를 기다리지 않음)
+static void on_countdown_finished(const device_event_t* ev, void* ctx) {
+    device_actor_post(__builtin_ctz(DEV_BUZZER), countdown_alarm, NULL, NULL);
+}
+
+// 이벤트 구독자: 카운트다운 틱 외 모든 이벤트 기록
+static void on_event_log(const device_event_t* ev, void* ctx) {
+    write_log("[EVENT] #%lu %s %d", ev->seq, event_type_name(ev->type), ev->value);
+}
+
+// 명령어 핸들러 테이블 (장치 스레드: 장치 상태를 바꾸거나 보는 명령만, 센서 값/통계 조회는 호출자 스레드에서 바로)
 cmd_handler_t cmd_handlers[] = {
-    {"LED_ON", handle_led_on},
-    {"LED_OFF", handle_led_off}, 
-    {"LED_BRIGHTNESS", handle_led_brightness},
-    {"SEGMENT_DISPLAY", handle_segment_display},
-    {"SEGMENT_COUNTDOWN", handle_segment_countdown},
-    {"CDS_AUTO_START", handle_cds_auto_start},
-    {"CDS_AUTO_STOP", handle_cds_auto_stop},
-    {"CDS_READ", handle_cds_read},
-    {"CDS_GET_STATUS", handle_cds_get_status},
-    {"ALL_OFF", handle_all_off},
-    {"HELP", handle_help},
-    {"QUIT", handle_quit},
-    {NULL, NULL}
+    {"LED_ON", handle_led_on, DEV_LED, COALESCE_LED_OUTPUT},
+    {"LED_OFF", handle_led_off, DEV_LED, COALESCE_LED_OUTPUT},
+    {"LED_BRIGHTNESS", handle_led_brightness, DEV_LED, COALESCE_LED_OUTPUT},
+    {"LED_PERCENT", handle_led_percent, DEV_LED},
+    {"LED_FADE", handle_led_fade, DEV_LED},
+    {"LED_PATTERN_STOP", handle_led_pattern_stop, DEV_LED},
+    {"LED_PATTERN_STATS", handle_led_pattern_stats, DEV_LED},
+    {"LED_PATTERN", handle_led_pattern, DEV_LED},
+    {"SEGMENT_DISPLAY", handle_segment_display, DEV_SEGMENT, COALESCE_SEGMENT_VALUE},
+    {"SEGMENT_COUNTDOWN", handle_segment_countdown, DEV_SEGMENT},
+    {"SEGMENT_STOP", handle_segment_stop, DEV_SEGMENT},
+    {"SEGMENT_OFF", handle_segment_off, DEV_SEGMENT},
+    {"BUZZER_PLAY", handle_buzzer_play, DEV_BUZZER},
+    {"BUZZER_QUEUE", handle_buzzer_queue, DEV_BUZZER},
+    {"BUZZER_STATUS", handle_buzzer_status, DEV_BUZZER},
+    {"BUZZER_LIST", handle_buzzer_list, DEV_BUZZER},
+    {"BUZZER_BACKEND", handle_buzzer_backend, DEV_BUZZER},
+    {"BUZZER_STOP", handle_buzzer_stop, DEV_BUZZER, 0, CMD_EMERGENCY},
+    {"CDS_AUTO_START", handle_cds_auto_start, DEV_CDS},
+    {"CDS_AUTO_STOP", handle_cds_auto_stop, DEV_CDS},
+    {"CDS_READ", handle_cds_read, 0},
+    {"CDS_GET_STATUS", handle_cds_get_status, DEV_CDS},
+    {"CDS_CACHE_STATS", handle_cds_cache_stats, 0},
+    {"CDS_STATS", handle_cds_stats, 0},
+    {"CDS_HISTORY_STATS", handle_cds_history_stats, 0},
+    {"CDS_HISTORY", handle_cds_history, 0},
+    {"CDS_SCAN_MODE", handle_cds_scan_mode, DEV_CDS},
+    {"CDS_SENSOR_NAME", handle_cds_sensor_name, DEV_CDS},
+    {"CDS_SENSORS", handle_cds_sensors, 0},
+    {"CDS_SENSOR", handle_cds_sensor, 0},
+    {"CDS_SAMPLER_START", handle_cds_sampler_start, DEV_CDS},
+    {"CDS_SAMPLER_STOP", handle_cds_sampler_stop, DEV_CDS},
+    {"CDS_HYSTERESIS", handle_cds_hysteresis, DEV_CDS},
+    {"CDS_ADAPTIVE", handle_cds_adaptive, DEV_CDS},
+    {"CDS_TRACE_RECORD", handle_cds_trace_record, DEV_CDS},
+    {"CDS_SAMPLES", handle_cds_samples, 0},
+    {"RULE_ADD", handle_rule_add, 0},
+    {"RULE_DEL", handle_rule_del, 0},
+    {"RULE_LIST", handle_rule_list, 0},
+    {"RULE_SIGNALS", handle_rule_signals, 0},
+    {"EVENT_PUBLISH", handle_event_publish, 0},
+    {"EVENT_STATS", handle_event_stats, 0},
+    {"AT ", handle_at, 0},
+    {"EVERY", handle_every, 0},
+    {"SCHED_CANCEL", handle_sched_cancel, 0},
+    {"SCHED_LIST", handle_sched_list, 0},
+    {"SCENE_DEFINE", handle_scene_define, 0},
+    {"SCENE_RUN", handle_scene_run, 0},
+    {"SCENE_DELETE", handle_scene_delete, 0},
+    {"SCENE_LIST", handle_scene_list, 0},
+    {"ALL_OFF", handle_all_off, DEV_ALL, 0, CMD_EMERGENCY},
+    {"LOCKSTATS", handle_lockstats, 0},
+    {"ACTOR_STATS", handle_actor_stats, 0},
+    {"HELP", handle_help, 0},
+    {"QUIT", handle_quit, 0},
+    {NULL, NULL, 0, 0, 0}
 };
 
-// 명령어 처리
-int process_command(const char* command, char* response, int response_size) {
+// 명령어 처리기 찾기 (앞부분 일치, 표에서 긴 이름이 먼저)
+static const cmd_handler_t* find_handler(const char* command) {
     for (int i = 0; cmd_handlers[i].cmd; i++) {
-        if (strncmp(command, cmd_handlers[i].cmd, strlen(cmd_handlers[i].cmd)) == 0) {
-            cmd_handlers[i].handler(command, response, response_size);
-            return strcmp(cmd_handlers[i].cmd, "QUIT") == 0 ? -1 : 0;
-        }
+        if (strncmp(command, cmd_handlers[i].cmd, strlen(cmd_handlers[i].cmd)) == 0) return &cmd_handlers[i];
     }
-    
-    if (strcmp(command, "SEGMENT_STOP") == 0) {
-        snprintf(response, response_size, device_funcs.segment.stop && device_funcs.segment.stop() == 0 ?
-                "OK: SEGMENT 카운트다운 중지" : "ERROR: SEGMENT 중지 실패");
-    } else if (strcmp(command, "SEGMENT_OFF") == 0) {
-        if (device_funcs.segment.off) device_funcs.segment.off();
-        snprintf(response, response_size, "OK: SEGMENT 꺼짐");
-    } else if (strcmp(command, "BUZZER_PLAY") == 0) {
-        snprintf(response, response_size, device_funcs.buzzer.play && device_funcs.buzzer.play() == 0 ?
-                "OK: 부저 재생 시작" : "ERROR: 부저 재생 실패");
-    } else if (strcmp(command, "BUZZER_STOP") == 0) {
-        snprintf(response, response_size, device_funcs.buzzer.stop && device_funcs.buzzer.stop() == 0 ?
-                "OK: 부저 중지" : "ERROR: 부저 중지 실패");
-    } else {
+    return NULL;
+}
+
+typedef struct {
+    const cmd_handler_t* entry;
+    const char* command;
+    char* response;
+    int response_size;
+} command_call_t;
+
+static int command_run(void* arg) {
+    command_call_t* call = arg;
+    return call->entry->handler(call->command, call->response, call->response_size);
+}
+
+// 합침 키 (범위를 벗어난 값은 합치지 않음: 실패할 명령이 앞의 정상 명령을 대체하면 안 되고 오류 응답도 받아야 함)
+static unsigned int command_coalesce_key(const cmd_handler_t* entry, const char* command) {
+    int value;
+
+    if (entry->handler == handle_led_brightness) {
+        return sscanf(command, "LED_BRIGHTNESS %d", &value) == 1 && value >= 0 && value <= 2 ? entry->coalesce : 0;
+    }
+    if (entry->handler == handle_segment_display) {
+        return sscanf(command, "SEGMENT_DISPLAY %d", &value) == 1 && value >= 0 && value <= 9 ? entry->coalesce : 0;
+    }
+    return entry->coalesce;
+}
+
+// 명령어 처리 (명령이 쓰는 장치의 스레드에서 실행하고 완료를 기다림)
+int process_command(const char* command, char* response, int response_size) {
+    const cmd_handler_t* entry = find_handler(command);
+    if (!entry) {
         snprintf(response, response_size, "ERROR: 알 수 없는 명령어 '%s'", command);
+        return 0;
+    }
+
+    if (entry->priority == CMD_EMERGENCY) {
+        // 처리기가 장치 스레드마다 비상 통로로 정지를 보냄 (일반 통로에서 기다리지 않음)
+        entry->handler(command, response, response_size);
+        return 0;
+    }
+
+    command_call_t call = {entry, command, response, response_size};
+    int result = device_actor_call_coalesce(entry->devices, command_coalesce_key(entry, command), command_run, &call);
+    if (result == ACTOR_COALESCED) {
+        snprintf(response, response_size, "OK: 뒤 명령으로 대체됨 (%s)", command);
+    } else if (result == ACTOR_CANCELLED) {
+        snprintf(response, response_size, "ERROR: 비상 명령으로 취소됨 (%s)", command);
+    }
+    return strcmp(entry->cmd, "QUIT") == 0 ? -1 : 0;
+}
+
+static int send_all(int fd, const char* buf, int len) {
+    while (len > 0) {
+        int sent = send(fd, buf, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return -1;
+        buf += sent;
+        len -= sent;
     }
     return 0;
 }
 
-// 클라이언트 처리 (간소화된 버전)
+// 클라이언트 처리: 줄 단위로 명령을 읽어 차례로 처리하므로 여러 명령을 응답을 기다리지 않고 이어 보내도 됨
+// 응답은 빈 줄로 끝나고 (여러 줄 응답 구분), 한 번에 받은 명령들의 응답은 모아서 보냄
+// 줄바꿈 없이 보낸 명령은 PARTIAL_CMD_WAIT_MS 동안 더 오지 않으면 처리 (이전 클라이언트 호환)
 void handle_client(int client_fd) {
     char buffer[BUFFER_SIZE] = {0};
     char response[MAX_RESPONSE_SIZE] = {0};
+    char out[MAX_RESPONSE_SIZE * 4];
+    int used, out_len = 0, discarding = 0, quit = 0, opt = 1;
 
     int bytes_received = recv(client_fd, buffer, BUFFER_SIZE - 1, 0);
     if (bytes_received <= 0) {
@@ -330,41 +1235,133 @@ void handle_client(int client_fd) {
     }
     
     // TCP 소켓 처리
-    send(client_fd, "연결완료\n", 9, 0);
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    send_all(client_fd, "연결완료\n", strlen("연결완료\n"));
     write_log("TCP 클라이언트 연결됨 (fd: %d)", client_fd);
-
-    buffer[strcspn(buffer, "\r\n")] = '\0';
-    if (strlen(buffer) > 0) {
-        write_log("명령어 수신: %s", buffer);
-        if (process_command(buffer, response, sizeof(response)) == -1) {
-            close(client_fd);
-            return;
-        }
-        strcat(response, "\n");
-        send(client_fd, response, strlen(response), 0);
-    }
+    used = bytes_received;
 
     while (running) {
-        memset(buffer, 0, BUFFER_SIZE);
-        memset(response, 0, MAX_RESPONSE_SIZE);
+        int start = 0;
+        char* newline;
 
-        bytes_received = recv(client_fd, buffer, BUFFER_SIZE - 1, 0);
-        if (bytes_received <= 0) break;
+        while (!quit && (newline = memchr(buffer + start, '\n', used - start)) != NULL) {
+            char* line = buffer + start;
+            *newline = '\0';
+            if (newline > line && newline[-1] == '\r') newline[-1] = '\0';
+            start = newline - buffer + 1;
 
-        buffer[strcspn(buffer, "\r\n")] = '\0';
-        if (strlen(buffer) == 0) continue;
+            if (discarding) {
+                discarding = 0;
+                continue;
+            }
+            if (*line == '\0') continue;
 
-        write_log("명령어 수신: %s", buffer);
-        if (process_command(buffer, response, sizeof(response)) == -1) break;
-        
-        strcat(response, "\n");
-        send(client_fd, response, strlen(response), 0);
+            write_log("명령어 수신: %s", line);
+            response[0] = '\0';
+            if (process_command(line, response, sizeof(response)) == -1) {
+                quit = 1;
+                break;
+            }
+            int len = strlen(response);
+            if (out_len + len + 2 > (int)sizeof(out)) {
+                if (send_all(client_fd, out, out_len) < 0) quit = 1;
+                out_len = 0;
+            }
+            memcpy(out + out_len, response, len);
+            memcpy(out + out_len + len, "\n\n", 2);
+            out_len += len + 2;
+        }
+        if (out_len > 0) {
+            if (send_all(client_fd, out, out_len) < 0) quit = 1;
+            out_len = 0;
+        }
+        if (quit) break;
+
+        used -= start;
+        memmove(buffer, buffer + start, used);
+        if (used == BUFFER_SIZE - 1) {
+            if (!discarding) {
+                out_len = snprintf(out, sizeof(out), "ERROR: 명령이 너무 김 (%d자 이내)\n\n", BUFFER_SIZE - 2);
+                send_all(client_fd, out, out_len);
+                out_len = 0;
+            }
+            discarding = 1;
+            used = 0;
+        }
+
+        if (used > 0 && !discarding) {
+            struct pollfd pfd = {client_fd, POLLIN, 0};
+            if (poll(&pfd, 1, PARTIAL_CMD_WAIT_MS) == 0) {
+                buffer[used++] = '\n';
+                continue;
+            }
+        }
+        bytes_received = recv(client_fd, buffer + used, BUFFER_SIZE - 1 - used, 0);
+        if (bytes_received <= 0) break;
+        used += bytes_received;
     }
 
     write_log("TCP 클라이언트 연결 종료 (fd: %d)", client_fd);
     close(client_fd);
 }
 
+// 접속마다 스레드 하나 (연결을 유지하는 클라이언트가 다른 접속을 막지 않도록)
+static int client_fds[MAX_CLIENTS];
+static int client_count = 0;
+static pthread_mutex_t client_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void* client_thread(void* arg) {
+    int client_fd = (int)(long)arg;
+    handle_client(client_fd);
+
+    pthread_mutex_lock(&client_mutex);
+    for (int i = 0; i < client_count; i++) {
+        if (client_fds[i] == client_fd) {
+            client_fds[i] = client_fds[--client_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&client_mutex);
+    return NULL;
+}
+
+static void start_client(int client_fd) {
+    pthread_t tid;
+
+    pthread_mutex_lock(&client_mutex);
+    if (client_count >= MAX_CLIENTS) {
+        pthread_mutex_unlock(&client_mutex);
+        write_log("동시 접속 %d개 초과, 연결 거부 (fd: %d)", MAX_CLIENTS, client_fd);
+        close(client_fd);
+        return;
+    }
+    client_fds[client_count++] = client_fd;
+    if (pthread_create(&tid, NULL, client_thread, (void*)(long)client_fd) != 0) {
+        client_count--;
+        pthread_mutex_unlock(&client_mutex);
+        write_log("클라이언트 스레드 생성 실패 (fd: %d)", client_fd);
+        close(client_fd);
+        return;
+    }
+    pthread_detach(tid);
+    pthread_mutex_unlock(&client_mutex);
+}
+
+// 종료 시 접속을 모두 끊고 처리 중인 명령이 끝나길 잠시 기다림 (라이브러리 정리 전에)
+static void stop_clients(void) {
+    pthread_mutex_lock(&client_mutex);
+    for (int i = 0; i < client_count; i++) {
+        shutdown(client_fds[i], SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&client_mutex);
+
+    for (int wait = 0; wait < 100 && __atomic_load_n(&client_count, __ATOMIC_ACQUIRE) > 0; wait++) {
+        usleep(10000);
+    }
+}
+
+// iot_microbench 는 이 파일을 포함해 내부 함수를 직접 측정하므로 main 은 제외
+#ifndef IOT_BENCH
 int main(int argc, char *argv[]) {
     if(argc < 2) {
         printf("Usage: %s [-d|-h]\n  -d: 데몬 모드\n  -h: 도움말\n", argv[0]);
@@ -387,12 +1384,32 @@ int main(int argc, char *argv[]) {
     write_log("IoT 서버 시작 중...");
     if (load_device_libraries() < 0) { write_log("동적 라이브러리 로딩 실패"); return -1; }
 
+    // 모의 wiringPi(make SIM=1)로 빌드된 경우 스케줄러/규칙 엔진도 장치 라이브러리와 같은 시계 사용
+    if (dev_clock_bind(led_lib)) write_log("모의 wiringPi 시계 사용");
+
     // 디바이스 초기화
     if (device_funcs.led.init) device_funcs.led.init();
     if (device_funcs.segment.init) device_funcs.segment.init();
     if (device_funcs.buzzer.init) device_funcs.buzzer.init();
     if (device_funcs.cds.init) device_funcs.cds.init();
 
+    // 장치 스레드: 명령 처리기는 장치마다 하나인 소유 스레드에서 차례로 실행 (명령 경로에 장치 잠금 없음)
+    if (device_actor_start(device_names, DEVICE_COUNT) < 0) { write_log("장치 스레드 시작 실패"); return -1; }
+
+    // 규칙 엔진: 동작은 process_command 로 실행, 라이브러리는 상태가 바뀔 때 신호를 보냄
+    rule_engine_start(process_command);
+    if (device_funcs.cds.set_signal_hook) device_funcs.cds.set_signal_hook(rule_signal);
+    if (device_funcs.segment.set_signal_hook) device_funcs.segment.set_signal_hook(rule_signal);
+
+    // 이벤트 버스: 장치 간 반응은 라이브러리끼리 직접 부르지 않고 구독으로 연결
+    event_bus_subscribe("buzzer", EVENT_MASK(EVENT_COUNTDOWN_FINISHED), on_countdown_finished, NULL);
+    event_bus_subscribe("log", EVENT_MASK_ALL & ~EVENT_MASK(EVENT_COUNTDOWN_TICK), on_event_log, NULL);
+    if (device_funcs.segment.set_event_publisher) device_funcs.segment.set_event_publisher(event_publish);
+    if (device_funcs.cds.set_event_publisher) device_funcs.cds.set_event_publisher(event_publish);
+
+    // 예약 명령: 기록 파일에서 복구 후 휠 스레드가 process_command 로 실행
+    scheduler_start(SCHEDULE_FILE, process_command);
+
     // 소켓 설정
     struct sockaddr_in address;
     int opt = 1, addrlen = sizeof(address);
@@ -447,13 +1464,14 @@ int main(int argc, char *argv[]) {
         if (activity > 0 && FD_ISSET(server_fd, &readfds)) {
             int client_fd = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen);
             if (client_fd < 0) {
+                if (!running) break;   // 시그널 핸들러가 대기 소켓을 닫음
                 if (errno != EAGAIN && errno != EWOULDBLOCK) {
                     write_log("accept() 실패: %s", strerror(errno));
                 }
                 continue;
             }
             write_log("새 클라이언트 연결 수락 (fd: %d)", client_fd);
-            handle_client(client_fd);
+            start_client(client_fd);
         }
         
         if (!running) {
@@ -462,14 +1480,25 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // 정리
+    // 정리 (시그널로 끝났으면 정리가 멈춰도 2초 뒤 SIGALRM 으로 종료)
+    if (stop_signal) {
+        write_log("종료 신호 수신 (%d)", (int)stop_signal);
+        alarm(2);
+    }
     write_log("서버 종료 중...");
+    stop_clients();
+    scheduler_stop();
+    rule_engine_stop();
+    device_actor_stop();
+    event_bus_stop();
     if (device_funcs.led.cleanup) device_funcs.led.cleanup();
     if (device_funcs.segment.cleanup) device_funcs.segment.cleanup();
     if (device_funcs.buzzer.cleanup) device_funcs.buzzer.cleanup();
     if (device_funcs.cds.cleanup) device_funcs.cds.cleanup();
+    alarm(0);
     unload_device_libraries();
     if (server_fd != -1) close(server_fd);
     if (daemon_mode) { remove_pid_file(); closelog(); }
     return 0;
 }
+#endif // IOT_BENCH
@@ -0,0 +1,517 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "control_device.h"
+#include "rule_engine.h"
+#include "dev_clock.h"
+
+#define MAX_RULES 512
+#define MAX_SIGNALS 128
+#define SIGNAL_HASH_SIZE 256     // 2의 거듭제곱, MAX_SIGNALS 의 2배
+#define MAX_CONDS 4
+#define MAX_SIGNAL_NAME 32
+#define MAX_ACTION 128
+#define ACTION_QUEUE_SIZE 64     // 2의 거듭제곱
+#define RULE_LIST_TAIL 64        // 목록이 잘릴 때 남은 개수 안내에 남겨 두는 크기
+
+enum { OP_GT, OP_GE, OP_LT, OP_LE, OP_EQ, OP_NE };
+static const char* op_names[] = {">", ">=", "<", "<=", "==", "!="};
+
+typedef struct {
+    int signal;                  // signals[] 색인
+    int op;
+    int value;
+} rule_cond_t;
+
+typedef struct {
+    int id;                      // 0 이면 빈 칸
+    int cond_count;
+    rule_cond_t conds[MAX_CONDS];
+    int hold_ms;                 // for 조건 (0 이면 즉시)
+    int state;                   // 마지막 평가 결과
+    long long deadline_ms;       // for 대기 중이면 실행 시각, 아니면 0
+    unsigned long fired;
+    char action[MAX_ACTION];
+} rule_t;
+
+typedef struct {
+    char name[MAX_SIGNAL_NAME];
+    int value;
+    int valid;                   // 값을 한 번이라도 받았는지
+    unsigned long updates;
+    int* deps;                   // 이 신호를 참조하는 규칙 칸 번호
+    int dep_count;
+    int dep_cap;
+} signal_t;
+
+static pthread_mutex_t rule_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rule_cond = PTHREAD_COND_INITIALIZER;   // 시작 시 CLOCK_MONOTONIC 으로 다시 초기화
+static pthread_t rule_tid;
+static int rule_running = 0;
+static int (*rule_dispatch)(const char* cmd, char* resp, int size) = NULL;
+
+static rule_t rules[MAX_RULES];
+static int next_rule_id = 1;
+static signal_t signals[MAX_SIGNALS];
+static int signal_count = 0;
+static short signal_hash[SIGNAL_HASH_SIZE];   // signals[] 색인 + 1 (0 = 빈 칸)
+
+// for 대기 중인 규칙 칸 번호 (대기 중인 것만 훑어 다음 실행 시각 계산)
+static int armed[MAX_RULES];
+static int armed_count = 0;
+
+// 실행 대기 동작 (규칙 삭제와 무관하도록 문자열 복사)
+static char action_queue[ACTION_QUEUE_SIZE][MAX_ACTION];
+static unsigned int queue_head = 0, queue_tail = 0;
+
+static unsigned long stat_updates = 0;
+static unsigned long stat_evals = 0;
+static unsigned long stat_fired = 0;
+static unsigned long stat_dropped = 0;
+
+static long long rule_now_ms(void) {
+    struct timespec ts;
+    dev_clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static unsigned int signal_hash_of(const char* name) {
+    unsigned int h = 2166136261u;
+    while (*name) {
+        h = (h ^ (unsigned char)*name++) * 16777619u;
+    }
+    return h;
+}
+
+// 신호 찾기 (create 면 없을 때 등록), 없거나 가득 차면 -1
+static int signal_find(const char* name, int create) {
+    unsigned int slot = signal_hash_of(name) & (SIGNAL_HASH_SIZE - 1);
+
+    while (signal_hash[slot]) {
+        int index = signal_hash[slot] - 1;
+        if (strcmp(signals[index].name, name) == 0) return index;
+        slot = (slot + 1) & (SIGNAL_HASH_SIZE - 1);
+    }
+    if (!create || signal_count >= MAX_SIGNALS || strlen(name) >= MAX_SIGNAL_NAME) return -1;
+
+    signal_t* sig = &signals[signal_count];
+    memset(sig, 0, sizeof(*sig));
+    strcpy(sig->name, name);
+    signal_hash[slot] = signal_count + 1;
+    return signal_count++;
+}
+
+static int signal_add_dep(signal_t* sig, int rule_slot) {
+    for (int i = 0; i < sig->dep_count; i++) {
+        if (sig->deps[i] == rule_slot) return 0;
+    }
+    if (sig->dep_count == sig->dep_cap) {
+        int cap = sig->dep_cap ? sig->dep_cap * 2 : 8;
+        int* deps = realloc(sig->deps, cap * sizeof(int));
+        if (!deps) return -1;
+        sig->deps = deps;
+        sig->dep_cap = cap;
+    }
+    sig->deps[sig->dep_count++] = rule_slot;
+    return 0;
+}
+
+static void signal_remove_dep(signal_t* sig, int rule_slot) {
+    for (int i = 0; i < sig->dep_count; i++) {
+        if (sig->deps[i] == rule_slot) {
+            sig->deps[i] = sig->deps[--sig->dep_count];
+            return;
+        }
+    }
+}
+
+static int cond_eval(const rule_cond_t* cond) {
+    const signal_t* sig = &signals[cond->signal];
+    if (!sig->valid) return 0;
+
+    switch (cond->op) {
+        case OP_GT: return sig->value > cond->value;
+        case OP_GE: return sig->value >= cond->value;
+        case OP_LT: return sig->value < cond->value;
+        case OP_LE: return sig->value <= cond->value;
+        case OP_EQ: return sig->value == cond->value;
+        default:    return sig->value != cond->value;
+    }
+}
+
+// 실행 대기열에 추가 (rule_mutex 잡은 상태)
+static void action_enqueue(rule_t* rule) {
+    if (queue_tail - queue_head >= ACTION_QUEUE_SIZE) {
+        stat_dropped++;
+        printf("[RULE] 실행 대기열 가득 참, 규칙 #%d 동작 버림\n", rule->id);
+        return;
+    }
+    strcpy(action_queue[queue_tail & (ACTION_QUEUE_SIZE - 1)], rule->action);
+    queue_tail++;
+    rule->fired++;
+    stat_fired++;
+    pthread_cond_signal(&rule_cond);
+}
+
+static void armed_remove(int rule_slot) {
+    for (int i = 0; i < armed_count; i++) {
+        if (armed[i] == rule_slot) {
+            armed[i] = armed[--armed_count];
+            return;
+        }
+    }
+}
+
+// 규칙 하나 평가, 거짓 -> 참 전환이면 실행 또는 for 대기 시작 (rule_mutex 잡은 상태)
+static void rule_evaluate(int rule_slot, long long now_ms) {
+    rule_t* rule = &rules[rule_slot];
+    int state = 1;
+
+    stat_evals++;
+    for (int i = 0; i < rule->cond_count && state; i++) {
+        state = cond_eval(&rule->conds[i]);
+    }
+    if (state == rule->state) return;
+    rule->state = state;
+
+    if (!state) {
+        if (rule->deadline_ms) {
+            rule->deadline_ms = 0;
+            armed_remove(rule_slot);
+        }
+    } else if (rule->hold_ms == 0) {
+        action_enqueue(rule);
+    } else {
+        rule->deadline_ms = now_ms + rule->hold_ms;
+        armed[armed_count++] = rule_slot;
+        pthread_cond_signal(&rule_cond);
+    }
+}
+
+void rule_signal(const char* name, int value) {
+    pthread_mutex_lock(&rule_mutex);
+
+    int index = signal_find(name, 1);
+    if (index < 0) {
+        pthread_mutex_unlock(&rule_mutex);
+        return;
+    }
+    signal_t* sig = &signals[index];
+    stat_updates++;
+    sig->updates++;
+    if (sig->valid && sig->value == value) {
+        pthread_mutex_unlock(&rule_mutex);
+        return;
+    }
+    sig->value = value;
+    sig->valid = 1;
+
+    long long now_ms = rule_now_ms();
+    for (int i = 0; i < sig->dep_count; i++) {
+        rule_evaluate(sig->deps[i], now_ms);
+    }
+    pthread_mutex_unlock(&rule_mutex);
+}
+
+// 규칙 스레드: for 만료 처리와 동작 실행
+static void* rule_thread(void* arg) {
+    (void)arg;
+    char action[MAX_ACTION];
+    char response[MAX_RESPONSE_SIZE];
+
+    pthread_mutex_lock(&rule_mutex);
+    while (rule_running) {
+        if (queue_head != queue_tail) {
+            strcpy(action, action_queue[queue_head & (ACTION_QUEUE_SIZE - 1)]);
+            queue_head++;
+            pthread_mutex_unlock(&rule_mutex);
+
+            response[0] = '\0';
+            rule_dispatch(action, response, sizeof(response));
+            printf("[RULE] %s -> %s\n", action, response);
+
+            pthread_mutex_lock(&rule_mutex);
+            continue;
+        }
+
+        // 만료된 for 대기 실행, 남은 것 중 가장 이른 시각까지 대기
+        long long now_ms = rule_now_ms(), earliest = 0;
+        for (int i = 0; i < armed_count; ) {
+            rule_t* rule = &rules[armed[i]];
+            if (rule->deadline_ms <= now_ms) {
+                rule->deadline_ms = 0;
+                armed[i] = armed[--armed_count];
+                action_enqueue(rule);
+                continue;
+            }
+            if (earliest == 0 || rule->deadline_ms < earliest) earliest = rule->deadline_ms;
+            i++;
+        }
+        if (queue_head != queue_tail) continue;
+
+        if (earliest == 0) {
+            pthread_cond_wait(&rule_cond, &rule_mutex);
+        } else {
+            struct timespec until = {earliest / 1000, (earliest % 1000) * 1000000L};
+            dev_cond_timedwait(&rule_cond, &rule_mutex, &until);
+        }
+    }
+    pthread_mutex_unlock(&rule_mutex);
+    return NULL;
+}
+
+int rule_engine_start(int (*dispatch)(const char* cmd, char* resp, int size)) {
+    pthread_condattr_t attr;
+
+    pthread_mutex_lock(&rule_mutex);
+    if (rule_running) {
+        pthread_mutex_unlock(&rule_mutex);
+        return 0;
+    }
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&rule_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    rule_dispatch = dispatch;
+    rule_running = 1;
+    if (pthread_create(&rule_tid, NULL, rule_thread, NULL) != 0) {
+        rule_running = 0;
+        pthread_mutex_unlock(&rule_mutex);
+        printf("[RULE] 규칙 스레드 생성 실패\n");
+        return -1;
+    }
+    pthread_mutex_unlock(&rule_mutex);
+    printf("[RULE] 규칙 엔진 시작\n");
+    return 0;
+}
+
+void rule_engine_stop(void) {
+    pthread_mutex_lock(&rule_mutex);
+    if (!rule_running) {
+        pthread_mutex_unlock(&rule_mutex);
+        return;
+    }
+    rule_running = 0;
+    pthread_cond_signal(&rule_cond);
+    pthread_mutex_unlock(&rule_mutex);
+    pthread_join(rule_tid, NULL);
+}
+
+// 조건 하나 해석: <신호> <연산자> <값>
+static int parse_cond(const char* text, char* name, int* op, int* value) {
+    char op_text[3];
+    char extra;
+
+    if (sscanf(text, " %31[A-Za-z0-9_.] %2[<>=!] %d %c", name, op_text, value, &extra) != 3) return -1;
+    for (int i = 0; i < (int)(sizeof(op_names) / sizeof(op_names[0])); i++) {
+        if (strcmp(op_text, op_names[i]) == 0) {
+            *op = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int rule_add(const char* text, char* err, int err_size) {
+    char conds_text[256];
+    char names[MAX_CONDS][MAX_SIGNAL_NAME];
+    rule_t rule;
+
+    memset(&rule, 0, sizeof(rule));
+    while (isspace((unsigned char)*text)) text++;
+    if (strncmp(text, "when ", 5) == 0) text += 5;
+
+    const char* then = strstr(text, " then ");
+    if (!then || then - text >= (int)sizeof(conds_text)) {
+        snprintf(err, err_size, "when <조건> then <명령> 형식이 아님");
+        return -1;
+    }
+    memcpy(conds_text, text, then - text);
+    conds_text[then - text] = '\0';
+
+    const char* action = then + 6;
+    while (isspace((unsigned char)*action)) action++;
+    if (*action == '\0' || strlen(action) >= MAX_ACTION) {
+        snprintf(err, err_size, "동작 명령이 비었거나 너무 김 (%d자 이내)", MAX_ACTION - 1);
+        return -1;
+    }
+    if (strncmp(action, "QUIT", 4) == 0 || strncmp(action, "RULE_", 5) == 0) {
+        snprintf(err, err_size, "QUIT/RULE_* 는 동작으로 쓸 수 없음");
+        return -1;
+    }
+    strcpy(rule.action, action);
+
+    // 끝의 "for <n>s|ms" 분리
+    char* hold = strstr(conds_text, " for ");
+    if (hold) {
+        int amount;
+        char unit[4] = "";
+        if (sscanf(hold + 5, "%d%3s", &amount, unit) < 1 || amount <= 0 ||
+            (strcmp(unit, "s") != 0 && strcmp(unit, "ms") != 0 && strcmp(unit, "m") != 0)) {
+            snprintf(err, err_size, "for <n>ms|s|m 형식이 아님");
+            return -1;
+        }
+        rule.hold_ms = strcmp(unit, "ms") == 0 ? amount : strcmp(unit, "s") == 0 ? amount * 1000 : amount * 60000;
+        *hold = '\0';
+    }
+
+    // 조건들: and 로 연결
+    char* cursor = conds_text;
+    while (cursor) {
+        char* next = strstr(cursor, " and ");
+        if (next) {
+            *next = '\0';
+            next += 5;
+        }
+        if (rule.cond_count >= MAX_CONDS) {
+            snprintf(err, err_size, "조건은 %d개까지", MAX_CONDS);
+            return -1;
+        }
+        rule_cond_t* cond = &rule.conds[rule.cond_count];
+        if (parse_cond(cursor, names[rule.cond_count], &cond->op, &cond->value) < 0) {
+            snprintf(err, err_size, "조건 '%s' 해석 실패 (<신호> <연산자> <값>, 연산자 > >= < <= == !=)", cursor);
+            return -1;
+        }
+        rule.cond_count++;
+        cursor = next;
+    }
+
+    pthread_mutex_lock(&rule_mutex);
+
+    int rule_slot = -1;
+    for (int i = 0; i < MAX_RULES; i++) {
+        if (rules[i].id == 0) {
+            rule_slot = i;
+            break;
+        }
+    }
+    if (rule_slot < 0) {
+        pthread_mutex_unlock(&rule_mutex);
+        snprintf(err, err_size, "규칙은 %d개까지", MAX_RULES);
+        return -1;
+    }
+    for (int i = 0; i < rule.cond_count; i++) {
+        rule.conds[i].signal = signal_find(names[i], 1);
+        if (rule.conds[i].signal < 0) {
+            pthread_mutex_unlock(&rule_mutex);
+            snprintf(err, err_size, "신호 등록 실패 (이름 %d자 이내, 신호 %d개까지)", MAX_SIGNAL_NAME - 1, MAX_SIGNALS);
+            return -1;
+        }
+    }
+    for (int i = 0; i < rule.cond_count; i++) {
+        if (signal_add_dep(&signals[rule.conds[i].signal], rule_slot) < 0) {
+            for (int j = 0; j < i; j++) signal_remove_dep(&signals[rule.conds[j].signal], rule_slot);
+            pthread_mutex_unlock(&rule_mutex);
+            snprintf(err, err_size, "메모리 부족");
+            return -1;
+        }
+    }
+
+    rule.id = next_rule_id++;
+    rules[rule_slot] = rule;
+
+    // 이미 조건을 만족하면 추가 즉시 전환으로 처리
+    rule_evaluate(rule_slot, rule_now_ms());
+    pthread_mutex_unlock(&rule_mutex);
+
+    printf("[RULE] 규칙 #%d 추가: %s\n", rule.id, text);
+    return rule.id;
+}
+
+int rule_delete(int id) {
+    pthread_mutex_lock(&rule_mutex);
+    for (int i = 0; i < MAX_RULES; i++) {
+        if (id > 0 && rules[i].id == id) {
+            for (int c = 0; c < rules[i].cond_count; c++) {
+                signal_remove_dep(&signals[rules[i].conds[c].signal], i);
+            }
+            if (rules[i].deadline_ms) armed_remove(i);
+            memset(&rules[i], 0, sizeof(rules[i]));
+            pthread_mutex_unlock(&rule_mutex);
+            printf("[RULE] 규칙 #%d 삭제\n", id);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&rule_mutex);
+    return -1;
+}
+
+static int rule_id_compare(const void* a, const void* b) {
+    return rules[*(const int*)a].id - rules[*(const int*)b].id;
+}
+
+// 규칙 한 줄 (조건, 동작, 상태), 줄 길이 반환
+static int rule_format(const rule_t* rule, long long now_ms, char* line, int size) {
+    int len = snprintf(line, size, "\n#%d when", rule->id);
+    for (int c = 0; c < rule->cond_count && len < size; c++) {
+        const rule_cond_t* cond = &rule->conds[c];
+        len += snprintf(line + len, size - len, "%s %s %s %d", c ? " and" : "",
+                        signals[cond->signal].name, op_names[cond->op], cond->value);
+    }
+    if (rule->hold_ms && len < size) {
+        len += snprintf(line + len, size - len, " for %dms", rule->hold_ms);
+    }
+    if (len < size) {
+        len += snprintf(line + len, size - len, " then %s [%s, 실행 %lu]", rule->action,
+                        rule->deadline_ms ? "대기" : rule->state ? "참" : "거짓", rule->fired);
+    }
+    if (rule->deadline_ms && len < size) {
+        len += snprintf(line + len, size - len, " %lldms 후", rule->deadline_ms - now_ms);
+    }
+    return len < size ? len : size - 1;
+}
+
+// 번호가 from_id 이상인 규칙을 번호 순으로 buf 에 들어가는 만큼 (줄 단위로 자르고 남은 개수와 다음 조회 번호 표시)
+int rule_list(int from_id, char* buf, int size) {
+    int order[MAX_RULES];
+    int count = 0, listed = 0;
+
+    pthread_mutex_lock(&rule_mutex);
+    for (int i = 0; i < MAX_RULES; i++) {
+        if (!rules[i].id) continue;
+        count++;
+        if (rules[i].id >= from_id) order[listed++] = i;
+    }
+    qsort(order, listed, sizeof(order[0]), rule_id_compare);
+
+    int len = snprintf(buf, size, "규칙 %d개 (신호 갱신 %lu, 평가 %lu, 실행 %lu, 버림 %lu)",
+                       count, stat_updates, stat_evals, stat_fired, stat_dropped);
+
+    long long now_ms = rule_now_ms();
+    char line[512];
+    int shown = 0;
+    for (; shown < listed; shown++) {
+        int line_len = rule_format(&rules[order[shown]], now_ms, line, sizeof(line));
+        if (len + line_len >= size - RULE_LIST_TAIL) break;   // 이어서 조회 안내 자리를 남김
+        memcpy(buf + len, line, line_len + 1);
+        len += line_len;
+    }
+    if (shown < listed && len < size) {
+        len += snprintf(buf + len, size - len, "\n… %d개 더 (RULE_LIST %d 로 이어서 조회)",
+                        listed - shown, rules[order[shown]].id);
+    }
+    pthread_mutex_unlock(&rule_mutex);
+    return len < size ? len : size - 1;
+}
+
+int rule_signals(char* buf, int size) {
+    pthread_mutex_lock(&rule_mutex);
+    int len = snprintf(buf, size, "신호 %d개", signal_count);
+    for (int i = 0; i < signal_count && len < size; i++) {
+        const signal_t* sig = &signals[i];
+        if (sig->valid) {
+            len += snprintf(buf + len, size - len, "\n%s = %d (갱신 %lu, 규칙 %d)", sig->name, sig->value,
+                            sig->updates, sig->dep_count);
+        } else {
+            len += snprintf(buf + len, size - len, "\n%s = ? (규칙 %d)", sig->name, sig->dep_count);
+        }
+    }
+    pthread_mutex_unlock(&rule_mutex);
+    return len < size ? len : size - 1;
+}
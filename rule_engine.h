@@ -0,0 +1,24 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+// 선언형 자동화 규칙 엔진 (서버 본체)
+// 규칙: when <신호> <연산자> <값> [and ...] [for <n>s|ms] then <명령>
+//   예) when cds.value > 200 for 5s then LED_BRIGHTNESS 1
+// 규칙은 참조하는 신호별 목록으로 색인하여, 신호 값이 바뀌면 그 신호를 쓰는 규칙만 다시 평가
+// 조건이 거짓 -> 참으로 바뀔 때 한 번 실행하며, for 가 있으면 그 시간 동안 참이 유지되어야 함
+// 동작은 규칙 스레드에서 dispatch(= process_command) 로 실행 (신호를 보낸 스레드는 막히지 않음)
+
+int rule_engine_start(int (*dispatch)(const char* cmd, char* resp, int size));
+void rule_engine_stop(void);
+
+// 신호 값 갱신 (signal_hook_fn 으로 라이브러리에 전달)
+void rule_signal(const char* name, int value);
+
+// 규칙 추가, 성공 시 규칙 번호, 실패 시 -1 과 err 에 사유
+int rule_add(const char* text, char* err, int err_size);
+int rule_delete(int id);
+// 번호가 from_id 이상인 규칙 목록, buf 에 다 들어가지 않으면 줄 단위로 자르고 남은 개수와 다음 번호를 붙임
+int rule_list(int from_id, char* buf, int size);
+int rule_signals(char* buf, int size);
+
+#endif // RULE_ENGINE_H
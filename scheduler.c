@@ -0,0 +1,670 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "control_device.h"
+#include "scheduler.h"
+#include "dev_clock.h"
+
+#define SCHED_TICK_MS 100
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 5                  // 64^5 틱 = 약 3.4년, 그보다 먼 작업은 마지막 칸에서 다시 배치
+#define MAX_JOBS 4096
+#define JOB_HASH_SIZE 1024              // 2의 거듭제곱
+#define MAX_SCHED_CMD 128
+#define SCHED_GRACE_MS 3600000LL        // 놓친 실제 시각 작업을 늦게라도 실행하는 한도 (재시작/시계 변경)
+#define SCHED_JUMP_MS 1000              // 실제 시각과 단조 시각의 차이가 이만큼 바뀌면 시계 변경으로 판단
+#define SCHED_FIRE_BATCH 32
+#define SCHED_LIST_TAIL 64              // 목록이 잘릴 때 남은 개수 안내에 남겨 두는 크기
+
+enum { SCHED_AT, SCHED_DAILY, SCHED_EVERY };
+static const char* kind_names[] = {"at", "daily", "every"};
+
+typedef struct list_node {
+    struct list_node* prev;
+    struct list_node* next;
+} list_node_t;
+
+typedef struct sched_job {
+    list_node_t node;                   // 휠 칸 또는 실행 대기 목록 (첫 멤버)
+    struct sched_job* hash_next;        // 번호 색인 / 빈 칸 목록
+    int id;                             // 0 이면 빈 칸
+    int kind;
+    int queued;                         // 실행 대기 목록에 있음
+    int day_seconds;                    // DAILY: 하루 중 시각 (초)
+    long long due_tick;
+    long long wall_ms;                  // AT/DAILY: 다음 실행 실제 시각, EVERY: 기준 시각 (재시작 시 위상 유지)
+    long long interval_ms;              // EVERY 간격
+    unsigned long runs;
+    char cmd[MAX_SCHED_CMD];
+} sched_job_t;
+
+static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t sched_tid;
+static int sched_running = 0;
+static int (*sched_dispatch)(const char* cmd, char* resp, int size) = NULL;
+
+static sched_job_t jobs[MAX_JOBS];
+static sched_job_t* free_jobs = NULL;
+static sched_job_t* job_hash[JOB_HASH_SIZE];
+static list_node_t wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static list_node_t ready;
+static long long current_tick = 0;      // 처리를 마친 마지막 틱
+static long long offset_ms = 0;         // 실제 시각 - 단조 시각
+static int job_count = 0;
+static int next_job_id = 1;
+
+static char journal_path[256];
+static FILE* journal = NULL;
+static int journal_lines = 0;
+
+static unsigned long stat_fired = 0;
+static unsigned long stat_jumps = 0;
+static unsigned long stat_missed = 0;
+
+static void list_init(list_node_t* head) {
+    head->prev = head->next = head;
+}
+
+static void list_add_tail(list_node_t* head, list_node_t* node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static void list_del(list_node_t* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = node;
+}
+
+static long long mono_ms(void) {
+    struct timespec ts;
+    dev_clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static long long wall_ms(void) {
+    struct timespec ts;
+    dev_clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// 실제 시각 -> 틱 (올림)
+static long long wall_to_tick(long long wall) {
+    long long mono = wall - offset_ms;
+    return (mono + SCHED_TICK_MS - 1) / SCHED_TICK_MS;
+}
+
+// after_ms 이후 처음 오는 하루 중 day_seconds 시각 (지역 시간, 일광 절약 시간 반영)
+static long long next_daily(int day_seconds, long long after_ms) {
+    time_t t = after_ms / 1000;
+    struct tm tm;
+
+    localtime_r(&t, &tm);
+    tm.tm_hour = day_seconds / 3600;
+    tm.tm_min = day_seconds / 60 % 60;
+    tm.tm_sec = day_seconds % 60;
+    tm.tm_isdst = -1;
+    time_t next = mktime(&tm);
+    if (next * 1000LL <= after_ms) {
+        localtime_r(&t, &tm);
+        tm.tm_mday++;
+        tm.tm_hour = day_seconds / 3600;
+        tm.tm_min = day_seconds / 60 % 60;
+        tm.tm_sec = day_seconds % 60;
+        tm.tm_isdst = -1;
+        next = mktime(&tm);
+    }
+    return next * 1000LL;
+}
+
+// 휠에 넣기: 남은 틱 수로 단을 고르고, 그 단의 칸은 실행 틱의 해당 비트로 정함 (O(1))
+static void wheel_insert(sched_job_t* job, long long min_tick) {
+    long long due = job->due_tick < min_tick ? min_tick : job->due_tick;
+    long long delta = due - current_tick;
+    long long horizon = 1LL << (WHEEL_BITS * WHEEL_LEVELS);
+    int level = 0;
+
+    if (delta >= horizon) {
+        due = current_tick + horizon - 1;
+        delta = horizon - 1;
+    }
+    while (level < WHEEL_LEVELS - 1 && delta >= (1LL << (WHEEL_BITS * (level + 1)))) level++;
+    list_add_tail(&wheel[level][(due >> (WHEEL_BITS * level)) & WHEEL_MASK], &job->node);
+}
+
+static sched_job_t* job_find(int id) {
+    sched_job_t* job = job_hash[id & (JOB_HASH_SIZE - 1)];
+    while (job && job->id != id) job = job->hash_next;
+    return job;
+}
+
+static sched_job_t* job_alloc(int id) {
+    sched_job_t* job = free_jobs;
+    if (!job) return NULL;
+    free_jobs = job->hash_next;
+
+    memset(job, 0, sizeof(*job));
+    list_init(&job->node);
+    job->id = id;
+    job->hash_next = job_hash[id & (JOB_HASH_SIZE - 1)];
+    job_hash[id & (JOB_HASH_SIZE - 1)] = job;
+    if (id >= next_job_id) next_job_id = id + 1;
+    job_count++;
+    return job;
+}
+
+static void job_free(sched_job_t* job) {
+    sched_job_t** link = &job_hash[job->id & (JOB_HASH_SIZE - 1)];
+    while (*link != job) link = &(*link)->hash_next;
+    *link = job->hash_next;
+
+    list_del(&job->node);
+    job->id = 0;
+    job->hash_next = free_jobs;
+    free_jobs = job;
+    job_count--;
+}
+
+// 기록 파일 한 줄 (추가: "+ 번호 종류 ...", 삭제: "- 번호")
+static void journal_write_job(FILE* fp, const sched_job_t* job) {
+    if (job->kind == SCHED_EVERY) {
+        fprintf(fp, "+ %d every %lld %lld %s\n", job->id, job->interval_ms, job->wall_ms, job->cmd);
+    } else if (job->kind == SCHED_DAILY) {
+        fprintf(fp, "+ %d daily %d %s\n", job->id, job->day_seconds, job->cmd);
+    } else {
+        fprintf(fp, "+ %d at %lld %s\n", job->id, job->wall_ms, job->cmd);
+    }
+}
+
+// 현재 작업만으로 기록 파일을 다시 씀 (임시 파일 후 rename)
+static void journal_compact(void) {
+    char tmp_path[sizeof(journal_path) + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", journal_path);
+
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) {
+        printf("[SCHED] 기록 파일 정리 실패: %s\n", strerror(errno));
+        return;
+    }
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (jobs[i].id) journal_write_job(fp, &jobs[i]);
+    }
+    fflush(fp);
+    fsync(fileno(fp));
+    fclose(fp);
+
+    if (journal) fclose(journal);
+    rename(tmp_path, journal_path);
+    journal = fopen(journal_path, "a");
+    journal_lines = job_count;
+}
+
+static void journal_add(const sched_job_t* job) {
+    if (!journal) return;
+    journal_write_job(journal, job);
+    fflush(journal);
+    journal_lines++;
+}
+
+static void journal_remove(int id) {
+    if (!journal) return;
+    fprintf(journal, "- %d\n", id);
+    fflush(journal);
+    if (++journal_lines > job_count * 2 + 64) journal_compact();
+}
+
+// 다음 실행 틱 계산 후 휠에 넣기 (sched_mutex 잡은 상태)
+static void job_schedule(sched_job_t* job) {
+    if (job->kind == SCHED_EVERY) {
+        long long interval = job->interval_ms / SCHED_TICK_MS;
+        if (job->due_tick <= current_tick) {
+            job->due_tick += ((current_tick - job->due_tick) / interval + 1) * interval;  // 밀린 회차는 건너뜀
+        }
+    } else {
+        job->due_tick = wall_to_tick(job->wall_ms);
+    }
+    wheel_insert(job, current_tick + 1);
+}
+
+// 실제 시각 작업의 실행 시각이 한도보다 오래 지났으면 AT 은 버리고 DAILY 는 다음 날로 (버리면 1)
+static int job_check_missed(sched_job_t* job, long long now_wall) {
+    if (job->kind == SCHED_EVERY || job->wall_ms >= now_wall - SCHED_GRACE_MS) return 0;
+
+    stat_missed++;
+    if (job->kind == SCHED_DAILY) {
+        printf("[SCHED] #%d 실행 시각을 놓침, 다음 날로: %s\n", job->id, job->cmd);
+        job->wall_ms = next_daily(job->day_seconds, now_wall);
+        return 0;
+    }
+    printf("[SCHED] #%d 실행 시각을 %lld초 넘겨 버림: %s\n", job->id, (now_wall - job->wall_ms) / 1000, job->cmd);
+    journal_remove(job->id);
+    job_free(job);
+    return 1;
+}
+
+// 틱 하나 진행: 상위 단 칸을 아래로 내리고, 0단 칸의 만기 작업을 실행 대기 목록으로
+static void wheel_advance(void) {
+    list_node_t moving;
+
+    current_tick++;
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if (((current_tick >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK) != 0) break;
+
+        list_node_t* slot = &wheel[level][(current_tick >> (WHEEL_BITS * level)) & WHEEL_MASK];
+        if (slot->next == slot) continue;
+        list_init(&moving);
+        moving.next = slot->next;
+        moving.prev = slot->prev;
+        moving.next->prev = &moving;
+        moving.prev->next = &moving;
+        list_init(slot);
+        while (moving.next != &moving) {
+            sched_job_t* job = (sched_job_t*)moving.next;
+            list_del(&job->node);
+            wheel_insert(job, current_tick);
+        }
+    }
+
+    list_node_t* slot = &wheel[0][current_tick & WHEEL_MASK];
+    while (slot->next != slot) {
+        sched_job_t* job = (sched_job_t*)slot->next;
+        list_del(&job->node);
+        if (job->due_tick > current_tick) {
+            wheel_insert(job, current_tick + 1);   // 범위 밖이라 마지막 칸에 있던 작업
+        } else {
+            job->queued = 1;
+            list_add_tail(&ready, &job->node);
+        }
+    }
+}
+
+// 시계 변경: 실제 시각 작업의 틱을 새 차이로 다시 계산
+static void handle_clock_jump(long long new_offset, long long now_wall) {
+    printf("[SCHED] 시계 변경 감지 (%+lldms), 실제 시각 작업 재배치\n", new_offset - offset_ms);
+    offset_ms = new_offset;
+    stat_jumps++;
+
+    for (int i = 0; i < MAX_JOBS; i++) {
+        sched_job_t* job = &jobs[i];
+        if (!job->id || job->kind == SCHED_EVERY || job->queued) continue;
+        list_del(&job->node);
+        if (job_check_missed(job, now_wall)) continue;
+        job_schedule(job);
+    }
+}
+
+static void* scheduler_thread(void* arg) {
+    (void)arg;
+    char cmds[SCHED_FIRE_BATCH][MAX_SCHED_CMD];
+    int ids[SCHED_FIRE_BATCH];
+    char response[MAX_RESPONSE_SIZE];
+    struct timespec next;
+
+    dev_clock_gettime(CLOCK_MONOTONIC, &next);
+    while (__atomic_load_n(&sched_running, __ATOMIC_ACQUIRE)) {
+        next.tv_nsec += SCHED_TICK_MS * 1000000L;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        dev_sleep_until(CLOCK_MONOTONIC, &next);
+
+        pthread_mutex_lock(&sched_mutex);
+        long long now_mono = mono_ms(), now_wall = wall_ms();
+        long long new_offset = now_wall - now_mono;
+        if (new_offset - offset_ms > SCHED_JUMP_MS || offset_ms - new_offset > SCHED_JUMP_MS) {
+            handle_clock_jump(new_offset, now_wall);
+        }
+
+        // 명령 실행이 길어 밀린 틱도 차례로 처리
+        long long now_tick = now_mono / SCHED_TICK_MS;
+        while (current_tick < now_tick) wheel_advance();
+
+        // 깨어난 시각이 예정보다 10틱 넘게 늦었으면 다음 예정 시각을 지금부터 다시 잡음 (밀린 만큼 잠 없이 연달아 돌지 않게)
+        long long next_ms = next.tv_sec * 1000LL + next.tv_nsec / 1000000;
+        if (now_mono - next_ms > 10 * SCHED_TICK_MS) dev_clock_gettime(CLOCK_MONOTONIC, &next);
+
+        while (ready.next != &ready) {
+            int count = 0;
+            while (ready.next != &ready && count < SCHED_FIRE_BATCH) {
+                sched_job_t* job = (sched_job_t*)ready.next;
+                list_del(&job->node);
+                job->queued = 0;
+                job->runs++;
+                stat_fired++;
+                ids[count] = job->id;
+                strcpy(cmds[count++], job->cmd);
+
+                if (job->kind == SCHED_AT) {
+                    journal_remove(job->id);
+                    job_free(job);
+                    continue;
+                }
+                if (job->kind == SCHED_DAILY) {
+                    job->wall_ms = next_daily(job->day_seconds, now_wall > job->wall_ms ? now_wall : job->wall_ms);
+                }
+                job_schedule(job);
+            }
+            pthread_mutex_unlock(&sched_mutex);
+
+            for (int i = 0; i < count; i++) {
+                response[0] = '\0';
+                sched_dispatch(cmds[i], response, sizeof(response));
+                printf("[SCHED] #%d %s -> %s\n", ids[i], cmds[i], response);
+            }
+            pthread_mutex_lock(&sched_mutex);
+        }
+        pthread_mutex_unlock(&sched_mutex);
+    }
+    return NULL;
+}
+
+// 기록 파일에서 작업 복구 (sched_mutex 잡은 상태)
+static void journal_load(long long now_wall) {
+    char line[MAX_SCHED_CMD + 96];
+    FILE* fp = fopen(journal_path, "r");
+    if (!fp) return;
+
+    while (fgets(line, sizeof(line), fp)) {
+        char kind[8];
+        int id, consumed = 0;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (sscanf(line, "- %d", &id) == 1) {
+            sched_job_t* job = job_find(id);
+            if (job) job_free(job);
+            continue;
+        }
+        if (sscanf(line, "+ %d %7s %n", &id, kind, &consumed) < 2 || consumed == 0 || id <= 0 || job_find(id)) continue;
+
+        sched_job_t* job = job_alloc(id);
+        if (!job) break;
+        const char* rest = line + consumed;
+        int ok = 0, n = 0;
+        if (strcmp(kind, "every") == 0) {
+            job->kind = SCHED_EVERY;
+            ok = sscanf(rest, "%lld %lld %n", &job->interval_ms, &job->wall_ms, &n) == 2 && job->interval_ms >= SCHED_TICK_MS;
+        } else if (strcmp(kind, "daily") == 0) {
+            job->kind = SCHED_DAILY;
+            ok = sscanf(rest, "%d %n", &job->day_seconds, &n) == 1 && job->day_seconds >= 0 && job->day_seconds < 86400;
+        } else if (strcmp(kind, "at") == 0) {
+            job->kind = SCHED_AT;
+            ok = sscanf(rest, "%lld %n", &job->wall_ms, &n) == 1;
+        }
+        if (!ok || n == 0 || rest[n] == '\0') {
+            job_free(job);
+            continue;
+        }
+        snprintf(job->cmd, sizeof(job->cmd), "%s", rest + n);
+    }
+    fclose(fp);
+
+    // 다음 실행 시각 계산: EVERY 는 기준 시각의 위상 유지, DAILY 는 다음 날짜, AT 은 한도 안이면 늦게라도 실행
+    for (int i = 0; i < MAX_JOBS; i++) {
+        sched_job_t* job = &jobs[i];
+        if (!job->id) continue;
+        if (job->kind == SCHED_EVERY) {
+            long long first = job->wall_ms;
+            if (first < now_wall) first += ((now_wall - first) / job->interval_ms + 1) * job->interval_ms;
+            job->due_tick = wall_to_tick(first);
+        } else if (job->kind == SCHED_DAILY) {
+            job->wall_ms = next_daily(job->day_seconds, now_wall);
+        } else if (job_check_missed(job, now_wall)) {
+            continue;
+        }
+        job_schedule(job);
+    }
+    printf("[SCHED] 예약 %d개 복구\n", job_count);
+}
+
+int scheduler_start(const char* path, int (*dispatch)(const char* cmd, char* resp, int size)) {
+    pthread_mutex_lock(&sched_mutex);
+    if (sched_running) {
+        pthread_mutex_unlock(&sched_mutex);
+        return 0;
+    }
+
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SIZE; slot++) list_init(&wheel[level][slot]);
+    }
+    list_init(&ready);
+    free_jobs = NULL;
+    for (int i = MAX_JOBS - 1; i >= 0; i--) {
+        jobs[i].id = 0;
+        jobs[i].hash_next = free_jobs;
+        free_jobs = &jobs[i];
+    }
+
+    long long now_mono = mono_ms(), now_wall = wall_ms();
+    offset_ms = now_wall - now_mono;
+    current_tick = now_mono / SCHED_TICK_MS;
+    sched_dispatch = dispatch;
+
+    snprintf(journal_path, sizeof(journal_path), "%s", path);
+    journal_load(now_wall);
+    journal_compact();
+    if (!journal) {
+        printf("[SCHED] 기록 파일 열기 실패 (%s), 예약은 재시작 시 사라짐\n", path);
+    }
+
+    __atomic_store_n(&sched_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&sched_tid, NULL, scheduler_thread, NULL) != 0) {
+        __atomic_store_n(&sched_running, 0, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&sched_mutex);
+        printf("[SCHED] 스케줄러 스레드 생성 실패\n");
+        return -1;
+    }
+    pthread_mutex_unlock(&sched_mutex);
+    printf("[SCHED] 스케줄러 시작 (%dms 틱)\n", SCHED_TICK_MS);
+    return 0;
+}
+
+void scheduler_stop(void) {
+    if (!__atomic_exchange_n(&sched_running, 0, __ATOMIC_ACQ_REL)) return;
+    pthread_join(sched_tid, NULL);
+
+    pthread_mutex_lock(&sched_mutex);
+    if (journal) {
+        fclose(journal);
+        journal = NULL;
+    }
+    pthread_mutex_unlock(&sched_mutex);
+}
+
+// 예약할 수 없는 명령 (종료, 예약 명령 자신)
+static int sched_check_cmd(const char* cmd, char* err, int err_size) {
+    if (*cmd == '\0' || strlen(cmd) >= MAX_SCHED_CMD) {
+        snprintf(err, err_size, "명령이 비었거나 너무 김 (%d자 이내)", MAX_SCHED_CMD - 1);
+        return -1;
+    }
+    if (strncmp(cmd, "QUIT", 4) == 0 || strncmp(cmd, "AT ", 3) == 0 || strncmp(cmd, "EVERY", 5) == 0 ||
+        strncmp(cmd, "SCHED_", 6) == 0) {
+        snprintf(err, err_size, "QUIT/AT/EVERY/SCHED_* 는 예약할 수 없음");
+        return -1;
+    }
+    return 0;
+}
+
+static int sched_add(sched_job_t* proto, char* err, int err_size) {
+    pthread_mutex_lock(&sched_mutex);
+    if (!__atomic_load_n(&sched_running, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&sched_mutex);
+        snprintf(err, err_size, "스케줄러가 동작 중이 아님");
+        return -1;
+    }
+    sched_job_t* job = job_alloc(next_job_id);
+    if (!job) {
+        pthread_mutex_unlock(&sched_mutex);
+        snprintf(err, err_size, "예약은 %d개까지", MAX_JOBS);
+        return -1;
+    }
+    job->kind = proto->kind;
+    job->day_seconds = proto->day_seconds;
+    job->wall_ms = proto->wall_ms;
+    job->interval_ms = proto->interval_ms;
+    job->due_tick = proto->due_tick;
+    strcpy(job->cmd, proto->cmd);
+
+    job_schedule(job);
+    journal_add(job);
+    int id = job->id;
+    pthread_mutex_unlock(&sched_mutex);
+
+    printf("[SCHED] #%d 예약 (%s): %s\n", id, kind_names[proto->kind], proto->cmd);
+    return id;
+}
+
+// 시각: HH:MM[:SS] (다음에 오는 그 시각), +<n>s|m|h|d (지금부터), epoch 초
+int scheduler_at(const char* when, int daily, const char* cmd, char* err, int err_size) {
+    sched_job_t proto;
+    int hour, minute, second = 0;
+    long long amount;
+    char unit = 's', extra;
+    long long now_wall = wall_ms();
+
+    memset(&proto, 0, sizeof(proto));
+    if (sched_check_cmd(cmd, err, err_size) < 0) return -1;
+    strcpy(proto.cmd, cmd);
+
+    int fields = sscanf(when, "%d:%d:%d%c", &hour, &minute, &second, &extra);
+    if ((fields == 2 || fields == 3) && strchr(when, ':')) {
+        if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+            snprintf(err, err_size, "시각 범위 오류 (00:00-23:59:59)");
+            return -1;
+        }
+        proto.kind = daily ? SCHED_DAILY : SCHED_AT;
+        proto.day_seconds = hour * 3600 + minute * 60 + second;
+        proto.wall_ms = next_daily(proto.day_seconds, now_wall);
+        return sched_add(&proto, err, err_size);
+    }
+    if (daily) {
+        snprintf(err, err_size, "daily 는 HH:MM 시각과 함께 사용");
+        return -1;
+    }
+    proto.kind = SCHED_AT;
+    if (when[0] == '+' && sscanf(when + 1, "%lld%c%c", &amount, &unit, &extra) >= 1 && amount >= 0) {
+        long long scale = unit == 's' ? 1000LL : unit == 'm' ? 60000LL : unit == 'h' ? 3600000LL : unit == 'd' ? 86400000LL : 0;
+        if (scale == 0 || strlen(when) > 16) {
+            snprintf(err, err_size, "상대 시각은 +<n>s|m|h|d");
+            return -1;
+        }
+        proto.wall_ms = now_wall + amount * scale;
+        return sched_add(&proto, err, err_size);
+    }
+    if (sscanf(when, "%lld%c", &amount, &extra) == 1 && amount > 0) {
+        proto.wall_ms = amount * 1000LL;
+        if (proto.wall_ms < now_wall - SCHED_GRACE_MS) {
+            snprintf(err, err_size, "이미 지난 시각");
+            return -1;
+        }
+        return sched_add(&proto, err, err_size);
+    }
+    snprintf(err, err_size, "시각은 HH:MM[:SS], +<n>s|m|h|d 또는 epoch 초");
+    return -1;
+}
+
+// 간격: <n>ms|s|m|h|d (최소 1틱)
+int scheduler_every(const char* interval, const char* cmd, char* err, int err_size) {
+    sched_job_t proto;
+    long long amount;
+    char unit[4] = "";
+
+    memset(&proto, 0, sizeof(proto));
+    if (sched_check_cmd(cmd, err, err_size) < 0) return -1;
+    if (sscanf(interval, "%lld%3s", &amount, unit) != 2 || amount <= 0) {
+        snprintf(err, err_size, "간격은 <n>ms|s|m|h|d");
+        return -1;
+    }
+    long long scale = strcmp(unit, "ms") == 0 ? 1 : strcmp(unit, "s") == 0 ? 1000LL : strcmp(unit, "m") == 0 ? 60000LL :
+                      strcmp(unit, "h") == 0 ? 3600000LL : strcmp(unit, "d") == 0 ? 86400000LL : 0;
+    if (scale == 0 || amount * scale < SCHED_TICK_MS) {
+        snprintf(err, err_size, "간격은 <n>ms|s|m|h|d, 최소 %dms", SCHED_TICK_MS);
+        return -1;
+    }
+
+    strcpy(proto.cmd, cmd);
+    proto.kind = SCHED_EVERY;
+    proto.interval_ms = amount * scale / SCHED_TICK_MS * SCHED_TICK_MS;
+    proto.wall_ms = wall_ms() + proto.interval_ms;
+    proto.due_tick = mono_ms() / SCHED_TICK_MS + proto.interval_ms / SCHED_TICK_MS;
+    return sched_add(&proto, err, err_size);
+}
+
+int scheduler_cancel(int id) {
+    pthread_mutex_lock(&sched_mutex);
+    sched_job_t* job = id > 0 ? job_find(id) : NULL;
+    if (!job) {
+        pthread_mutex_unlock(&sched_mutex);
+        return -1;
+    }
+    journal_remove(id);
+    job_free(job);
+    pthread_mutex_unlock(&sched_mutex);
+    printf("[SCHED] #%d 취소\n", id);
+    return 0;
+}
+
+static int job_id_compare(const void* a, const void* b) {
+    return jobs[*(const int*)a].id - jobs[*(const int*)b].id;
+}
+
+// 작업 한 줄 (다음 실행 시각, 종류, 명령), 줄 길이 반환
+static int job_format(const sched_job_t* job, char* line, int size) {
+    long long next_wall = job->kind == SCHED_EVERY ? job->due_tick * SCHED_TICK_MS + offset_ms : job->wall_ms;
+    time_t t = next_wall / 1000;
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    int len = snprintf(line, size, "\n#%d %02d-%02d %02d:%02d:%02d ", job->id, tm.tm_mon + 1, tm.tm_mday,
+                       tm.tm_hour, tm.tm_min, tm.tm_sec);
+    if (len < size) {
+        if (job->kind == SCHED_EVERY) {
+            len += snprintf(line + len, size - len, "every %lldms", job->interval_ms);
+        } else {
+            len += snprintf(line + len, size - len, "%s", kind_names[job->kind]);
+        }
+    }
+    if (len < size) {
+        len += snprintf(line + len, size - len, " %s (실행 %lu)", job->cmd, job->runs);
+    }
+    return len < size ? len : size - 1;
+}
+
+// 번호가 from_id 이상인 작업을 번호 순으로 buf 에 들어가는 만큼 (줄 단위로 자르고 남은 개수와 다음 조회 번호 표시)
+int scheduler_list(int from_id, char* buf, int size) {
+    static int order[MAX_JOBS];          // sched_mutex 로 보호
+    int listed = 0;
+
+    pthread_mutex_lock(&sched_mutex);
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (jobs[i].id && jobs[i].id >= from_id) order[listed++] = i;
+    }
+    qsort(order, listed, sizeof(order[0]), job_id_compare);
+
+    int len = snprintf(buf, size, "예약 %d개 (실행 %lu, 시계 변경 %lu, 놓침 %lu)", job_count, stat_fired, stat_jumps, stat_missed);
+
+    char line[MAX_SCHED_CMD + 96];
+    int shown = 0;
+    for (; shown < listed; shown++) {
+        int line_len = job_format(&jobs[order[shown]], line, sizeof(line));
+        if (len + line_len >= size - SCHED_LIST_TAIL) break;   // 이어서 조회 안내 자리를 남김
+        memcpy(buf + len, line, line_len + 1);
+        len += line_len;
+    }
+    if (shown < listed && len < size) {
+        len += snprintf(buf + len, size - len, "\n… %d개 더 (SCHED_LIST %d 로 이어서 조회)",
+                        listed - shown, jobs[order[shown]].id);
+    }
+    pthread_mutex_unlock(&sched_mutex);
+    return len < size ? len : size - 1;
+}
@@ -0,0 +1,20 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// 예약 명령 스케줄러 (서버 본체)
+// 계층형 타이머 휠(100ms 틱, 64칸 x 5단)에 작업을 두어 추가/취소가 작업 수와 무관하게 O(1)
+//   AT <시각> [daily] <명령>  : 실제 시각 기준 (시계가 바뀌면 다시 계산)
+//   EVERY <간격> <명령>       : 간격 기준 (CLOCK_MONOTONIC, 시계 변경 영향 없음)
+// 작업은 추가/삭제 기록 파일(schedule.log)에 남겨 재시작 시 복구
+
+int scheduler_start(const char* path, int (*dispatch)(const char* cmd, char* resp, int size));
+void scheduler_stop(void);
+
+// 성공 시 작업 번호, 실패 시 -1 과 err 에 사유
+int scheduler_at(const char* when, int daily, const char* cmd, char* err, int err_size);
+int scheduler_every(const char* interval, const char* cmd, char* err, int err_size);
+int scheduler_cancel(int id);
+// 번호가 from_id 이상인 작업 목록, buf 에 다 들어가지 않으면 줄 단위로 자르고 남은 개수와 다음 번호를 붙임
+int scheduler_list(int from_id, char* buf, int size);
+
+#endif // SCHEDULER_H
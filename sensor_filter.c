@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include "sensor_filter.h"
+
+void sensor_filter_init(sensor_filter_t* f, int bright, int hz) {
+    f->window_len = 0;
+    f->window_pos = 0;
+    f->ema_x256 = -1;
+    f->filtered = -1;
+    f->bright = bright;
+    f->hz = hz;
+    f->stable = 0;
+}
+
+int sensor_filter_classify(int value, int previous, int threshold, int band) {
+    if (value < threshold - band) return 1;
+    if (value >= threshold + band) return 0;
+    if (previous < 0) return value < threshold;
+    return previous;
+}
+
+// 적응형 주기: 빠르게 변하거나 임계값 근처면 즉시 상한, 안정되면 단계적으로 절반씩 하한까지
+static void sensor_filter_adapt(sensor_filter_t* f, int previous, const sensor_filter_cfg_t* cfg) {
+    if (cfg->min_hz <= 0) return;
+
+    int delta = previous < 0 ? 0 : abs(f->filtered - previous);
+    int distance = abs(f->filtered - cfg->threshold);
+
+    if (delta >= SENSOR_ADAPT_FAST_DELTA || distance <= cfg->band * SENSOR_ADAPT_NEAR_BANDS) {
+        f->hz = cfg->max_hz;
+        f->stable = 0;
+    } else if (delta <= 1) {
+        if (++f->stable >= SENSOR_ADAPT_STABLE_SAMPLES) {
+            f->hz = f->hz / 2 > cfg->min_hz ? f->hz / 2 : cfg->min_hz;
+            f->stable = 0;
+        }
+    } else {
+        f->stable = 0;
+    }
+
+    if (f->hz < cfg->min_hz) f->hz = cfg->min_hz;
+    if (f->hz > cfg->max_hz) f->hz = cfg->max_hz;
+}
+
+int sensor_filter_step(sensor_filter_t* f, int raw, const sensor_filter_cfg_t* cfg) {
+    // 중앙값 필터 (순간적인 튐 제거)
+    f->window[f->window_pos] = raw;
+    f->window_pos = (f->window_pos + 1) % SENSOR_MEDIAN_WINDOW;
+    if (f->window_len < SENSOR_MEDIAN_WINDOW) f->window_len++;
+
+    int sorted[SENSOR_MEDIAN_WINDOW];
+    for (int i = 0; i < f->window_len; i++) {
+        int v = f->window[i], j = i;
+        while (j > 0 && sorted[j - 1] > v) { sorted[j] = sorted[j - 1]; j--; }
+        sorted[j] = v;
+    }
+    int median = sorted[f->window_len / 2];
+
+    // EMA (고정소수점 x256)
+    if (f->ema_x256 < 0) f->ema_x256 = median << 8;
+    else f->ema_x256 += ((median << 8) - f->ema_x256) >> SENSOR_EMA_SHIFT;
+
+    int previous = f->filtered;
+    f->filtered = (f->ema_x256 + 128) >> 8;
+    f->bright = sensor_filter_classify(f->filtered, f->bright, cfg->threshold, cfg->band);
+    sensor_filter_adapt(f, previous, cfg);
+    return f->filtered;
+}
@@ -0,0 +1,39 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+// 조도 샘플 필터와 적응형 샘플링 주기 (libcds 샘플러와 cds_replay 가 같은 코드를 사용)
+// 중앙값 -> EMA -> 히스테리시스 순으로 처리하고, 변화량과 임계값까지의 거리로 다음 주기를 정함
+
+#define SENSOR_MEDIAN_WINDOW 5
+#define SENSOR_EMA_SHIFT 2              // EMA 계수 1/2^n
+#define SENSOR_ADAPT_FAST_DELTA 3       // 한 샘플 사이 변화가 이 이상이면 최고 주기로
+#define SENSOR_ADAPT_NEAR_BANDS 2       // 임계값에서 밴드 x n 이내면 최고 주기로
+#define SENSOR_ADAPT_STABLE_SAMPLES 8   // 변화가 1 이하로 이만큼 이어지면 주기를 절반으로
+
+typedef struct {
+    int threshold;
+    int band;
+    int min_hz;                 // 적응형 주기 하한 (0 이면 고정 주기)
+    int max_hz;                 // 적응형 주기 상한
+} sensor_filter_cfg_t;
+
+typedef struct {
+    int window[SENSOR_MEDIAN_WINDOW];
+    int window_len;
+    int window_pos;
+    int ema_x256;
+    int filtered;               // 마지막 필터 결과 (-1: 없음)
+    int bright;                 // -1: 알 수 없음, 0: 어둠, 1: 밝음
+    int hz;                     // 다음 샘플까지의 주기
+    int stable;                 // 변화 없는 샘플 연속 수
+} sensor_filter_t;
+
+void sensor_filter_init(sensor_filter_t* f, int bright, int hz);
+
+// 히스테리시스 판정: 값이 클수록 어두움, 밴드 안에서는 이전 상태 유지
+int sensor_filter_classify(int value, int previous, int threshold, int band);
+
+// 샘플 하나 처리: 필터 결과를 반환하고 f->bright, f->hz 갱신
+int sensor_filter_step(sensor_filter_t* f, int raw, const sensor_filter_cfg_t* cfg);
+
+#endif // SENSOR_FILTER_H
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "sensor_stats.h"
+
+#define STATS_LEVELS 256         // 8비트 ADC 값마다 한 칸 (백분위가 근사 없이 정확)
+#define STATS_SLOTS 60           // 윈도우당 하위 구간 수
+
+// 윈도우는 하위 구간의 원형 배열과 그 합계로 구성
+// 샘플은 현재 구간과 합계에 더하고, 구간이 밀려날 때 합계에서 뺌
+// 합계/히스토그램은 샘플이 대표하는 시간(ms)으로 가중 (적응형 샘플링에서 빠른 구간이 과대 반영되지 않음)
+typedef struct {
+    unsigned int count;          // 샘플 수
+    long long weight;            // 가중치 합 (ms)
+    long long sum;
+    long long sum_sq;
+    unsigned int hist[STATS_LEVELS];
+} stats_slot_t;
+
+typedef struct {
+    const char* name;
+    long long slot_ms;           // 하위 구간 길이 (윈도우 길이 / STATS_SLOTS)
+    long long current;           // 현재 하위 구간 번호 (ts_ms / slot_ms)
+    stats_slot_t slots[STATS_SLOTS];
+    stats_slot_t total;
+} stats_window_t;
+
+static stats_window_t windows[] = {
+    {"1m", 60000 / STATS_SLOTS, -1},
+    {"15m", 900000 / STATS_SLOTS, -1},
+    {"1h", 3600000 / STATS_SLOTS, -1},
+};
+#define STATS_WINDOWS (int)(sizeof(windows) / sizeof(windows[0]))
+
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void slot_subtract(stats_slot_t* total, const stats_slot_t* slot) {
+    if (slot->count == 0) return;
+    total->count -= slot->count;
+    total->weight -= slot->weight;
+    total->sum -= slot->sum;
+    total->sum_sq -= slot->sum_sq;
+    for (int v = 0; v < STATS_LEVELS; v++) {
+        total->hist[v] -= slot->hist[v];
+    }
+}
+
+// 현재 시각까지 윈도우를 밀어 만료된 하위 구간 제거
+static void window_advance(stats_window_t* w, long long ts_ms) {
+    long long index = ts_ms / w->slot_ms;
+    if (w->current < 0 || index - w->current >= STATS_SLOTS) {
+        memset(w->slots, 0, sizeof(w->slots));
+        memset(&w->total, 0, sizeof(w->total));
+    } else {
+        for (long long i = w->current + 1; i <= index; i++) {
+            stats_slot_t* slot = &w->slots[i % STATS_SLOTS];
+            slot_subtract(&w->total, slot);
+            memset(slot, 0, sizeof(*slot));
+        }
+    }
+    if (index > w->current) w->current = index;
+}
+
+void sensor_stats_add(long long ts_ms, int value, int weight_ms) {
+    if (value < 0 || value >= STATS_LEVELS) return;
+    if (weight_ms < 1) weight_ms = 1;
+
+    pthread_mutex_lock(&stats_mutex);
+    for (int i = 0; i < STATS_WINDOWS; i++) {
+        stats_window_t* w = &windows[i];
+        if (ts_ms / w->slot_ms != w->current) {
+            window_advance(w, ts_ms);
+        }
+
+        stats_slot_t* slot = &w->slots[w->current % STATS_SLOTS];
+        slot->count++;
+        slot->weight += weight_ms;
+        slot->sum += (long long)value * weight_ms;
+        slot->sum_sq += (long long)value * value * weight_ms;
+        slot->hist[value] += weight_ms;
+
+        w->total.count++;
+        w->total.weight += weight_ms;
+        w->total.sum += (long long)value * weight_ms;
+        w->total.sum_sq += (long long)value * value * weight_ms;
+        w->total.hist[value] += weight_ms;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+// 누적 히스토그램에서 p 백분위 값 (시간 가중)
+static int hist_percentile(const stats_slot_t* total, int percent) {
+    unsigned long long target = ((unsigned long long)total->weight * percent + 99) / 100;
+    unsigned long long acc = 0;
+    if (target == 0) target = 1;
+    for (int v = 0; v < STATS_LEVELS; v++) {
+        acc += total->hist[v];
+        if (acc >= target) return v;
+    }
+    return STATS_LEVELS - 1;
+}
+
+static int window_format(stats_window_t* w, long long now_ms, char* buf, int size) {
+    window_advance(w, now_ms);
+    const stats_slot_t* t = &w->total;
+
+    if (t->count == 0) {
+        return snprintf(buf, size, "%s: 샘플 없음", w->name);
+    }
+
+    int min = 0, max = STATS_LEVELS - 1;
+    while (t->hist[min] == 0) min++;
+    while (t->hist[max] == 0) max--;
+
+    double mean = (double)t->sum / t->weight;
+    double variance = ((double)t->sum_sq - (double)t->sum * t->sum / t->weight) / t->weight;
+    if (variance < 0) variance = 0;
+
+    return snprintf(buf, size, "%s: n=%u 최소=%d 최대=%d 평균=%.1f 분산=%.2f 표준편차=%.2f p50=%d p90=%d p99=%d",
+                    w->name, t->count, min, max, mean, variance, sqrt(variance),
+                    hist_percentile(t, 50), hist_percentile(t, 90), hist_percentile(t, 99));
+}
+
+int sensor_stats_format(const char* window, long long now_ms, char* buf, int size) {
+    int len = 0, found = 0;
+
+    pthread_mutex_lock(&stats_mutex);
+    for (int i = 0; i < STATS_WINDOWS && len < size; i++) {
+        if (window && strcmp(window, windows[i].name) != 0) continue;
+        if (found++) len += snprintf(buf + len, size - len, "\n");
+        if (len < size) len += window_format(&windows[i], now_ms, buf + len, size - len);
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    return found ? len : -1;
+}
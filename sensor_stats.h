@@ -0,0 +1,13 @@
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+// 슬라이딩 윈도우 통계 (libcds 내부용)
+// 1분/15분/1시간 윈도우의 최소/최대/평균/분산/백분위를 샘플마다 O(1) 로 갱신
+
+// weight_ms: 샘플이 대표하는 시간 (직전 샘플과의 간격), 평균/분산/백분위는 이 시간으로 가중
+void sensor_stats_add(long long ts_ms, int value, int weight_ms);
+
+// window 가 NULL 이면 모든 윈도우, 아니면 "1m", "15m", "1h" 중 하나
+int sensor_stats_format(const char* window, long long now_ms, char* buf, int size);
+
+#endif // SENSOR_STATS_H
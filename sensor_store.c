@@ -0,0 +1,406 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sensor_store.h"
+#include "dev_clock.h"
+
+#define STORE_MAGIC 0x48534443          // "CDSH"
+#define STORE_VERSION 1
+#define STORE_HEADER_SIZE 4096          // 헤더는 한 페이지에 단독 배치
+#define STORE_FLUSH_INTERVAL_MS 30000   // 디스크 반영 주기 (SD 카드 쓰기량 제한)
+
+// 단계별 용량 (레코드 16바이트, 전체 약 10MB)
+// raw: 20Hz 기준 약 55분, 1s: 약 3일, 1m: 약 6개월, 1h: 약 10년
+static const uint32_t tier_capacity[CDS_TIER_COUNT] = {65536, 262144, 262144, 87600};
+static const long long tier_period_ms[CDS_TIER_COUNT] = {0, 1000, 60000, 3600000};
+static const char* tier_names[CDS_TIER_COUNT] = {"raw", "1s", "1m", "1h"};
+
+// head: 단계별 다음 기록 순번, 두 슬롯에 번갈아 기록하여 쓰는 도중 전원이 꺼져도 이전 head 가 남음
+typedef struct {
+    uint64_t gen;
+    uint64_t next_seq[CDS_TIER_COUNT];
+    uint32_t checksum;
+    uint32_t reserved;
+} store_head_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t tier_count;
+    uint32_t capacity[CDS_TIER_COUNT];
+    uint64_t offset[CDS_TIER_COUNT];
+    store_head_t heads[2];
+} store_header_t;
+
+// 집계 중인 구간 (메모리에만 유지, 재시작 시 미완성 구간은 버림)
+typedef struct {
+    long long bucket_ms;
+    int min;
+    int max;
+    long long sum;               // 값 x 가중치(ms) 합
+    long long weight;
+    int count;
+} rollup_t;
+
+static pthread_mutex_t store_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int store_fd = -1;
+static unsigned char* store_map = NULL;
+static size_t store_size = 0;
+static store_header_t* header = NULL;
+static int active_head = 0;
+
+static uint64_t next_seq[CDS_TIER_COUNT];      // 메모리상 다음 순번 (디스크 head 보다 앞설 수 있음)
+static uint64_t flushed_seq[CDS_TIER_COUNT];   // 디스크 head 에 반영된 순번
+static rollup_t rollups[CDS_TIER_COUNT];
+static long long last_flush_ms = 0;
+static unsigned long flush_count = 0;
+static unsigned long long synced_bytes = 0;
+
+static uint32_t head_checksum(const store_head_t* head) {
+    const unsigned char* p = (const unsigned char*)head;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(store_head_t, checksum); i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static long long store_now_ms(void) {
+    struct timespec now;
+    dev_clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+static sensor_record_t* tier_record(int tier, uint64_t seq) {
+    sensor_record_t* base = (sensor_record_t*)(store_map + header->offset[tier]);
+    return &base[seq % header->capacity[tier]];
+}
+
+static long long record_time_ms(const sensor_record_t* rec) {
+    return rec->ts_s * 1000LL + rec->ts_ms;
+}
+
+// 레코드 기록: 내용을 먼저 쓰고 seq 를 마지막에 기록 (읽는 쪽은 seq 로 유효성 확인)
+static void tier_write(int tier, long long ts_ms, int min, int max, int avg) {
+    uint64_t seq = next_seq[tier];
+    sensor_record_t* rec = tier_record(tier, seq);
+
+    __atomic_store_n(&rec->seq, (unsigned int)(seq - 1), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    rec->ts_s = (unsigned int)(ts_ms / 1000);
+    rec->ts_ms = (unsigned short)(ts_ms % 1000);
+    rec->min = (short)min;
+    rec->max = (short)max;
+    rec->avg = (short)avg;
+    __atomic_store_n(&rec->seq, (unsigned int)seq, __ATOMIC_RELEASE);
+
+    next_seq[tier] = seq + 1;
+}
+
+// 파일 초기화 (크기 설정 후 헤더 작성)
+static int store_format(void) {
+    size_t offset = STORE_HEADER_SIZE;
+
+    memset(header, 0, sizeof(*header));
+    header->magic = STORE_MAGIC;
+    header->version = STORE_VERSION;
+    header->record_size = sizeof(sensor_record_t);
+    header->tier_count = CDS_TIER_COUNT;
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        header->capacity[t] = tier_capacity[t];
+        header->offset[t] = offset;
+        offset += (size_t)tier_capacity[t] * sizeof(sensor_record_t);
+    }
+    header->heads[0].checksum = head_checksum(&header->heads[0]);
+    return msync(store_map, STORE_HEADER_SIZE, MS_SYNC);
+}
+
+static size_t store_expected_size(void) {
+    size_t size = STORE_HEADER_SIZE;
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        size += (size_t)tier_capacity[t] * sizeof(sensor_record_t);
+    }
+    return size;
+}
+
+static int store_header_valid(void) {
+    if (header->magic != STORE_MAGIC || header->version != STORE_VERSION ||
+        header->record_size != sizeof(sensor_record_t) || header->tier_count != CDS_TIER_COUNT) {
+        return 0;
+    }
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        if (header->capacity[t] != tier_capacity[t]) return 0;
+    }
+    return 1;
+}
+
+// 이력 파일 열기 (없거나 형식이 다르면 새로 만듦)
+int sensor_store_open(const char* path) {
+    pthread_mutex_lock(&store_mutex);
+
+    if (store_map) {
+        pthread_mutex_unlock(&store_mutex);
+        return 0;
+    }
+
+    store_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (store_fd < 0) {
+        fprintf(stderr, "[HISTORY] 파일 열기 실패: %s\n", path);
+        pthread_mutex_unlock(&store_mutex);
+        return -1;
+    }
+
+    struct stat st;
+    store_size = store_expected_size();
+    int fresh = fstat(store_fd, &st) < 0 || (size_t)st.st_size != store_size;
+    if (fresh && (ftruncate(store_fd, 0) < 0 || ftruncate(store_fd, store_size) < 0)) {
+        fprintf(stderr, "[HISTORY] 파일 크기 설정 실패\n");
+        close(store_fd);
+        store_fd = -1;
+        pthread_mutex_unlock(&store_mutex);
+        return -1;
+    }
+
+    store_map = mmap(NULL, store_size, PROT_READ | PROT_WRITE, MAP_SHARED, store_fd, 0);
+    if (store_map == MAP_FAILED) {
+        fprintf(stderr, "[HISTORY] mmap 실패\n");
+        store_map = NULL;
+        close(store_fd);
+        store_fd = -1;
+        pthread_mutex_unlock(&store_mutex);
+        return -1;
+    }
+    header = (store_header_t*)store_map;
+
+    if (fresh || !store_header_valid()) {
+        store_format();
+    }
+
+    // 체크섬이 맞는 head 중 세대가 높은 쪽 선택
+    int valid0 = header->heads[0].checksum == head_checksum(&header->heads[0]);
+    int valid1 = header->heads[1].checksum == head_checksum(&header->heads[1]);
+    if (!valid0 && !valid1) {
+        store_format();
+        valid0 = 1;
+    }
+    active_head = (valid1 && (!valid0 || header->heads[1].gen > header->heads[0].gen)) ? 1 : 0;
+
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        next_seq[t] = flushed_seq[t] = header->heads[active_head].next_seq[t];
+        rollups[t].count = 0;
+    }
+    last_flush_ms = store_now_ms();
+
+    pthread_mutex_unlock(&store_mutex);
+    printf("[HISTORY] 이력 저장소 열기: %s (%zuKB, raw %llu개)\n", path, store_size / 1024,
+           (unsigned long long)next_seq[CDS_TIER_RAW]);
+    return 0;
+}
+
+// 기록된 레코드 영역을 먼저 동기화한 뒤 다른 슬롯에 새 head 를 기록
+static int store_flush_locked(void) {
+    long page = sysconf(_SC_PAGESIZE);
+
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        uint64_t from = flushed_seq[t], to = next_seq[t];
+        if (from == to) continue;
+        if (to - from > header->capacity[t]) from = to - header->capacity[t];
+
+        // 원형 버퍼 경계를 넘으면 두 구간으로 나눔
+        while (from < to) {
+            uint64_t index = from % header->capacity[t];
+            uint64_t run = header->capacity[t] - index;
+            if (run > to - from) run = to - from;
+
+            size_t start = header->offset[t] + index * sizeof(sensor_record_t);
+            size_t end = start + run * sizeof(sensor_record_t);
+            start -= start % page;
+            if (msync(store_map + start, end - start, MS_SYNC) < 0) {
+                return -1;
+            }
+            synced_bytes += end - start;
+            from += run;
+        }
+    }
+
+    int slot = !active_head;
+    store_head_t* head = &header->heads[slot];
+    head->gen = header->heads[active_head].gen + 1;
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        head->next_seq[t] = next_seq[t];
+    }
+    head->checksum = head_checksum(head);
+    if (msync(store_map, STORE_HEADER_SIZE, MS_SYNC) < 0) {
+        return -1;
+    }
+
+    synced_bytes += STORE_HEADER_SIZE;
+    active_head = slot;
+    for (int t = 0; t < CDS_TIER_COUNT; t++) {
+        flushed_seq[t] = next_seq[t];
+    }
+    flush_count++;
+    last_flush_ms = store_now_ms();
+    return 0;
+}
+
+int sensor_store_flush(void) {
+    pthread_mutex_lock(&store_mutex);
+    int result = store_map ? store_flush_locked() : -1;
+    pthread_mutex_unlock(&store_mutex);
+    return result;
+}
+
+// 샘플 추가: raw 에 기록하고 상위 단계는 구간이 바뀔 때 집계 레코드를 하나씩 기록
+// 집계 평균은 샘플이 대표하는 시간(weight_ms)으로 가중
+int sensor_store_append(long long ts_ms, int value, int weight_ms) {
+    pthread_mutex_lock(&store_mutex);
+
+    if (!store_map) {
+        pthread_mutex_unlock(&store_mutex);
+        return -1;
+    }
+
+    tier_write(CDS_TIER_RAW, ts_ms, value, value, value);
+    if (weight_ms < 1) weight_ms = 1;
+
+    for (int t = CDS_TIER_1S; t < CDS_TIER_COUNT; t++) {
+        rollup_t* r = &rollups[t];
+        long long bucket = ts_ms - ts_ms % tier_period_ms[t];
+
+        if (r->count > 0 && bucket != r->bucket_ms) {
+            tier_write(t, r->bucket_ms, r->min, r->max, (int)((r->sum + r->weight / 2) / r->weight));
+            r->count = 0;
+        }
+        if (r->count == 0) {
+            r->bucket_ms = bucket;
+            r->min = r->max = value;
+            r->sum = 0;
+            r->weight = 0;
+        }
+        if (value < r->min) r->min = value;
+        if (value > r->max) r->max = value;
+        r->sum += (long long)value * weight_ms;
+        r->weight += weight_ms;
+        r->count++;
+    }
+
+    int result = 0;
+    if (store_now_ms() - last_flush_ms >= STORE_FLUSH_INTERVAL_MS) {
+        result = store_flush_locked();
+    }
+
+    pthread_mutex_unlock(&store_mutex);
+    return result;
+}
+
+// 구간 조회: 순번으로 이진 탐색 후 매핑된 레코드를 그대로 visit 에 전달
+// 조회 중 덮어쓰인 오래된 레코드는 seq 불일치로 건너뜀
+int sensor_store_query(int tier, long long from_ms, long long to_ms, sensor_visit_fn visit, void* ctx) {
+    if (tier < 0 || tier >= CDS_TIER_COUNT) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&store_mutex);
+    if (!store_map) {
+        pthread_mutex_unlock(&store_mutex);
+        return -1;
+    }
+    uint64_t end = next_seq[tier];
+    pthread_mutex_unlock(&store_mutex);
+
+    uint64_t capacity = header->capacity[tier];
+    uint64_t lo = end > capacity ? end - capacity : 0, hi = end;
+
+    // from_ms 이상인 첫 레코드
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (record_time_ms(tier_record(tier, mid)) < from_ms) lo = mid + 1;
+        else hi = mid;
+    }
+
+    int count = 0;
+    for (uint64_t seq = lo; seq < end; seq++) {
+        const sensor_record_t* rec = tier_record(tier, seq);
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != (unsigned int)seq) continue;
+        if (record_time_ms(rec) > to_ms) break;
+        count++;
+        if (visit(rec, ctx) != 0) break;
+    }
+    return count;
+}
+
+// 점 개수가 max_points 이하이고 from_ms 까지 보존된 가장 세밀한 단계
+int sensor_store_pick_tier(long long from_ms, long long to_ms, int raw_period_ms, int max_points) {
+    pthread_mutex_lock(&store_mutex);
+    int tier = CDS_TIER_1H;
+
+    for (int t = CDS_TIER_RAW; t < CDS_TIER_1H && store_map; t++) {
+        long long period = t == CDS_TIER_RAW ? raw_period_ms : tier_period_ms[t];
+        if (period <= 0 || (to_ms - from_ms) / period > max_points) continue;
+
+        uint64_t end = next_seq[t], capacity = header->capacity[t];
+        if (end == 0) continue;
+        uint64_t oldest = end > capacity ? end - capacity : 0;
+        if (record_time_ms(tier_record(t, oldest)) > from_ms && end > capacity) continue;
+
+        tier = t;
+        break;
+    }
+
+    pthread_mutex_unlock(&store_mutex);
+    return tier;
+}
+
+const char* sensor_store_tier_name(int tier) {
+    return tier >= 0 && tier < CDS_TIER_COUNT ? tier_names[tier] : "?";
+}
+
+int sensor_store_stats(char* buf, int size) {
+    pthread_mutex_lock(&store_mutex);
+
+    if (!store_map) {
+        pthread_mutex_unlock(&store_mutex);
+        return snprintf(buf, size, "이력 저장소 닫힘");
+    }
+
+    int len = snprintf(buf, size, "이력 %zuKB", store_size / 1024);
+    for (int t = 0; t < CDS_TIER_COUNT && len < size; t++) {
+        uint64_t stored = next_seq[t] < header->capacity[t] ? next_seq[t] : header->capacity[t];
+        len += snprintf(buf + len, size - len, ", %s %llu/%u", tier_names[t],
+                        (unsigned long long)stored, header->capacity[t]);
+    }
+    if (len < size) {
+        len += snprintf(buf + len, size - len, ", 동기화 %lu회 (누적 %lluKB, 마지막 %llds 전)",
+                        flush_count, synced_bytes / 1024, (store_now_ms() - last_flush_ms) / 1000);
+    }
+
+    pthread_mutex_unlock(&store_mutex);
+    return len;
+}
+
+// 남은 기록을 반영하고 매핑 해제
+void sensor_store_close(void) {
+    pthread_mutex_lock(&store_mutex);
+
+    if (store_map) {
+        store_flush_locked();
+        munmap(store_map, store_size);
+        close(store_fd);
+        store_map = NULL;
+        header = NULL;
+        store_fd = -1;
+        printf("[HISTORY] 이력 저장소 닫기\n");
+    }
+
+    pthread_mutex_unlock(&store_mutex);
+}
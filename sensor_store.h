@@ -0,0 +1,28 @@
+#ifndef SENSOR_STORE_H
+#define SENSOR_STORE_H
+
+#include "control_device.h"
+
+// mmap 기반 조도 이력 저장소 (libcds 내부용)
+// 파일 하나에 단계별 원형 버퍼(raw/1s/1m/1h)와 이중화된 head 를 둔다
+
+int sensor_store_open(const char* path);
+void sensor_store_close(void);
+
+// 샘플 추가 (raw 기록 + 상위 단계 집계), 주기적으로 디스크에 반영
+// weight_ms: 샘플이 대표하는 시간, 상위 단계 평균은 이 시간으로 가중
+int sensor_store_append(long long ts_ms, int value, int weight_ms);
+
+// 기록한 레코드를 디스크에 반영한 뒤 head 갱신
+int sensor_store_flush(void);
+
+// [from_ms, to_ms] 구간 레코드를 오래된 순으로 visit 에 전달, 전달한 개수 반환
+int sensor_store_query(int tier, long long from_ms, long long to_ms, sensor_visit_fn visit, void* ctx);
+
+// 구간과 최대 점 개수에 맞는 가장 세밀한 단계 선택
+int sensor_store_pick_tier(long long from_ms, long long to_ms, int raw_period_ms, int max_points);
+
+const char* sensor_store_tier_name(int tier);
+int sensor_store_stats(char* buf, int size);
+
+#endif // SENSOR_STORE_H
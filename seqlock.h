@@ -0,0 +1,36 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <sched.h>
+
+// 상태 공개용 순번 잠금 (조도 샘플 링 버퍼와 같은 방식)
+// 쓰는 쪽은 장치 잠금으로 이미 한 명뿐이고, 읽는 쪽은 잠금 없이 복사한 뒤 순번이 그대로인지 확인
+// 쓰기 구간은 값 몇 개를 저장하는 동안뿐이라 읽는 쪽이 I/O 나 다른 요청을 기다리는 일이 없음
+//   do { seq = seqlock_read_begin(&lock); copy = published; } while (seqlock_read_retry(&lock, seq));
+
+typedef struct {
+    unsigned long seq;              // 홀수 = 쓰는 중
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t* lock) {
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqlock_write_end(seqlock_t* lock) {
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline unsigned long seqlock_read_begin(const seqlock_t* lock) {
+    unsigned long seq;
+    // 쓰는 스레드가 구간 중간에 밀려났으면 양보 (CPU 하나에서 헛돌지 않도록)
+    while ((seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE)) & 1) sched_yield();
+    return seq;
+}
+
+static inline int seqlock_read_retry(const seqlock_t* lock, unsigned long seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != seq;
+}
+
+#endif // SEQLOCK_H
@@ -0,0 +1,10 @@
+#ifndef SIM_SOFTTONE_H
+#define SIM_SOFTTONE_H
+
+// 모의 softTone (make SIM=1): 주파수 변경을 기록하고 실제 wiringPi 처럼 핀마다 비트뱅 스레드를 돌림
+
+int softToneCreate(int pin);
+void softToneStop(int pin);
+void softToneWrite(int pin, int freq);
+
+#endif // SIM_SOFTTONE_H
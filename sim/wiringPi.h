@@ -0,0 +1,31 @@
+#ifndef SIM_WIRINGPI_H
+#define SIM_WIRINGPI_H
+
+// 모의 wiringPi (make SIM=1): 장치 라이브러리가 쓰는 함수만, 실제 wiringPi 와 같은 선언
+
+#define INPUT 0
+#define OUTPUT 1
+#define PWM_OUTPUT 2
+#define GPIO_CLOCK 3
+
+#define LOW 0
+#define HIGH 1
+
+#define PWM_MODE_MS 0
+#define PWM_MODE_BAL 1
+
+int wiringPiSetupGpio(void);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void pwmWrite(int pin, int value);
+void pwmSetMode(int mode);
+void pwmSetRange(unsigned int range);
+void pwmSetClock(int divisor);
+
+void delay(unsigned int howLong);
+void delayMicroseconds(unsigned int howLong);
+unsigned int millis(void);
+unsigned int micros(void);
+
+#endif // SIM_WIRINGPI_H
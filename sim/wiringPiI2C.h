@@ -0,0 +1,13 @@
+#ifndef SIM_WIRINGPII2C_H
+#define SIM_WIRINGPII2C_H
+
+// 모의 wiringPi I2C (make SIM=1): PCF8591 ADC 를 흉내 냄
+
+int wiringPiI2CRead(int fd);
+int wiringPiI2CWrite(int fd, int data);
+int wiringPiI2CReadReg8(int fd, int reg);
+int wiringPiI2CWriteReg8(int fd, int reg, int data);
+int wiringPiI2CSetupInterface(const char* device, int devId);
+int wiringPiI2CSetup(const int devId);
+
+#endif // SIM_WIRINGPII2C_H
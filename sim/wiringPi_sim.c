@@ -0,0 +1,1008 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include "wiringPi.h"
+#include "wiringPiI2C.h"
+#include "softTone.h"
+#include "../dev_clock.h"
+
+// 모의 wiringPi: 라즈베리 파이 없이 장치 라이브러리를 실행/측정 (make SIM=1)
+// - 핀 변화는 단조 시계 시각과 함께 잠금 없는 원형 기록 버퍼에 남김
+// - I2C 는 PCF8591 ADC 로 동작, 값은 SIM_ADC_SCRIPT 파일로 지정
+// - 종료 시 SIM_REPORT 파일에 PWM 듀티, 카운트다운 틱, 멜로디 음 길이 통계 기록 (.json 이면 JSON)
+// - SIM_TRACE 파일에는 기록 버퍼 원본 (시각ns 핀 종류 값)
+// - softTone 은 실제 wiringPi 처럼 핀마다 비트뱅 스레드를 돌려 CPU 사용을 재현 (토글은 기록하지 않음)
+// - SIM_BUZZER_PWM=1 이면 libbuzzer pwm 백엔드용 PWM sysfs 를 SIM_PWM_CHIP 아래 보통 파일로 만듦
+// - SIM_VIRTUAL_TIME=1 이면 가상 시간: 대기 중인 스레드만 남아 조용해지면 가장 이른 데드라인으로 건너뜀
+//   (delay, dev_clock.h 를 거치는 장치 라이브러리/스케줄러/규칙 엔진의 대기와 시각이 모두 이 시계를 따름)
+
+#define SIM_TRACE_SIZE (1 << 17)        // 2의 거듭제곱, 넘치면 오래된 기록부터 덮어씀
+#define SIM_MAX_PINS 64
+#define SIM_ADC_CHANNELS 4
+#define SIM_ADC_DEFAULT 120             // 스크립트가 없을 때 채널 0 값
+#define SIM_MAX_ADC_POINTS 4096
+#define SIM_PWM_BASE_CLOCK 19200000     // BCM2835 PWM 기준 클럭 (Hz)
+#define SIM_SCAN_BYTES 5                // libcds 스캔 모드: 제어 바이트 쓰기 뒤 5바이트 읽기
+#define SIM_MAX_I2C 4                   // 동시에 열 수 있는 I2C 인터페이스 수
+#define SIM_TONE_MAX_FREQ 5000          // wiringPi softTone 상한 (Hz)
+#define SIM_PWM_CHANNELS 2              // 모의 PWM sysfs 채널 (pwm0, pwm1)
+#ifndef SIM_PWM_CHIP
+#define SIM_PWM_CHIP "/tmp/iot_sim_pwmchip0"   // Makefile 이 libbuzzer 의 BUZZER_PWM_CHIP 과 같은 값으로 지정
+#endif
+
+#define BURST_GAP_NS 2000000LL          // 이 안의 세그먼트 핀 변화는 한 번의 표시 갱신
+#define SEQUENCE_GAP_NS 2000000000LL    // 이보다 벌어지면 다른 카운트다운/멜로디
+#define TICK_NS 1000000000LL            // 카운트다운 1초
+#define NOTE_QUANTUM_NS 10000000LL      // 음 길이 기준값 단위 (10ms)
+
+#define VIRTUAL_QUIET_NS 200000LL       // 이만큼(실제 시간) 아무 대기/깨움이 없으면 시간을 진행 (SIM_VIRTUAL_QUIET_US)
+#define VIRTUAL_STUCK_FACTOR 50         // 깨운 스레드가 다시 잠들지 않을 때는 이 배수만큼 기다린 뒤 진행
+#define VIRTUAL_POLL_NS 10000000LL      // 조건 변수 대기자가 깨움을 놓쳤을 때를 대비한 실제 시간 확인 주기
+#define VIRTUAL_FIRE_BATCH 64
+
+enum { TRACE_MODE, TRACE_DIGITAL, TRACE_PWM, TRACE_TONE };
+static const char* trace_kind_names[] = {"mode", "digital", "pwm", "tone"};
+
+typedef struct {
+    long long ts_ns;
+    unsigned int seq;                   // 기록 번호 + 1, 0 이면 쓰는 중
+    int pin;
+    int kind;
+    int value;
+} trace_entry_t;
+
+typedef struct {
+    long long ms;
+    int ch[SIM_ADC_CHANNELS];
+} adc_point_t;
+
+typedef struct {
+    int n;
+    double mean, p50, p99, max;
+} sim_stat_t;
+
+// 가상 시간 대기자 (대기하는 스레드의 스택에 있음), 데드라인 순 목록
+typedef struct sim_sleeper {
+    long long deadline;                 // 가상 CLOCK_MONOTONIC ns
+    pthread_cond_t* cond;               // dev_cond_timedwait 의 조건 변수, NULL 이면 wake 로 깨움
+    pthread_cond_t wake;
+    int fired;
+    int generation;
+    struct sim_sleeper* next;
+} sim_sleeper_t;
+
+// 이 프로젝트의 배선 (control_device.h / 각 라이브러리의 핀 정의)
+static const struct { int pin; const char* name; } pin_names[] = {
+    {18, "LED"}, {17, "AUTO_LED"}, {19, "BUZZER"},
+    {16, "FND_A"}, {20, "FND_B"}, {21, "FND_C"}, {12, "FND_D"},
+};
+static const int segment_pins[] = {16, 20, 21, 12};
+#define BUZZER_PIN 19
+
+static trace_entry_t trace[SIM_TRACE_SIZE];
+static unsigned int trace_head;
+static int pin_value[SIM_MAX_PINS];
+static unsigned long pin_writes[SIM_MAX_PINS];
+static unsigned long pwm_clamped;
+static int pwm_range = 1024;
+static int pwm_clock = 32;
+static int pwm_mode = PWM_MODE_BAL;
+static long long start_ns;
+
+static int virtual_time;
+static long long virtual_now;           // 가상 단조 시각 (ns)
+static long long realtime_offset;       // CLOCK_REALTIME - CLOCK_MONOTONIC (시작 시)
+static long long virtual_quiet_ns = VIRTUAL_QUIET_NS;
+static pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t advance_cond;
+static sim_sleeper_t* sleepers;
+static int awake;                       // 깨운 뒤 아직 다시 대기에 들어가지 않은 스레드 수
+static int awake_generation = 1;        // 돌아오지 않는 스레드를 포기할 때마다 증가
+static __thread int thread_generation;  // 이 스레드를 깨운 세대 (0 이면 셈에 없음)
+static long long last_activity;         // 마지막 대기/깨움의 실제 시각
+static pthread_t advance_tid;
+static int advance_running;
+static unsigned long virtual_jumps;
+
+static adc_point_t adc_points[SIM_MAX_ADC_POINTS];
+static int adc_point_count;
+static int adc_noise;
+static unsigned int adc_seed = 12345;
+static pthread_mutex_t adc_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int adc_control;                 // 마지막 제어 바이트 (하위 2비트 채널, 0x04 자동 증가)
+static int adc_previous = 0x80;         // 다음 읽기에 나갈 이전 변환 결과 (전원 인가 시 0x80)
+static struct { pthread_t tid; int fd; } i2c_devices[SIM_MAX_I2C];
+static int i2c_device_count;
+
+static long long timespec_ns(const struct timespec* ts) {
+    return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static void ns_timespec(long long ns, struct timespec* ts) {
+    ts->tv_sec = ns / 1000000000LL;
+    ts->tv_nsec = ns % 1000000000LL;
+}
+
+static long long real_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_ns(&ts);
+}
+
+// 기록 시각, millis(), ADC 스크립트가 쓰는 단조 시각 (가상 시간이면 가상 시각)
+static long long now_ns(void) {
+    return virtual_time ? __atomic_load_n(&virtual_now, __ATOMIC_ACQUIRE) : real_ns();
+}
+
+// 기록 추가: 칸은 fetch_add 로 잡고, seq 를 마지막에 release 로 써서 완성을 알림
+static void trace_record(int pin, int kind, int value) {
+    long long ts = now_ns() - start_ns;
+    unsigned int idx = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    trace_entry_t* e = &trace[idx & (SIM_TRACE_SIZE - 1)];
+
+    __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&e->ts_ns, ts, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->pin, pin, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->kind, kind, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->value, value, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->seq, idx + 1, __ATOMIC_RELEASE);
+}
+
+// 값이 바뀐 경우만 기록
+static void pin_update(int pin, int kind, int value) {
+    if (pin < 0 || pin >= SIM_MAX_PINS) return;
+    __atomic_fetch_add(&pin_writes[pin], 1, __ATOMIC_RELAXED);
+    int encoded = kind << 24 | (value & 0xffffff);
+    if (__atomic_exchange_n(&pin_value[pin], encoded, __ATOMIC_RELAXED) != encoded) {
+        trace_record(pin, kind, value);
+    }
+}
+
+// ===== GPIO / PWM =====
+
+int wiringPiSetupGpio(void) {
+    return 0;
+}
+
+void pinMode(int pin, int mode) {
+    if (pin < 0 || pin >= SIM_MAX_PINS) return;
+    trace_record(pin, TRACE_MODE, mode);
+}
+
+void digitalWrite(int pin, int value) {
+    pin_update(pin, TRACE_DIGITAL, value ? HIGH : LOW);
+}
+
+int digitalRead(int pin) {
+    if (pin < 0 || pin >= SIM_MAX_PINS) return LOW;
+    return __atomic_load_n(&pin_value[pin], __ATOMIC_RELAXED) & 0xffffff ? HIGH : LOW;
+}
+
+void pwmWrite(int pin, int value) {
+    int range = __atomic_load_n(&pwm_range, __ATOMIC_RELAXED);
+    if (value < 0 || value > range) {
+        __atomic_fetch_add(&pwm_clamped, 1, __ATOMIC_RELAXED);
+        value = value < 0 ? 0 : range;
+    }
+    pin_update(pin, TRACE_PWM, value);
+}
+
+void pwmSetMode(int mode) {
+    __atomic_store_n(&pwm_mode, mode, __ATOMIC_RELAXED);
+}
+
+void pwmSetRange(unsigned int range) {
+    if (range > 0) __atomic_store_n(&pwm_range, (int)range, __ATOMIC_RELAXED);
+}
+
+void pwmSetClock(int divisor) {
+    if (divisor > 0) __atomic_store_n(&pwm_clock, divisor, __ATOMIC_RELAXED);
+}
+
+// ===== 시간 =====
+
+void delay(unsigned int howLong) {
+    delayMicroseconds(howLong * 1000U);
+}
+
+void delayMicroseconds(unsigned int howLong) {
+    struct timespec deadline;
+    ns_timespec(now_ns() + howLong * 1000LL, &deadline);
+    sim_clock_sleep_until(CLOCK_MONOTONIC, &deadline);
+}
+
+unsigned int millis(void) {
+    return (unsigned int)((now_ns() - start_ns) / 1000000LL);
+}
+
+unsigned int micros(void) {
+    return (unsigned int)((now_ns() - start_ns) / 1000LL);
+}
+
+// ===== 시계 (dev_clock.h) =====
+
+// 데드라인 순으로 끼워 넣고 진행 스레드에 알림, clock_mutex 보유 상태
+static void sleeper_insert_locked(sim_sleeper_t* s) {
+    sim_sleeper_t** link = &sleepers;
+    while (*link && (*link)->deadline <= s->deadline) link = &(*link)->next;
+    s->next = *link;
+    *link = s;
+    last_activity = real_ns();
+    pthread_cond_signal(&advance_cond);
+}
+
+static void sleeper_remove_locked(sim_sleeper_t* s) {
+    for (sim_sleeper_t** link = &sleepers; *link; link = &(*link)->next) {
+        if (*link == s) {
+            *link = s->next;
+            return;
+        }
+    }
+}
+
+// 깨어나 일하던 스레드가 다시 대기에 들어감, clock_mutex 보유 상태
+static void thread_idle_locked(void) {
+    if (thread_generation == awake_generation) awake--;
+    thread_generation = 0;
+}
+
+static void sleep_cancelled(void* arg) {
+    sim_sleeper_t* s = arg;
+    if (!s->fired) sleeper_remove_locked(s);
+    pthread_mutex_unlock(&clock_mutex);
+}
+
+static void cond_wait_cancelled(void* arg) {
+    pthread_mutex_lock(&clock_mutex);
+    sleep_cancelled(arg);
+}
+
+static long long virtual_deadline(clockid_t clock, const struct timespec* deadline) {
+    return clock == CLOCK_REALTIME ? timespec_ns(deadline) - realtime_offset : timespec_ns(deadline);
+}
+
+int sim_clock_gettime(clockid_t clock, struct timespec* ts) {
+    if (!virtual_time || (clock != CLOCK_MONOTONIC && clock != CLOCK_REALTIME)) return clock_gettime(clock, ts);
+    long long now = __atomic_load_n(&virtual_now, __ATOMIC_ACQUIRE);
+    ns_timespec(clock == CLOCK_REALTIME ? now + realtime_offset : now, ts);
+    return 0;
+}
+
+int sim_clock_sleep_until(clockid_t clock, const struct timespec* deadline) {
+    if (!virtual_time) {
+        int ret;
+        while ((ret = clock_nanosleep(clock, TIMER_ABSTIME, deadline, NULL)) == EINTR) {
+        }
+        return ret;
+    }
+
+    sim_sleeper_t s;
+    int old_type;
+    memset(&s, 0, sizeof(s));
+    s.deadline = virtual_deadline(clock, deadline);
+    pthread_cond_init(&s.wake, NULL);
+
+    // 비동기 취소(libsegment 자동 꺼짐 스레드)는 대기 지점에서만 받도록 잠시 지연 취소로 전환
+    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &old_type);
+    pthread_mutex_lock(&clock_mutex);
+    if (s.deadline > virtual_now) {
+        thread_idle_locked();
+        sleeper_insert_locked(&s);
+        pthread_cleanup_push(sleep_cancelled, &s);
+        while (!s.fired) pthread_cond_wait(&s.wake, &clock_mutex);
+        pthread_cleanup_pop(0);
+        thread_generation = s.generation;
+    }
+    pthread_mutex_unlock(&clock_mutex);
+    pthread_setcanceltype(old_type, NULL);
+    pthread_cond_destroy(&s.wake);
+    return 0;
+}
+
+// 진행 스레드는 사용자 뮤텍스 없이 broadcast 하므로 (잡으면 교착 가능) 놓친 깨움에 대비해 실제 시간으로 나눠 대기
+int sim_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* deadline) {
+    if (!virtual_time) return pthread_cond_timedwait(cond, mutex, deadline);
+
+    sim_sleeper_t s;
+    int ret;
+    memset(&s, 0, sizeof(s));
+    s.deadline = virtual_deadline(CLOCK_MONOTONIC, deadline);
+    s.cond = cond;
+
+    pthread_mutex_lock(&clock_mutex);
+    if (s.deadline <= virtual_now) {
+        pthread_mutex_unlock(&clock_mutex);
+        return ETIMEDOUT;
+    }
+    thread_idle_locked();
+    sleeper_insert_locked(&s);
+    pthread_mutex_unlock(&clock_mutex);
+
+    pthread_cleanup_push(cond_wait_cancelled, &s);
+    for (;;) {
+        struct timespec poll;
+        ns_timespec(real_ns() + VIRTUAL_POLL_NS, &poll);
+        ret = pthread_cond_timedwait(cond, mutex, &poll);
+        pthread_mutex_lock(&clock_mutex);
+        if (s.fired) {
+            thread_generation = s.generation;
+            ret = ETIMEDOUT;
+            break;
+        }
+        if (ret != ETIMEDOUT) {
+            // 실제 신호: 처리하는 동안 시간이 흐르지 않도록 깨어 있는 스레드로 셈
+            sleeper_remove_locked(&s);
+            awake++;
+            thread_generation = awake_generation;
+            last_activity = real_ns();
+            ret = 0;
+            break;
+        }
+        pthread_mutex_unlock(&clock_mutex);
+    }
+    pthread_mutex_unlock(&clock_mutex);
+    pthread_cleanup_pop(0);
+    return ret;
+}
+
+// 진행 스레드: 깨운 스레드가 모두 다시 대기에 들어가고 조용해지면 가장 이른 데드라인으로 이동해 깨움
+static void* clock_advance_thread(void* arg) {
+    pthread_cond_t* conds[VIRTUAL_FIRE_BATCH];
+    (void)arg;
+
+    pthread_mutex_lock(&clock_mutex);
+    while (advance_running) {
+        long long quiet = real_ns() - last_activity;
+        long long need = awake > 0 ? virtual_quiet_ns * VIRTUAL_STUCK_FACTOR : virtual_quiet_ns;
+        if (!sleepers || quiet < need) {
+            struct timespec until;
+            ns_timespec(real_ns() + (sleepers ? need - quiet : VIRTUAL_POLL_NS), &until);
+            pthread_cond_timedwait(&advance_cond, &clock_mutex, &until);
+            continue;
+        }
+
+        // 다른 곳(시간 제한 없는 대기)에서 멈춘 스레드는 셈에서 뺌
+        if (awake > 0) {
+            awake_generation++;
+            awake = 0;
+        }
+        if (sleepers->deadline > virtual_now) {
+            __atomic_store_n(&virtual_now, sleepers->deadline, __ATOMIC_RELEASE);
+            virtual_jumps++;
+        }
+
+        int nconds = 0;
+        while (sleepers && sleepers->deadline <= virtual_now && nconds < VIRTUAL_FIRE_BATCH) {
+            sim_sleeper_t* s = sleepers;
+            sleepers = s->next;
+            s->fired = 1;
+            s->generation = awake_generation;
+            awake++;
+            if (s->cond) {
+                conds[nconds++] = s->cond;   // s 는 깨어난 스레드가 곧 버리므로 조건 변수만 보관
+            } else {
+                pthread_cond_signal(&s->wake);
+            }
+        }
+        last_activity = real_ns();
+
+        pthread_mutex_unlock(&clock_mutex);
+        for (int i = 0; i < nconds; i++) pthread_cond_broadcast(conds[i]);
+        pthread_mutex_lock(&clock_mutex);
+    }
+    pthread_mutex_unlock(&clock_mutex);
+    return NULL;
+}
+
+static void virtual_time_start(void) {
+    const char* quiet = getenv("SIM_VIRTUAL_QUIET_US");
+    pthread_condattr_t attr;
+    struct timespec wall;
+
+    clock_gettime(CLOCK_REALTIME, &wall);
+    virtual_now = start_ns;
+    realtime_offset = timespec_ns(&wall) - start_ns;
+    if (quiet && atoi(quiet) > 0) virtual_quiet_ns = atoi(quiet) * 1000LL;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&advance_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    last_activity = real_ns();
+    advance_running = 1;
+    if (pthread_create(&advance_tid, NULL, clock_advance_thread, NULL) != 0) {
+        fprintf(stderr, "[SIM] 가상 시간 스레드 생성 실패, 실제 시간 사용\n");
+        advance_running = 0;
+        return;
+    }
+    virtual_time = 1;
+}
+
+static void virtual_time_stop(void) {
+    if (!advance_running) return;
+    pthread_mutex_lock(&clock_mutex);
+    advance_running = 0;
+    pthread_cond_signal(&advance_cond);
+    pthread_mutex_unlock(&clock_mutex);
+    pthread_join(advance_tid, NULL);
+}
+
+// ===== softTone: 음 높이 변경은 같은 값이어도 모두 기록 (같은 음이 이어지는 멜로디) =====
+// 비트뱅 스레드는 wiringPi softTone.c 와 같은 주기로 깨어남 (반주기마다 토글, 무음이면 1ms 마다 확인)
+// 가상 시간과 무관하게 실제 시간으로 자므로 BUZZER_BACKEND 의 CPU 사용률을 실제 장비와 같은 방식으로 비교할 수 있음
+
+static struct {
+    pthread_t tid;
+    int active;
+    int freq;
+    int level;
+} tone_threads[SIM_MAX_PINS];
+
+// wiringPi delayMicroseconds 와 같음: 100us 미만은 바쁜 대기, 그 이상은 nanosleep
+static void tone_delay_us(unsigned int us) {
+    if (us < 100) {
+        long long end = real_ns() + us * 1000LL;
+        while (real_ns() < end) pthread_testcancel();
+        return;
+    }
+    struct timespec ts = {us / 1000000, (us % 1000000) * 1000L};
+    nanosleep(&ts, NULL);
+}
+
+static void* tone_thread(void* arg) {
+    int pin = (int)(long)arg;
+
+    for (;;) {
+        int freq = __atomic_load_n(&tone_threads[pin].freq, __ATOMIC_RELAXED);
+        if (freq == 0) {
+            tone_delay_us(1000);
+            continue;
+        }
+        unsigned int half_us = 500000 / freq;
+        __atomic_store_n(&tone_threads[pin].level, HIGH, __ATOMIC_RELAXED);
+        tone_delay_us(half_us);
+        __atomic_store_n(&tone_threads[pin].level, LOW, __ATOMIC_RELAXED);
+        tone_delay_us(half_us);
+    }
+    return NULL;
+}
+
+int softToneCreate(int pin) {
+    if (pin < 0 || pin >= SIM_MAX_PINS) return -1;
+    pinMode(pin, OUTPUT);
+    if (tone_threads[pin].active) return -1;   // wiringPi 와 같이 이미 있으면 실패
+
+    tone_threads[pin].freq = 0;
+    if (pthread_create(&tone_threads[pin].tid, NULL, tone_thread, (void*)(long)pin) != 0) return -1;
+    tone_threads[pin].active = 1;
+    return 0;
+}
+
+void softToneWrite(int pin, int freq) {
+    if (pin < 0 || pin >= SIM_MAX_PINS) return;
+    __atomic_store_n(&tone_threads[pin].freq, freq < 0 ? 0 : freq > SIM_TONE_MAX_FREQ ? SIM_TONE_MAX_FREQ : freq,
+                     __ATOMIC_RELAXED);
+    __atomic_fetch_add(&pin_writes[pin], 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&pin_value[pin], TRACE_TONE << 24 | (freq & 0xffffff), __ATOMIC_RELAXED);
+    trace_record(pin, TRACE_TONE, freq < 0 ? 0 : freq);
+}
+
+void softToneStop(int pin) {
+    if (pin < 0 || pin >= SIM_MAX_PINS) return;
+    if (tone_threads[pin].active) {
+        pthread_cancel(tone_threads[pin].tid);
+        pthread_join(tone_threads[pin].tid, NULL);
+        tone_threads[pin].active = 0;
+    }
+    pin_update(pin, TRACE_DIGITAL, LOW);
+}
+
+// ===== PWM sysfs (SIM_BUZZER_PWM=1) =====
+// libbuzzer pwm 백엔드가 여는 period/duty_cycle/enable 을 보통 파일로 만듦 (쓴 값은 기록하지 않음)
+// 켜지 않은 실행에서는 이전 실행이 남긴 파일을 지워 기본 softtone 백엔드(톤 기록, 멜로디 보고서)를 유지
+
+static void pwm_sysfs_setup(int enable) {
+    static const char* const attrs[] = {"period", "duty_cycle", "enable"};
+    char path[160];
+
+    if (enable) mkdir(SIM_PWM_CHIP, 0755);
+    for (int ch = 0; ch < SIM_PWM_CHANNELS; ch++) {
+        snprintf(path, sizeof(path), SIM_PWM_CHIP "/pwm%d", ch);
+        if (enable) mkdir(path, 0755);
+        for (int i = 0; i < 3; i++) {
+            snprintf(path, sizeof(path), SIM_PWM_CHIP "/pwm%d/%s", ch, attrs[i]);
+            if (enable) {
+                FILE* fp = fopen(path, "w");
+                if (fp) fclose(fp);
+            } else {
+                unlink(path);
+            }
+        }
+        if (!enable) {
+            snprintf(path, sizeof(path), SIM_PWM_CHIP "/pwm%d", ch);
+            rmdir(path);
+        }
+    }
+    if (!enable) rmdir(SIM_PWM_CHIP);
+}
+
+// ===== I2C: PCF8591 =====
+
+// 스크립트 값 (시작 후 경과 시간으로 선형 보간, 마지막 값 유지) + 잡음
+static int adc_sample(int ch) {
+    long long ms = (now_ns() - start_ns) / 1000000LL;
+    int value;
+
+    if (adc_point_count == 0) {
+        value = ch == 0 ? SIM_ADC_DEFAULT : 0;
+    } else if (ms <= adc_points[0].ms) {
+        value = adc_points[0].ch[ch];
+    } else {
+        int i = 1;
+        while (i < adc_point_count && adc_points[i].ms < ms) i++;
+        if (i == adc_point_count) {
+            value = adc_points[i - 1].ch[ch];
+        } else {
+            const adc_point_t* a = &adc_points[i - 1];
+            const adc_point_t* b = &adc_points[i];
+            value = a->ch[ch] + (int)((b->ch[ch] - a->ch[ch]) * (ms - a->ms) / (b->ms - a->ms));
+        }
+    }
+    if (adc_noise > 0) value += (int)(rand_r(&adc_seed) % (2 * adc_noise + 1)) - adc_noise;
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+// 읽기 한 번: 이전 변환 결과를 내보내고 현재 채널을 새로 변환 (자동 증가면 채널 이동), adc_mutex 보유 상태
+static int adc_read_locked(void) {
+    int result = adc_previous;
+    int ch = adc_control & 0x03;
+    adc_previous = adc_sample(ch);
+    if (adc_control & 0x04) adc_control = (adc_control & ~0x03) | ((ch + 1) & 0x03);
+    return result;
+}
+
+int wiringPiI2CRead(int fd) {
+    (void)fd;
+    pthread_mutex_lock(&adc_mutex);
+    int value = adc_read_locked();
+    pthread_mutex_unlock(&adc_mutex);
+    return value;
+}
+
+int wiringPiI2CWrite(int fd, int data) {
+    (void)fd;
+    pthread_mutex_lock(&adc_mutex);
+    adc_control = data & 0xff;
+    pthread_mutex_unlock(&adc_mutex);
+    return 0;
+}
+
+int wiringPiI2CReadReg8(int fd, int reg) {
+    wiringPiI2CWrite(fd, reg);
+    return wiringPiI2CRead(fd);
+}
+
+int wiringPiI2CWriteReg8(int fd, int reg, int data) {
+    (void)data;
+    return wiringPiI2CWrite(fd, reg);
+}
+
+// 파일 기술자로 직접 하는 write()/read() 용: socketpair 반대편에서 제어 바이트를 받아 5바이트로 응답
+// (ioctl(I2C_RDWR) 은 소켓이라 실패하므로 libcds 는 쓰기 + 블록 읽기 대체 경로를 탐)
+static void* i2c_device_thread(void* arg) {
+    int fd = (int)(long)arg;
+    unsigned char in[16], out[SIM_SCAN_BYTES];
+
+    for (;;) {
+        ssize_t n = recv(fd, in, sizeof(in), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        pthread_mutex_lock(&adc_mutex);
+        adc_control = in[n - 1];
+        for (int i = 0; i < SIM_SCAN_BYTES; i++) out[i] = (unsigned char)adc_read_locked();
+        pthread_mutex_unlock(&adc_mutex);
+        if (send(fd, out, sizeof(out), MSG_NOSIGNAL) < 0) break;
+    }
+    return NULL;
+}
+
+int wiringPiI2CSetupInterface(const char* device, int devId) {
+    int fds[2];
+    (void)device;
+    (void)devId;
+
+    pthread_mutex_lock(&adc_mutex);
+    if (i2c_device_count == SIM_MAX_I2C || socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        pthread_mutex_unlock(&adc_mutex);
+        return -1;
+    }
+    if (pthread_create(&i2c_devices[i2c_device_count].tid, NULL, i2c_device_thread, (void*)(long)fds[1]) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        pthread_mutex_unlock(&adc_mutex);
+        return -1;
+    }
+    i2c_devices[i2c_device_count++].fd = fds[1];
+    pthread_mutex_unlock(&adc_mutex);
+    return fds[0];
+}
+
+int wiringPiI2CSetup(const int devId) {
+    return wiringPiI2CSetupInterface("/dev/i2c-1", devId);
+}
+
+// 스크립트 형식: 한 줄에 "<시작 후 ms> <채널0> [채널1 채널2 채널3]", # 주석, 시간 순
+static void adc_load_script(const char* path) {
+    FILE* fp = fopen(path, "r");
+    char line[256];
+
+    if (!fp) {
+        fprintf(stderr, "[SIM] ADC 스크립트 열기 실패: %s\n", path);
+        return;
+    }
+    while (fgets(line, sizeof(line), fp) && adc_point_count < SIM_MAX_ADC_POINTS) {
+        adc_point_t p = {0, {0, 0, 0, 0}};
+        if (line[0] == '#') continue;
+        int fields = sscanf(line, "%lld %d %d %d %d", &p.ms, &p.ch[0], &p.ch[1], &p.ch[2], &p.ch[3]);
+        if (fields < 2) continue;
+        if (adc_point_count > 0 && p.ms <= adc_points[adc_point_count - 1].ms) {
+            fprintf(stderr, "[SIM] ADC 스크립트 시간 역순 무시: %s", line);
+            continue;
+        }
+        adc_points[adc_point_count++] = p;
+    }
+    fclose(fp);
+}
+
+// ===== 통계 =====
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int compare_entry(const void* a, const void* b) {
+    const trace_entry_t* x = a;
+    const trace_entry_t* y = b;
+    if (x->ts_ns != y->ts_ns) return x->ts_ns < y->ts_ns ? -1 : 1;
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+// values 를 정렬한 뒤 요약
+static sim_stat_t stat_of(double* values, int n) {
+    sim_stat_t s = {n, 0, 0, 0, 0};
+    if (n == 0) return s;
+    qsort(values, n, sizeof(double), compare_double);
+    for (int i = 0; i < n; i++) s.mean += values[i];
+    s.mean /= n;
+    s.p50 = values[(n - 1) / 2];
+    s.p99 = values[(int)((n - 1) * 0.99)];
+    s.max = values[n - 1];
+    return s;
+}
+
+// 완성된 기록만 시각 순으로 복사 (덮어써진 칸과 쓰는 중인 칸은 제외)
+static trace_entry_t* trace_snapshot(int* count, unsigned long* dropped) {
+    unsigned int head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    unsigned int first = head > SIM_TRACE_SIZE ? head - SIM_TRACE_SIZE : 0;
+    trace_entry_t* out = malloc(sizeof(trace_entry_t) * (head - first + 1));
+    int n = 0;
+
+    if (!out) return NULL;
+    for (unsigned int idx = first; idx < head; idx++) {
+        trace_entry_t* e = &trace[idx & (SIM_TRACE_SIZE - 1)];
+        if (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != idx + 1) continue;
+        trace_entry_t copy = {__atomic_load_n(&e->ts_ns, __ATOMIC_RELAXED), idx + 1,
+                              __atomic_load_n(&e->pin, __ATOMIC_RELAXED), __atomic_load_n(&e->kind, __ATOMIC_RELAXED),
+                              __atomic_load_n(&e->value, __ATOMIC_RELAXED)};
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != idx + 1) continue;
+        out[n++] = copy;
+    }
+    qsort(out, n, sizeof(trace_entry_t), compare_entry);
+    *count = n;
+    *dropped = first;
+    return out;
+}
+
+static const char* pin_name(int pin) {
+    for (size_t i = 0; i < sizeof(pin_names) / sizeof(pin_names[0]); i++) {
+        if (pin_names[i].pin == pin) return pin_names[i].name;
+    }
+    return "-";
+}
+
+static int is_segment_pin(int pin) {
+    for (size_t i = 0; i < sizeof(segment_pins) / sizeof(segment_pins[0]); i++) {
+        if (segment_pins[i] == pin) return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    int pin;
+    unsigned long updates;
+    sim_stat_t interval_ms;             // 갱신 간격 중앙값 대비 편차
+    double median_interval_ms;
+    double duty_time_pct;               // 시간 가중 평균 듀티
+    double duty_sample_pct;             // 쓴 값의 단순 평균 듀티
+} pwm_report_t;
+
+// PWM 듀티 정확도: 갱신 간격이 고르지 않으면 시간 가중 평균이 의도한(단순) 평균에서 벗어남
+static int analyze_pwm(const trace_entry_t* entries, int n, int pin, pwm_report_t* r) {
+    double* intervals = malloc(sizeof(double) * (n + 1));
+    long long prev_ts = -1;
+    int prev_value = 0, count = 0;
+    double weighted = 0, sampled = 0;
+    long long span = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->pin = pin;
+    if (!intervals) return -1;
+    for (int i = 0; i < n; i++) {
+        if (entries[i].pin != pin || entries[i].kind != TRACE_PWM) continue;
+        if (prev_ts >= 0) {
+            intervals[count++] = (entries[i].ts_ns - prev_ts) / 1e6;
+            weighted += (double)prev_value * (entries[i].ts_ns - prev_ts);
+            span += entries[i].ts_ns - prev_ts;
+            sampled += prev_value;
+        }
+        prev_ts = entries[i].ts_ns;
+        prev_value = entries[i].value;
+        r->updates++;
+    }
+    if (count > 0) {
+        r->duty_time_pct = 100.0 * weighted / span / pwm_range;
+        r->duty_sample_pct = 100.0 * sampled / count / pwm_range;
+        sim_stat_t raw = stat_of(intervals, count);
+        r->median_interval_ms = raw.p50;
+        for (int i = 0; i < count; i++) {
+            double dev = intervals[i] - raw.p50;
+            intervals[i] = dev < 0 ? -dev : dev;
+        }
+        r->interval_ms = stat_of(intervals, count);
+    }
+    free(intervals);
+    return 0;
+}
+
+typedef struct {
+    int sequences;
+    sim_stat_t jitter_ms;               // |틱 간격 - 1000ms|
+    double worst_drift_ms;              // 한 카운트다운 동안 누적된 지연 중 최대
+} tick_report_t;
+
+// 카운트다운 틱: 세그먼트 핀 변화를 2ms 안에서 묶어 한 번의 표시 갱신으로 보고 간격을 1초와 비교
+static void analyze_ticks(const trace_entry_t* entries, int n, tick_report_t* r) {
+    double* jitter = malloc(sizeof(double) * (n + 1));
+    long long burst = -1, seq_start = -1, seq_last = -1;
+    int count = 0, seq_ticks = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (!jitter) return;
+    for (int i = 0; i <= n; i++) {
+        long long ts = -1;
+        if (i < n) {
+            if (entries[i].kind != TRACE_DIGITAL || !is_segment_pin(entries[i].pin)) continue;
+            ts = entries[i].ts_ns;
+            if (burst >= 0 && ts - burst < BURST_GAP_NS) continue;
+            burst = ts;
+        }
+        // 이전 갱신과 0.5~1.5초 떨어져 있으면 같은 카운트다운의 다음 틱
+        long long gap = seq_last >= 0 && ts >= 0 ? ts - seq_last : -1;
+        if (gap >= TICK_NS / 2 && gap <= TICK_NS * 3 / 2) {
+            double dev = (gap - TICK_NS) / 1e6;
+            jitter[count++] = dev < 0 ? -dev : dev;
+            seq_ticks++;
+        } else {
+            if (seq_ticks > 0) {
+                double drift = (seq_last - seq_start - seq_ticks * TICK_NS) / 1e6;
+                if (drift > r->worst_drift_ms) r->worst_drift_ms = drift;
+                r->sequences++;
+            }
+            seq_start = ts;
+            seq_ticks = 0;
+        }
+        seq_last = ts;
+    }
+    r->jitter_ms = stat_of(jitter, count);
+    free(jitter);
+}
+
+typedef struct {
+    int melodies;
+    sim_stat_t deviation_ms;            // |음 시작 간격 - 10ms 단위로 반올림한 기준값|
+    double worst_drift_ms;              // 한 멜로디 동안 누적된 편차 중 최대
+} melody_report_t;
+
+// 멜로디 음 길이: 부저 핀 softToneWrite(>0) 사이 간격, 음 길이는 10ms 배수라고 보고 가장 가까운 배수와 비교
+static void analyze_melody(const trace_entry_t* entries, int n, melody_report_t* r) {
+    double* deviation = malloc(sizeof(double) * (n + 1));
+    long long prev = -1;
+    double drift = 0;
+    int count = 0, notes = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (!deviation) return;
+    for (int i = 0; i <= n; i++) {
+        long long ts = -1;
+        if (i < n) {
+            if (entries[i].pin != BUZZER_PIN || entries[i].kind != TRACE_TONE || entries[i].value <= 0) continue;
+            ts = entries[i].ts_ns;
+        }
+        long long gap = prev >= 0 && ts >= 0 ? ts - prev : -1;
+        if (gap >= 0 && gap < SEQUENCE_GAP_NS) {
+            long long nominal = (gap + NOTE_QUANTUM_NS / 2) / NOTE_QUANTUM_NS * NOTE_QUANTUM_NS;
+            double dev = (gap - nominal) / 1e6;
+            drift += dev;
+            deviation[count++] = dev < 0 ? -dev : dev;
+            notes++;
+        } else {
+            if (notes > 0) {
+                if (drift > r->worst_drift_ms) r->worst_drift_ms = drift;
+                r->melodies++;
+            }
+            drift = 0;
+            notes = 0;
+        }
+        prev = ts;
+    }
+    r->deviation_ms = stat_of(deviation, count);
+    free(deviation);
+}
+
+static void print_stat_json(FILE* fp, const char* name, const sim_stat_t* s) {
+    fprintf(fp, "\"%s\": {\"n\": %d, \"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}", name, s->n,
+            s->mean, s->p50, s->p99, s->max);
+}
+
+static void write_report(const char* path) {
+    int n = 0;
+    unsigned long dropped = 0;
+    trace_entry_t* entries = trace_snapshot(&n, &dropped);
+    pwm_report_t pwm[SIM_MAX_PINS];
+    int pwm_count = 0;
+    tick_report_t ticks;
+    melody_report_t melody;
+    FILE* fp;
+
+    if (!entries) return;
+    for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+        for (int i = 0; i < n; i++) {
+            if (entries[i].pin == pin && entries[i].kind == TRACE_PWM) {
+                analyze_pwm(entries, n, pin, &pwm[pwm_count++]);
+                break;
+            }
+        }
+    }
+    analyze_ticks(entries, n, &ticks);
+    analyze_melody(entries, n, &melody);
+
+    if (!(fp = fopen(path, "w"))) {
+        fprintf(stderr, "[SIM] 보고서 쓰기 실패: %s\n", path);
+        free(entries);
+        return;
+    }
+    double carrier = pwm_mode == PWM_MODE_MS ? (double)SIM_PWM_BASE_CLOCK / pwm_clock / pwm_range : 0;
+    size_t len = strlen(path);
+
+    if (len > 5 && strcmp(path + len - 5, ".json") == 0) {
+        fprintf(fp, "{\"records\": %d, \"dropped\": %lu, \"pwm_clamped\": %lu, \"pwm_carrier_hz\": %.1f,\n", n,
+                dropped, pwm_clamped, carrier);
+        fprintf(fp, " \"virtual_time\": %d, \"elapsed_s\": %.3f, \"real_elapsed_s\": %.3f, \"virtual_jumps\": %lu,\n",
+                virtual_time, (now_ns() - start_ns) / 1e9, (real_ns() - start_ns) / 1e9, virtual_jumps);
+        fprintf(fp, " \"pins\": [");
+        int first = 1;
+        for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+            if (pin_writes[pin] == 0) continue;
+            fprintf(fp, "%s{\"pin\": %d, \"name\": \"%s\", \"writes\": %lu}", first ? "" : ", ", pin, pin_name(pin),
+                    pin_writes[pin]);
+            first = 0;
+        }
+        fprintf(fp, "],\n \"pwm\": [");
+        for (int i = 0; i < pwm_count; i++) {
+            fprintf(fp, "%s{\"pin\": %d, \"updates\": %lu, \"median_interval_ms\": %.3f, ", i ? ", " : "",
+                    pwm[i].pin, pwm[i].updates, pwm[i].median_interval_ms);
+            print_stat_json(fp, "interval_dev_ms", &pwm[i].interval_ms);
+            fprintf(fp, ", \"duty_time_pct\": %.3f, \"duty_sample_pct\": %.3f, \"duty_error_pct\": %.3f}",
+                    pwm[i].duty_time_pct, pwm[i].duty_sample_pct, pwm[i].duty_time_pct - pwm[i].duty_sample_pct);
+        }
+        fprintf(fp, "],\n \"countdown\": {\"sequences\": %d, ", ticks.sequences);
+        print_stat_json(fp, "tick_jitter_ms", &ticks.jitter_ms);
+        fprintf(fp, ", \"worst_drift_ms\": %.3f},\n \"melody\": {\"melodies\": %d, ", ticks.worst_drift_ms,
+                melody.melodies);
+        print_stat_json(fp, "note_dev_ms", &melody.deviation_ms);
+        fprintf(fp, ", \"worst_drift_ms\": %.3f}}\n", melody.worst_drift_ms);
+    } else {
+        fprintf(fp, "=== 모의 wiringPi 보고서 ===\n");
+        fprintf(fp, "기록 %d개 (버퍼 초과로 버림 %lu개), PWM 범위 초과 쓰기 %lu회, PWM 주파수 %.1fHz\n\n", n, dropped,
+                pwm_clamped, carrier);
+        if (virtual_time) {
+            fprintf(fp, "가상 시간 %.1fs 경과 (실제 %.1fs), 데드라인 이동 %lu회\n\n", (now_ns() - start_ns) / 1e9,
+                    (real_ns() - start_ns) / 1e9, virtual_jumps);
+        }
+        fprintf(fp, "[핀별 쓰기 횟수]\n");
+        for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+            if (pin_writes[pin] > 0) fprintf(fp, "  %2d %-9s %lu\n", pin, pin_name(pin), pin_writes[pin]);
+        }
+        fprintf(fp, "\n[PWM 듀티] (간격 편차는 중앙값 기준 ms)\n");
+        for (int i = 0; i < pwm_count; i++) {
+            fprintf(fp, "  %2d %-9s 변경 %lu회, 간격 중앙값 %.2fms, 편차 p50 %.2f p99 %.2f 최대 %.2f\n", pwm[i].pin,
+                    pin_name(pwm[i].pin), pwm[i].updates, pwm[i].median_interval_ms, pwm[i].interval_ms.p50,
+                    pwm[i].interval_ms.p99, pwm[i].interval_ms.max);
+            fprintf(fp, "     시간 가중 듀티 %.2f%%, 단순 평균 %.2f%%, 오차 %+.2f%%p\n", pwm[i].duty_time_pct,
+                    pwm[i].duty_sample_pct, pwm[i].duty_time_pct - pwm[i].duty_sample_pct);
+        }
+        fprintf(fp, "\n[카운트다운 틱] 카운트다운 %d회, 틱 %d개\n", ticks.sequences, ticks.jitter_ms.n);
+        fprintf(fp, "  |간격-1000ms| 평균 %.2f p50 %.2f p99 %.2f 최대 %.2f ms, 최대 누적 지연 %.2fms\n",
+                ticks.jitter_ms.mean, ticks.jitter_ms.p50, ticks.jitter_ms.p99, ticks.jitter_ms.max,
+                ticks.worst_drift_ms);
+        fprintf(fp, "\n[멜로디 음 길이] 멜로디 %d회, 음 간격 %d개\n", melody.melodies, melody.deviation_ms.n);
+        fprintf(fp, "  |간격-기준| 평균 %.2f p50 %.2f p99 %.2f 최대 %.2f ms, 최대 누적 편차 %.2fms\n",
+                melody.deviation_ms.mean, melody.deviation_ms.p50, melody.deviation_ms.p99, melody.deviation_ms.max,
+                melody.worst_drift_ms);
+    }
+    fclose(fp);
+    free(entries);
+}
+
+static void write_trace(const char* path) {
+    int n = 0;
+    unsigned long dropped = 0;
+    trace_entry_t* entries = trace_snapshot(&n, &dropped);
+    FILE* fp = entries ? fopen(path, "w") : NULL;
+
+    if (fp) {
+        fprintf(fp, "# ts_ns pin kind value (버림 %lu개)\n", dropped);
+        for (int i = 0; i < n; i++) {
+            fprintf(fp, "%lld %d %s %d\n", entries[i].ts_ns, entries[i].pin, trace_kind_names[entries[i].kind],
+                    entries[i].value);
+        }
+        fclose(fp);
+    }
+    free(entries);
+}
+
+__attribute__((constructor)) static void sim_init(void) {
+    const char* script = getenv("SIM_ADC_SCRIPT");
+    const char* noise = getenv("SIM_ADC_NOISE");
+
+    start_ns = real_ns();
+    for (int pin = 0; pin < SIM_MAX_PINS; pin++) pin_value[pin] = -1;
+    if (script) adc_load_script(script);
+    if (noise) adc_noise = atoi(noise);
+    pwm_sysfs_setup(getenv("SIM_BUZZER_PWM") && atoi(getenv("SIM_BUZZER_PWM")) > 0);
+    if (getenv("SIM_VIRTUAL_TIME") && atoi(getenv("SIM_VIRTUAL_TIME")) > 0) virtual_time_start();
+}
+
+// 마지막 장치 라이브러리가 dlclose 될 때 (또는 프로세스 종료 때) 실행
+// 서버는 _exit 로 끝나므로 보고서는 여기서 써야 함
+__attribute__((destructor)) static void sim_fini(void) {
+    const char* report = getenv("SIM_REPORT");
+    const char* trace_path = getenv("SIM_TRACE");
+
+    // 코드가 내려가기 전에 I2C 장치 스레드와 softTone 스레드 정리 (상대편이 닫지 않았어도 recv 를 깨움)
+    for (int i = 0; i < i2c_device_count; i++) {
+        shutdown(i2c_devices[i].fd, SHUT_RDWR);
+        pthread_join(i2c_devices[i].tid, NULL);
+        close(i2c_devices[i].fd);
+    }
+    i2c_device_count = 0;
+    for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+        if (tone_threads[pin].active) softToneStop(pin);
+    }
+    virtual_time_stop();
+
+    if (report) write_report(report);
+    if (trace_path) write_trace(trace_path);
+}
@@ -2,13 +2,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
 #include <sys/socket.h>
 #include <time.h>
 #include "web_server.h"
 
 // HTTP 응답 전송 함수
 void send_http_response(int client_fd, const char* status, const char* content_type, const char* body) {
-    char response[4096];
+    char response[8192];
     int content_length = strlen(body);
     
     snprintf(response, sizeof(response),
@@ -47,8 +48,8 @@ char* read_html_file(const char* filename) {
 
 // JSON 응답 생성
 void send_json_response(int client_fd, const char* command, const char* response) {
-    char json_body[2048];
-    char escaped_response[1024];
+    char json_body[MAX_RESPONSE_SIZE * 2 + 512];
+    char escaped_response[MAX_RESPONSE_SIZE * 2];
     
     // 응답에서 특수문자 이스케이프
     int j = 0;
@@ -78,6 +79,106 @@ void send_json_response(int client_fd, const char* command, const char* response
     send_http_response(client_fd, "200 OK", "application/json", json_body);
 }
 
+// 쿼리 문자열에서 key 값 추출 (없으면 -1)
+static int get_query_param(const char* query, const char* key, char* out, int size) {
+    int key_len = strlen(key);
+    const char* p = query;
+    while (p && *p) {
+        if (strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+            p += key_len + 1;
+            int len = strcspn(p, "&");
+            if (len >= size) return -1;
+            memcpy(out, p, len);
+            out[len] = '\0';
+            return 0;
+        }
+        p = strchr(p, '&');
+        if (p) p++;
+    }
+    return -1;
+}
+
+// 이력 스트리밍 상태: 매핑된 레코드를 JSON 항목으로 바꿔 버퍼가 차면 바로 전송
+typedef struct {
+    int client_fd;
+    int started;
+    int count;
+    int len;
+    int failed;                  // 전송 실패 (클라이언트가 끊음), 남은 레코드는 건너뜀
+    char buf[4096];
+} history_stream_t;
+
+// 끊긴 소켓에 보내도 SIGPIPE 로 서버가 죽지 않게 MSG_NOSIGNAL, 실패하면 failed 표시
+static void history_stream_send(history_stream_t* st, const char* data, int len) {
+    while (!st->failed && len > 0) {
+        int sent = send(st->client_fd, data, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            st->failed = 1;
+            break;
+        }
+        data += sent;
+        len -= sent;
+    }
+}
+
+static void history_stream_flush(history_stream_t* st) {
+    if (!st->started) {
+        const char* head =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/json\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "Connection: close\r\n"
+            "\r\n"
+            "{\"points\":[";
+        history_stream_send(st, head, strlen(head));
+        st->started = 1;
+    }
+    if (st->len > 0) {
+        history_stream_send(st, st->buf, st->len);
+        st->len = 0;
+    }
+}
+
+static int history_stream_visit(const sensor_record_t* rec, void* ctx) {
+    history_stream_t* st = ctx;
+    if (st->len + 64 > (int)sizeof(st->buf)) {
+        history_stream_flush(st);
+        if (st->failed) return 1;    // 조회 중단
+    }
+    st->len += snprintf(st->buf + st->len, sizeof(st->buf) - st->len, "%s[%lld,%d,%d,%d]",
+                        st->count ? "," : "", rec->ts_s * 1000LL + rec->ts_ms, rec->avg, rec->min, rec->max);
+    st->count++;
+    return 0;
+}
+
+// GET /api/history?from=-1h&to=now&res=1m : [ts_ms, 평균, 최소, 최대] 배열을 스트리밍 (Content-Length 없이 연결 종료로 끝)
+static void handle_history_request(int client_fd, const char* query) {
+    char from[32], to[32], res[8];
+    history_stream_t st = {client_fd, 0, 0, 0, 0, {0}};
+    int tier;
+
+    if (get_query_param(query, "from", from, sizeof(from)) < 0) strcpy(from, "-1h");
+    if (get_query_param(query, "to", to, sizeof(to)) < 0) strcpy(to, "now");
+    if (get_query_param(query, "res", res, sizeof(res)) < 0) strcpy(res, "auto");
+
+    int count = history_query(from, to, res, &tier, history_stream_visit, &st);
+    if (count < 0 && !st.started) {
+        send_http_response(client_fd, "400 Bad Request", "application/json",
+                           "{\"error\":\"from/to: now, -30m, -2h, -7d, epoch 초 / res: raw, 1s, 1m, 1h, auto\"}");
+        return;
+    }
+
+    history_stream_flush(&st);
+    st.len = snprintf(st.buf, sizeof(st.buf), "],\"tier\":\"%s\",\"count\":%d}", history_tier_name(tier), st.count);
+    history_stream_flush(&st);
+    if (st.failed) {
+        write_log("이력 전송 중단 (클라이언트 연결 끊김): %s ~ %s, %d개째에서 멈춤", from, to, st.count);
+        return;
+    }
+    write_log("이력 전송: %s ~ %s (%s) %d개", from, to, history_tier_name(tier), st.count);
+}
+
 // HTTP 요청인지 확인
 int is_http_request(const char* buffer) {
     return (strncmp(buffer, "GET ", 4) == 0 || 
@@ -117,6 +218,11 @@ void handle_http_request(int client_fd, char* request) {
     }
     
     // API 명령 처리
+    if (strcmp(method, "GET") == 0 && strncmp(path, "/api/history", 12) == 0 && (path[12] == '\0' || path[12] == '?')) {
+        handle_history_request(client_fd, path[12] ? path + 13 : "");
+        return;
+    }
+
     if (strcmp(method, "POST") == 0 && strcmp(path, "/api/command") == 0) {
         char* body_start = strstr(request, "\r\n\r\n");
         if (body_start) {
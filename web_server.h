@@ -13,5 +13,7 @@ int is_http_request(const char* buffer);
 // 외부에서 필요한 함수들
 extern int process_command(const char* command, char* response, int response_size);
 extern void write_log(const char* format, ...);
+extern int history_query(const char* from, const char* to, const char* res, int* tier, sensor_visit_fn visit, void* ctx);
+extern const char* history_tier_name(int tier);
 
 #endif